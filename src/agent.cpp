@@ -25,6 +25,7 @@
  *                                                                           *
  ****************************************************************************/
 
+#include <algorithm>
 #include <cmath>
 #include <random>
 #include "agent.h"
@@ -38,7 +39,9 @@ Agent::Agent(bool in_verbose, double x_0, double y_0) : Object(x_0, y_0, 0.0){
 	heading.to(randuu(-M_PI, M_PI));		// random initial orientation
 	speed = 0.1;
 
+	control = nullptr;
 	innate_lm_control = 0.0;
+	control_output = 0.0;
 	diff_heading.to(0.0);
 	external = new Angle(0.0);
 
@@ -55,6 +58,36 @@ Controller* Agent::c(){
 	return control;
 }
 
+void Agent::checkpoint(Checkpoint& cp, const vector<Angle*>& pipe_angle){
+	/// the external angle is either the angle of a pipe (stored by index) or owned by the agent
+	int pipe = int(find(pipe_angle.begin(), pipe_angle.end(), external) - pipe_angle.begin());
+	if(pipe == int(pipe_angle.size()))
+		pipe = -1;
+	Angle ext = *external;
+	cp.io(pos);
+	cp.pod(heading);
+	cp.pod(speed);
+	cp.pod(diff_heading);
+	cp.pod(diff_speed);
+	cp.pod(pipe);
+	cp.pod(ext);
+	cp.pod(control_output);
+	cp.pod(innate_lm_control);
+	cp.pod(in_pipe);
+	cp.pod(lm_catch);
+	cp.pod(inward);
+	cp.pod(t_step);
+	if(!cp.save()){
+		if(pipe >= 0 && pipe < int(pipe_angle.size()))
+			set_dphi(pipe_angle.at(pipe));
+		else if(find(pipe_angle.begin(), pipe_angle.end(), external) != pipe_angle.end())
+			set_dphi(new Angle(ext));
+		else
+			*external = ext;
+	}
+	control->checkpoint(cp);
+}
+
 Angle Agent::dphi(){
 	return diff_heading;
 }
@@ -93,7 +126,7 @@ PIN* Agent::pi(){
 
 void Agent::reset(){
 	to(0.,0.);
-	heading.to(randuu(-M_PI, M_PI));
+	heading.to(control->rng()->uniform(-M_PI, M_PI));
 	inward = false;
 	in_pipe = false;
 	lm_catch = false;
@@ -122,6 +155,12 @@ void Agent::to(double x_new, double y_new){
 }
 
 void Agent::update(double _reward, vec _lmr){
+	begin_update();
+	control->integrate();
+	end_update(_reward, _lmr);
+}
+
+void Agent::begin_update(){
 	t_step++;
 	//control->set_inward(inward);
 	if(VERBOSE && t_step%100==0)
@@ -149,9 +188,17 @@ void Agent::update(double _reward, vec _lmr){
 
 	move(dt * speed * heading.C(), dt * speed * heading.S(), 0.0);
 
-	control_output = control->update(heading.rad(), speed, _reward, _lmr, 0);
+	control->begin_update(heading.rad(), speed);
+}
+
+void Agent::end_update(double _reward, const vec& _lmr){
+	control_output = control->end_update(heading.rad(), speed, _reward, _lmr, 0);
 }
 
 double Agent::s(){
 	return speed;
 }
+
+double Agent::step_length(){
+	return dt * fabs(speed);
+}
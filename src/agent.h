@@ -79,6 +79,15 @@ public:
 	 */
 	Controller* c();
 
+	/**
+	 * Writes or reads the state of the agent and its controller
+	 *
+	 * @param (Checkpoint&) cp: snapshot file
+	 * @param (vector<Angle*>) pipe_angle: pipe angles of the environment (an agent in a pipe is steered by one of them)
+	 * @return (void)
+	 */
+	void checkpoint(Checkpoint& cp, const vector<Angle*>& pipe_angle);
+
 	/**
 	 * Return the landmark attraction difference in heading direction of the agent
 	 *
@@ -157,6 +166,13 @@ public:
 	 */
 	double s();
 
+	/**
+	 * Returns the maximum distance the agent moves in one update
+	 *
+	 * @return (double)
+	 */
+	double step_length();
+
 	/**
 	 * Sets the difference in heading direction of the agent
 	 *
@@ -221,6 +237,22 @@ public:
 	 */
 	void update(double _reward, vec _lmr);
 
+	/**
+	 * First step of update: moves the agent and feeds the sensory input to the controller
+	 *
+	 * @return (void)
+	 */
+	void begin_update();
+
+	/**
+	 * Last step of update: computes the motor command of the next step (after the PI network is integrated)
+	 *
+	 * @param (double) _reward: reward from environment
+	 * @param (vec) _lmr: landmark recognition from environment
+	 * @return (void)
+	 */
+	void end_update(double _reward, const vec& _lmr);
+
 	//************ Public class parameters ************//
 
 	bool in_pipe;			// status if agent is in pipe [TRUE = agent is in a pipe; FALSE = it's free!]
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ *  batch.h                                                                  *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <sys/stat.h>
+using namespace std;
+
+
+/**
+ * Batch Instance
+ *
+ * 	Index, RNG seed and output directory of one simulation instance
+ *
+ */
+
+struct BatchInstance {
+	int index;								// instance index (0..n-1)
+	uint64_t seed;							// master seed (Simulation::seed)
+	string dir;								// output directory (Simulation out_dir)
+};
+
+
+/**
+ * Batch Runner Class
+ *
+ * 	This class runs independent simulation instances (cycles, parameter
+ * 	values) on a pool of worker threads. Every instance gets its own
+ * 	output directory (<root>/<index>/ with data/, data/mat/ and save/)
+ * 	and its own master seed derived from the batch seed, so results do
+ * 	not depend on the number of threads. Instances are dealt round-robin
+ * 	to per-worker queues; idle workers steal from the others. Results are
+ * 	returned in instance order, so statistics merged from them are the
+ * 	same as for a sequential loop.
+ *
+ */
+
+class BatchRunner {
+public:
+
+	/**
+	 * Constructor
+	 *
+	 *  @param (string) _root: directory of the instance directories (default: "data/batch/")
+	 *  @param (uint64_t) _seed: batch seed, instance seeds are derived from it (default: 5489)
+	 *  @param (int) _threads: number of worker threads, 0 = all cores (default: 0)
+	 */
+	BatchRunner(const string& _root = "data/batch/", uint64_t _seed = 5489u, int _threads = 0){
+		root = _root;
+		if(!root.empty() && root[root.size()-1] != '/')
+			root += '/';
+		batch_seed = _seed;
+		threads = (_threads > 0) ? _threads : int(thread::hardware_concurrency());
+		if(threads < 1)
+			threads = 1;
+	};
+
+	/**
+	 * Returns the number of worker threads
+	 *
+	 *  @return (int)
+	 */
+	int num_threads(){
+		return threads;
+	};
+
+	/**
+	 * Returns index, seed and output directory of an instance and creates its directories
+	 *
+	 *  @param (int) index: instance index
+	 *  @return (BatchInstance)
+	 */
+	BatchInstance instance(int index){
+		BatchInstance inst;
+		char name[32];
+		snprintf(name, sizeof(name), "%04d/", index);
+		inst.index = index;
+		inst.seed = derive_seed(index);
+		inst.dir = root + name;
+		make_dir(root);
+		make_dir(inst.dir);
+		make_dir(inst.dir + "data/");
+		make_dir(inst.dir + "data/mat/");
+		make_dir(inst.dir + "save/");
+		return inst;
+	};
+
+	/**
+	 * Runs job(instance) for n instances and returns the results in instance order.
+	 * An exception thrown by a job is rethrown after all workers have finished.
+	 *
+	 *  @param (int) n: number of instances
+	 *  @param (Job) job: callable Result(const BatchInstance&), creates, runs and deletes one Simulation
+	 *  @return (vector<Result>)
+	 */
+	template<typename Job>
+	vector<typename result_of<Job(const BatchInstance&)>::type> run(int n, Job job){
+		typedef typename result_of<Job(const BatchInstance&)>::type Result;
+		vector<Result> results(n);
+		vector<BatchInstance> instances(n);
+		for(int i = 0; i < n; i++)
+			instances[i] = instance(i);
+
+		int num_workers = (threads < n) ? threads : n;
+		vector<WorkQueue> queues(num_workers);
+		for(int i = 0; i < n; i++)
+			queues[i % num_workers].jobs.push_back(i);
+
+		exception_ptr error;
+		mutex error_lock;
+		auto worker = [&](int w){
+			int i;
+			while(next_job(queues, w, i)){
+				try{
+					results[i] = job(instances[i]);
+				}
+				catch(...){
+					lock_guard<mutex> lock(error_lock);
+					if(!error)
+						error = current_exception();
+				}
+			}
+		};
+		vector<thread> pool;
+		for(int w = 1; w < num_workers; w++)
+			pool.push_back(thread(worker, w));
+		if(num_workers > 0)
+			worker(0);
+		for(unsigned int w = 0; w < pool.size(); w++)
+			pool[w].join();
+		if(error)
+			rethrow_exception(error);
+		return results;
+	};
+
+private:
+
+	struct WorkQueue {
+		mutex lock;
+		deque<int> jobs;
+	};
+
+	/**
+	 * Takes the next instance from the own queue (back) or steals from another queue (front)
+	 */
+	static bool next_job(vector<WorkQueue>& queues, int w, int& i){
+		{
+			lock_guard<mutex> lock(queues[w].lock);
+			if(!queues[w].jobs.empty()){
+				i = queues[w].jobs.back();
+				queues[w].jobs.pop_back();
+				return true;
+			}
+		}
+		for(unsigned int k = 1; k < queues.size(); k++){
+			WorkQueue& victim = queues[(w + k) % queues.size()];
+			lock_guard<mutex> lock(victim.lock);
+			if(!victim.jobs.empty()){
+				i = victim.jobs.front();
+				victim.jobs.pop_front();
+				return true;
+			}
+		}
+		return false;
+	};
+
+	/**
+	 * Seed of instance i (splitmix64 of the batch seed and the index)
+	 */
+	uint64_t derive_seed(int i){
+		uint64_t z = batch_seed + (uint64_t(i) + 1) * 0x9e3779b97f4a7c15ULL;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	};
+
+	static void make_dir(const string& dir){
+		mkdir(dir.c_str(), 0755);
+	};
+
+	string root;                                    // Directory of the instance directories
+	uint64_t batch_seed;                            // Seed of the batch
+	int threads;                                    // Number of worker threads
+};
+
+
+#endif /* BATCH_H_ */
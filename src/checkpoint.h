@@ -0,0 +1,301 @@
+/*****************************************************************************
+ *  checkpoint.h                                                             *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <armadillo>
+#include "geom.h"
+using namespace arma;
+using namespace std;
+
+
+/**
+ * Checkpoint Class
+ *
+ * 	This class is one binary snapshot (a file or a stream in memory),
+ * 	opened either for saving or for loading. Every class with state writes and reads it in the same
+ * 	function (checkpoint(Checkpoint&)), so that both directions always
+ * 	visit the same members in the same order. Values are stored as raw
+ * 	bytes (native byte order), so that a restored run continues bit-exactly.
+ *
+ * 	Only state that changes while the simulation runs is stored; the
+ * 	structure (agents, network sizes, options, goals and landmarks) is
+ * 	rebuilt by the same setup code before loading. Structural sizes are
+ * 	stored with check() and compared on loading.
+ *
+ * 	Layout: "NAVICKP1", int64 version, int64 sizeof(running_stat), then the
+ * 	values in visiting order
+ *
+ */
+
+class Checkpoint {
+public:
+
+	/**
+	 * Constructor. Opens the snapshot file and writes or checks the file header
+	 *
+	 *  @param (string) filename: snapshot file
+	 *  @param (bool) _saving: true, if the state is written (false: read)
+	 */
+	Checkpoint(const string& filename, bool _saving){
+		saving = _saving;
+		ok = true;
+		stream = &file;
+		file.open(filename.c_str(), (saving ? ios::out : ios::in) | ios::binary);
+		if(!file.is_open()){
+			fail("cannot open file");
+			return;
+		}
+		header();
+	};
+
+	/**
+	 * Constructor. Writes the snapshot into or reads it from a stream in memory
+	 * (e.g., a stringstream to copy a simulation)
+	 *
+	 *  @param (iostream&) _stream: snapshot stream
+	 *  @param (bool) _saving: true, if the state is written (false: read)
+	 */
+	Checkpoint(iostream& _stream, bool _saving){
+		saving = _saving;
+		ok = true;
+		stream = &_stream;
+		header();
+	};
+
+	/**
+	 * Returns true, if the state is written (false: read)
+	 *
+	 *  @return (bool)
+	 */
+	bool save() const {
+		return saving;
+	};
+
+	/**
+	 * Returns true, if no error occurred so far
+	 *
+	 *  @return (bool)
+	 */
+	bool good() const {
+		return ok && bool(*stream);
+	};
+
+	/**
+	 * Writes or compares a structural size (loading fails on a mismatch)
+	 *
+	 *  @param (long) value: size in the current setup
+	 *  @param (const char*) what: name printed on a mismatch
+	 *  @return (void)
+	 */
+	void check(long value, const char* what){
+		int64_t stored = value;
+		raw(&stored, sizeof(stored));
+		if(stored != value)
+			fail(what);
+	};
+
+	/**
+	 * Writes or reads a plain value (numbers, Angle, ...) without padding bytes
+	 *
+	 *  @param (T&) value: trivially copyable value
+	 *  @return (void)
+	 */
+	template<class T>
+	void pod(T& value){
+		static_assert(std::is_trivially_copyable<T>::value, "checkpoint of non-trivial type");
+		raw(&value, sizeof(T));
+	};
+
+	/**
+	 * Writes or reads a vector or matrix; the memory is kept, if the size
+	 * is unchanged (e.g., layers bound to a batch)
+	 *
+	 *  @param (mat&) m: vector or matrix
+	 *  @return (void)
+	 */
+	void io(mat& m){
+		uint64_t rows = m.n_rows;
+		uint64_t cols = m.n_cols;
+		raw(&rows, sizeof(rows));
+		raw(&cols, sizeof(cols));
+		if(!ok)
+			return;
+		if(!saving && (rows != m.n_rows || cols != m.n_cols))
+			m.set_size(rows, cols);
+		raw(m.memptr(), rows*cols*sizeof(double));
+	};
+
+	/**
+	 * Writes or reads a vector (coordinates and lock, no padding bytes)
+	 *
+	 *  @param (Vec&) v: vector
+	 *  @return (void)
+	 */
+	void io(Vec& v){
+		bool locked = v.lock();
+		pod(v.x);
+		pod(v.y);
+		pod(v.z);
+		pod(locked);
+		if(!saving)
+			v.lock(locked);
+	};
+
+	/**
+	 * Writes or reads a list of vectors
+	 *
+	 *  @param (vector<Vec>&) v: list of vectors
+	 *  @return (void)
+	 */
+	void io(vector<Vec>& v){
+		uint64_t n = v.size();
+		raw(&n, sizeof(n));
+		if(!ok)
+			return;
+		if(!saving)
+			v.resize(n);
+		for(uint64_t i = 0; i < n; i++)
+			io(v[i]);
+	};
+
+	/**
+	 * Writes or reads a vector of plain values
+	 *
+	 *  @param (vector<T>&) v: vector
+	 *  @return (void)
+	 */
+	template<class T>
+	void io(vector<T>& v){
+		static_assert(std::is_trivially_copyable<T>::value, "checkpoint of non-trivial type");
+		uint64_t n = v.size();
+		raw(&n, sizeof(n));
+		if(!ok)
+			return;
+		if(!saving)
+			v.resize(n);
+		if(n > 0)
+			raw(&v[0], n*sizeof(T));
+	};
+
+	/**
+	 * Writes or reads a vector of vectors of plain values
+	 *
+	 *  @param (vector<vector<T> >&) v: vector
+	 *  @return (void)
+	 */
+	template<class T>
+	void io(vector<vector<T> >& v){
+		uint64_t n = v.size();
+		raw(&n, sizeof(n));
+		if(!ok)
+			return;
+		if(!saving)
+			v.resize(n);
+		for(uint64_t i = 0; i < n && ok; i++)
+			io(v[i]);
+	};
+
+	/**
+	 * Writes or reads running statistics as raw bytes: running_stat holds only
+	 * numbers, but is not formally trivially copyable (its size is checked in
+	 * the file header)
+	 *
+	 *  @param (running_stat<double>&) stat: running statistics
+	 *  @return (void)
+	 */
+	void io(running_stat<double>& stat){
+		raw(&stat, sizeof(stat));
+	};
+
+	/**
+	 * Writes or reads a vector of flags
+	 *
+	 *  @param (vector<bool>&) v: vector
+	 *  @return (void)
+	 */
+	void io(vector<bool>& v){
+		vector<char> flags(v.begin(), v.end());
+		io(flags);
+		if(!saving)
+			v.assign(flags.begin(), flags.end());
+	};
+
+private:
+
+	/**
+	 * Writes or checks the file header
+	 */
+	void header(){
+		char magic[8] = {'N','A','V','I','C','K','P','1'};
+		char tag[8];
+		for(int i = 0; i < 8; i++)
+			tag[i] = magic[i];
+		raw(tag, sizeof(tag));
+		for(int i = 0; i < 8; i++)
+			if(tag[i] != magic[i]){
+				fail("not a checkpoint file");
+				return;
+			}
+		check(version, "version");
+		check(sizeof(running_stat<double>), "running_stat layout");
+	};
+
+	void raw(void* data, size_t bytes){
+		if(!ok || bytes == 0)
+			return;
+		if(saving)
+			stream->write((const char*) data, bytes);
+		else
+			stream->read((char*) data, bytes);
+		if(!*stream)
+			fail("unexpected end of file");
+	};
+
+	void fail(const char* what){
+		if(ok)
+			printf("WARNING: Checkpoint %s (%s).\n", saving ? "not written" : "not loaded", what);
+		ok = false;
+	};
+
+	static const int32_t version = 2;
+
+	fstream file;                                   // snapshot file (if opened by name)
+	iostream* stream;                               // file or stream in memory
+	bool saving;                                    // true = write, false = read
+	bool ok;                                        // no error so far
+};
+
+
+#endif /* CHECKPOINT_H_ */
@@ -28,16 +28,258 @@
 #ifndef CIRCULARARRAY_H_
 #define CIRCULARARRAY_H_
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <new>
+#include <vector>
 #include <armadillo>
-#include <boost/random.hpp>
-#include <boost/random/normal_distribution.hpp>
-#include <boost/random/uniform_real.hpp>
 #include "geom.h"
+#include "rng.h"
 using namespace arma;
 using namespace std;
 
 
+/*** Kernel implementations ***/
+enum{dense_kernel, lowrank_kernel, circulant_kernel, auto_kernel};
+
+/**
+ * Circulant Kernel Class
+ *
+ * 	This class applies a translation-invariant weight kernel
+ * 	w(i,j) = c((i-j) mod N) between two circular arrays of N neurons
+ * 	with evenly spaced preferred angles. The product is computed either
+ * 	densely (O(N^2)), from the few non-zero Fourier modes of the
+ * 	profile c (low-rank, O(rN)), or by FFT convolution (O(N log N)).
+ *
+ */
+
+class CircKernel {
+public:
+
+	/**
+	 * Constructor
+	 *
+	 *  @param (vec) _profile: kernel profile c(d) = w(d,0), d = 0..N-1 (default: empty)
+	 *  @param (int) _type: kernel implementation (default: auto_kernel)
+	 */
+	CircKernel(vec _profile = vec(), int _type = auto_kernel){
+		N = _profile.n_elem;
+		profile = _profile;
+		num_modes = 0;
+		if(N == 0){
+			type = dense_kernel;
+			return;
+		}
+
+		/// real Fourier coefficients of the profile (c(d) = a_0 + sum_k a_k cos(k phi_d) + b_k sin(k phi_d))
+		int kmax = N/2;
+		vec a = zeros<vec>(kmax+1);
+		vec b = zeros<vec>(kmax+1);
+		for(int k = 0; k <= kmax; k++){
+			for(int d = 0; d < N; d++){
+				a(k) += profile(d) * cos(2. * M_PI * ((k*d) % N) / N);
+				b(k) += profile(d) * sin(2. * M_PI * ((k*d) % N) / N);
+			}
+			double norm = (k == 0 || 2*k == N) ? 1./N : 2./N;
+			a(k) *= norm;
+			b(k) *= norm;
+		}
+		if(N%2 == 0)
+			b(kmax) = 0.;				// Nyquist mode has no sine component
+
+		/// keep only modes that carry weight
+		double amax = 0.;
+		for(int k = 0; k <= kmax; k++)
+			amax = std::max(amax, std::max(fabs(a(k)), fabs(b(k))));
+		for(int k = 0; k <= kmax; k++){
+			if(fabs(a(k)) > mode_tol*amax || fabs(b(k)) > mode_tol*amax){
+				mode.push_back(k);
+				mode_a.push_back(a(k));
+				mode_b.push_back(b(k));
+			}
+		}
+		num_modes = mode.size();
+
+		type = _type;
+		if(type == auto_kernel){
+			if(4 * rank() <= N)
+				type = lowrank_kernel;
+			else if(N >= 64)
+				type = circulant_kernel;
+			else
+				type = dense_kernel;
+		}
+
+		if(type == dense_kernel){
+			w_dense.zeros(N,N);
+			for(int i = 0; i < N; i++)
+				for(int j = 0; j < N; j++)
+					w_dense(i,j) = profile((i-j+N) % N);
+		}
+		if(type == lowrank_kernel){
+			basis_cos.zeros(N, num_modes);
+			basis_sin.zeros(N, num_modes);
+			for(int m = 0; m < num_modes; m++)
+				for(int i = 0; i < N; i++){
+					basis_cos(i,m) = cos(2. * M_PI * ((mode.at(m)*i) % N) / N);
+					basis_sin(i,m) = sin(2. * M_PI * ((mode.at(m)*i) % N) / N);
+				}
+		}
+		if(type == circulant_kernel)
+			profile_fft = fft(profile);
+	};
+
+	/**
+	 * Computes output = W * input
+	 *
+	 *  @param (const vec&) input: presynaptic rates (N)
+	 *  @param (vec&) output: postsynaptic rates (N; resized if necessary)
+	 *  @return (void)
+	 */
+	void apply(const vec& input, vec& output){
+		if(output.n_elem != N)
+			output.zeros(N);
+		if(type == dense_kernel){
+			output = w_dense * input;
+			return;
+		}
+		if(type == circulant_kernel){
+			output = real(ifft(fft(input) % profile_fft));
+			return;
+		}
+		/// low-rank: project onto each Fourier mode, then expand
+		const double* in = input.memptr();
+		double* out = output.memptr();
+		for(int i = 0; i < N; i++)
+			out[i] = 0.;
+		for(int m = 0; m < num_modes; m++){
+			const double* cs = basis_cos.colptr(m);
+			const double* sn = basis_sin.colptr(m);
+			double C = 0.;
+			double S = 0.;
+			for(int j = 0; j < N; j++){
+				C += cs[j]*in[j];
+				S += sn[j]*in[j];
+			}
+			const double a = mode_a.at(m);
+			const double b = mode_b.at(m);
+			for(int i = 0; i < N; i++)
+				out[i] += a*(cs[i]*C + sn[i]*S) + b*(sn[i]*C - cs[i]*S);
+		}
+	};
+
+	/**
+	 * Computes output = W * input for every column (e.g., one column per agent).
+	 * Each column gets the same arithmetic as apply(); the low-rank projection
+	 * runs over all columns at once.
+	 *
+	 *  @param (const mat&) input: presynaptic rates (N x A)
+	 *  @param (mat&) output: postsynaptic rates (N x A, same size as input)
+	 *  @return (void)
+	 */
+	void apply_cols(const mat& input, mat& output){
+		const int A = input.n_cols;
+		if(type != lowrank_kernel){
+			for(int a = 0; a < A; a++){
+				const vec in(const_cast<double*>(input.colptr(a)), N, false, true);
+				vec out(output.colptr(a), N, false, true);
+				apply(in, out);
+			}
+			return;
+		}
+		proj_cos.zeros(A);
+		proj_sin.zeros(A);
+		double* C = proj_cos.memptr();
+		double* S = proj_sin.memptr();
+		double* out = output.memptr();
+		const double* in = input.memptr();
+		for(int k = 0; k < N*A; k++)
+			out[k] = 0.;
+		for(int m = 0; m < num_modes; m++){
+			const double* cs = basis_cos.colptr(m);
+			const double* sn = basis_sin.colptr(m);
+			for(int a = 0; a < A; a++){
+				C[a] = 0.;
+				S[a] = 0.;
+			}
+			for(int j = 0; j < N; j++)
+				for(int a = 0; a < A; a++){
+					C[a] += cs[j]*in[j + a*N];
+					S[a] += sn[j]*in[j + a*N];
+				}
+			const double ma = mode_a.at(m);
+			const double mb = mode_b.at(m);
+			for(int a = 0; a < A; a++){
+				double* col = out + a*N;
+				for(int i = 0; i < N; i++)
+					col[i] += ma*(cs[i]*C[a] + sn[i]*S[a]) + mb*(sn[i]*C[a] - cs[i]*S[a]);
+			}
+		}
+	};
+
+	/**
+	 * Returns the dense weight matrix of the kernel
+	 *
+	 *  @return (mat)
+	 */
+	mat dense(){
+		mat w = zeros<mat>(N,N);
+		for(int i = 0; i < N; i++)
+			for(int j = 0; j < N; j++)
+				w(i,j) = profile((i-j+N) % N);
+		return w;
+	};
+
+	/**
+	 * Returns the number of real basis vectors spanned by the kernel
+	 *
+	 *  @return (int)
+	 */
+	int rank(){
+		int r = 0;
+		for(int m = 0; m < num_modes; m++)
+			r += (mode.at(m) == 0 || 2*mode.at(m) == N) ? 1 : 2;
+		return r;
+	};
+
+	int type;                                       // dense_kernel, lowrank_kernel or circulant_kernel
+
+private:
+	int N;                                          // Number of neurons
+	vec profile;                                    // Kernel profile c(d)
+	static constexpr double mode_tol = 1e-12;       // Relative weight below which a Fourier mode is dropped
+
+	mat w_dense;                                    // Dense weights (dense_kernel)
+	int num_modes;                                  // Number of non-zero Fourier modes
+	vector<int> mode;                               // Wave numbers of non-zero modes
+	vector<double> mode_a;                          // Cosine coefficients of non-zero modes
+	vector<double> mode_b;                          // Sine coefficients of non-zero modes
+	mat basis_cos;                                  // cos(k phi_i) per mode (lowrank_kernel)
+	mat basis_sin;                                  // sin(k phi_i) per mode (lowrank_kernel)
+	cx_vec profile_fft;                             // Spectrum of the profile (circulant_kernel)
+	vec proj_cos;                                   // Scratch: cosine projections per column (apply_cols)
+	vec proj_sin;                                   // Scratch: sine projections per column (apply_cols)
+};
+
+/**
+ * Population Code
+ *
+ * 	Quantities decoded from one activity profile of a circular array
+ * 	in a single sweep (see CircArray::decode)
+ *
+ */
+
+struct PopulationCode {
+	Angle avg;                                      // Vector average of all neurons (vector_avg)
+	Angle pva;                                      // Population vector average of the active bump (pva_angle)
+	Angle bump;                                     // Same as pva, not guarded against an empty bump (update_piavg)
+	double len;                                     // Vector length (pva_len)
+	double max_rate;                                // Rate of maximum-firing neuron
+	int max_index;                                  // Index of maximum-firing neuron
+	Angle max;                                      // Preferred angle of maximum-firing neuron (update_max)
+};
+
 /**
  * Circular Array Class
  *
@@ -60,8 +302,13 @@ public:
 		N = num_neurons;
 		K = input_dim;
 		preferred_angle.zeros(N);
-		for(unsigned int i = 0; i < N; i++)
+		cos_preferred.zeros(N);
+		sin_preferred.zeros(N);
+		for(unsigned int i = 0; i < N; i++){
 			preferred_angle(i) = 2. * M_PI * i / N; // Preferred angle of neurons
+			cos_preferred(i) = cos(preferred_angle(i));
+			sin_preferred(i) = sin(preferred_angle(i));
+		}
 		//cout << preferred_angle << endl;
 		max_rate = 0.0;
 		max_angle.resize(K);
@@ -69,7 +316,7 @@ public:
 		length.resize(K);
 		threshold = 0.;
 		type = 0;
-		seed = 0;
+		rng = &own_rng;
 
 		output_rate.zeros(N);
 		input_rate.zeros(K);
@@ -117,6 +364,16 @@ public:
 		return w_cos;
 	};
 
+	/**
+	 * Returns cosine kernel as circulant operator (implementation chosen by rank and size)
+	 *
+	 *  @param (int) _type: kernel implementation (default: auto_kernel)
+	 *  @return (CircKernel)
+	 */
+	CircKernel cos_kernel_op(int _type = auto_kernel){
+		return CircKernel(cos(preferred_angle), _type);
+	};
+
 	/**
 	 * Returns Gaussian noise with given width
 	 *
@@ -124,32 +381,29 @@ public:
 	 *  @return (double)
 	 */
 	double noise(double width){
-		if(width > 0.0){
-		    std::random_device rd;
-		    std::mt19937 gen(rd());
-			static normal_distribution<double> d(0., width);
-			return d(rd);
-		}
+		if(width > 0.0)
+			return rng->normal(0.0, width);
 		else
 			return 0.;
 	};
-	double boost_noise(double width){
-		boost::mt19937 rng; // I don't seed it on purpouse (it's not relevant)
 
-		rng.seed((++seed) + time(NULL));
-		boost::normal_distribution<> nd(0.0, width);
-		boost::variate_generator<boost::mt19937&,
-		boost::normal_distribution<> > var_nor(rng, nd);
-		return var_nor();
+	/**
+	 * Returns Gaussian noise with given width from the array's random number generator
+	 *
+	 *  @param (double) width: standarad deviation of the normal distribution
+	 *  @return (double)
+	 */
+	double boost_noise(double width){
+		return rng->normal(0.0, width);
 	}
-	double boost_unoise(){
-		boost::mt19937 rng; // I don't seed it on purpouse (it's not relevant)
 
-		rng.seed((++seed) + time(NULL));
-		boost::uniform_real<> uni_dist(0,1);
-		boost::variate_generator<boost::mt19937&,
-		boost::uniform_real<> > var_nor(rng, uni_dist);
-		return var_nor();
+	/**
+	 * Returns uniform noise in [0,1) from the array's random number generator
+	 *
+	 *  @return (double)
+	 */
+	double boost_unoise(){
+		return rng->uniform();
 	}
 
 	int num_inputs(){
@@ -203,13 +457,26 @@ public:
 		return copy;
 	};
 
+	/**
+	 * Applies the linear rectifying transfer function in place
+	 *
+	 *  @param (vec&) input: vector to be rectified
+	 *  @return (void)
+	 */
+	void lin_rect_inplace(vec& input){
+		double* mem = input.memptr();
+		for(int i = 0; i < input.n_elem; i++)
+			if(mem[i] < 0.0)
+				mem[i] = 0.0;
+	};
+
 	/**
 	 * Return the population vector average angle of maximum firing in the array
 	 *
 	 * @param (vec) input: vector
 	 * @return (double) average angle of maximum firing
 	 */
-	Angle pva_angle(vec input){
+	Angle pva_angle(const vec& input){
 		double sum_act = 0.0;
 		double output = 0.0;
 		int _start = 0;
@@ -222,9 +489,6 @@ public:
 				_start = (i+1)%N;
 		}
 
-		uword index;
-		double maxmax = input.max(index);
-
 		if(_start > _end)
 			_end+=N;
 
@@ -251,10 +515,95 @@ public:
 	 * @param (vec) input: vector
 	 * @return (double)
 	 */
-	double pva_len(vec input){
+	double pva_len(const vec& input){
 		return scale_factor * sum(input)/(N*N);
 	}
 
+	/**
+	 * Decodes an activity profile of N values in one sweep: vector average,
+	 * bump average, length and maximum (same results as vector_avg, pva_angle,
+	 * update_piavg, pva_len and update_max on the profile, without copies)
+	 *
+	 * @param (const double*) input: N values (e.g., rate memory or weight column)
+	 * @param (PopulationCode&) code: decoded quantities
+	 * @return (void)
+	 */
+	void decode(const double* input, PopulationCode& code){
+		double x = 0.;
+		double y = 0.;
+		double sum1 = 0.;                       // even/odd partial sums, summed as by accu()
+		double sum2 = 0.;
+		double max_val = -numeric_limits<double>::infinity();
+		int max_index = 0;
+		int _start = 0;
+		int _end = 0;
+		for(int i = 0; i < N; i++){
+			const double v = input[i];
+			const double next = input[(i+1 < N) ? i+1 : 0];
+			if(v > threshold && next <= threshold)
+				_end = (i+1)%N;
+			if(v <= threshold && next > threshold)
+				_start = (i+1)%N;
+			x += v*cos_preferred(i);
+			y += v*sin_preferred(i);
+			if(i & 1)
+				sum2 += v;
+			else
+				sum1 += v;
+			if(v > max_val){
+				max_val = v;
+				max_index = i;
+			}
+		}
+		code.avg = Vec(x,y).ang();
+		code.len = scale_factor * (sum1 + sum2)/(N*N);
+		code.max_rate = max_val;
+		code.max_index = max_index;
+		code.max = Angle(preferred_angle(max_index));
+
+		/// center of mass of the bump between the threshold crossings
+		if(_start > _end)
+			_end+=N;
+		double sum_act = 0.0;
+		double output = 0.0;
+		for(int i = _start; i < _end; i++){
+			output += (2*M_PI*i/N)*input[i%N];
+			sum_act += input[i%N];
+		}
+		double bump = output/sum_act;
+		if(sum_act > 0.0)
+			output /= sum_act;
+		if(VERBOSE)
+			printf("output = %g\n", output);
+		code.pva = (output > 0.) ? Angle(fmod(output, 2*M_PI)) : Angle(2*M_PI+fmod(output, 2*M_PI));
+		code.bump = (bump > 0.) ? Angle(fmod(bump, 2*M_PI)) : Angle(2*M_PI+fmod(bump, 2*M_PI));
+	};
+
+	/**
+	 * Decodes an activity profile (see decode(const double*, PopulationCode&))
+	 *
+	 * @param (const vec&) input: N values
+	 * @return (PopulationCode)
+	 */
+	PopulationCode decode(const vec& input){
+		PopulationCode code;
+		decode(input.memptr(), code);
+		return code;
+	};
+
+	/**
+	 * Decodes every column of a weight matrix (N x K) in one pass over its memory
+	 *
+	 * @param (const mat&) weights: N x K matrix
+	 * @param (vector<PopulationCode>&) codes: decoded quantities per column (resized to K)
+	 * @return (void)
+	 */
+	void decode_cols(const mat& weights, vector<PopulationCode>& codes){
+		codes.resize(weights.n_cols);
+		for(unsigned int k = 0; k < weights.n_cols; k++)
+			decode(weights.colptr(k), codes[k]);
+	};
+
 	/**
 	 * Returns the rate vector of the array
 	 *
@@ -264,6 +613,41 @@ public:
 		return output_rate;
 	};
 
+	/**
+	 * Returns a reference to the rate vector of the array (for in-place updates)
+	 *
+	 *  @return (vec&)
+	 */
+	vec& rate_ref(){
+		return output_rate;
+	};
+
+	/**
+	 * Stores the rate vector in external memory (e.g., a column of a batch matrix).
+	 * The current rates are copied; the array then works on the external memory,
+	 * which has to hold N values and outlive the array's use.
+	 *
+	 *  @param (double*) mem: external memory of N values
+	 *  @return (void)
+	 */
+	void bind_rate(double* mem){
+		for(int i = 0; i < N; i++)
+			mem[i] = output_rate(i);
+		output_rate.~vec();
+		new (&output_rate) vec(mem, N, false, true);
+	};
+
+	/**
+	 * Moves the rate vector back to own memory (after bind_rate)
+	 *
+	 *  @return (void)
+	 */
+	void release_rate(){
+		vec copy = output_rate;
+		output_rate.~vec();
+		new (&output_rate) vec(copy);
+	};
+
 	/**
 	 * Returns the rate of a given neuron of the array
 	 *
@@ -284,6 +668,28 @@ public:
 		output_rate.zeros();
 	};
 
+	/**
+	 * Writes or reads the activities, weights and decoded angles of the array
+	 * (the rate vector keeps its memory, also if bound to a batch)
+	 *
+	 * @param (Checkpoint&) cp: snapshot file
+	 * @return (void)
+	 */
+	void checkpoint(Checkpoint& cp){
+		cp.check(N, "number of neurons");
+		cp.io(output_rate);
+		cp.io(input_rate);
+		cp.io(input_conns);
+		cp.io(bias);
+		cp.pod(threshold);
+		cp.pod(max_rate);
+		cp.io(max_angle);
+		cp.io(avg_angle);
+		cp.io(length);
+		cp.pod(avgw_angle);
+		cp.io(new_vector_avg);
+	};
+
 	/**
 	 * Set average angle
 	 *
@@ -311,6 +717,71 @@ public:
 		max_angle.at(index) = _val;
 	};
 
+	/**
+	 * Sets average angle, length and maximum from a decoded profile
+	 *
+	 * @param (Angle) _avg: average angle (e.g., code.pva or code.bump)
+	 * @param (PopulationCode) code: decoded profile (length and maximum)
+	 * @param (int) index: vector index (default: 0)
+	 * @return (void)
+	 */
+	void set_code(Angle _avg, const PopulationCode& code, int index=0){
+		avg_angle.at(index) = _avg;
+		length.at(index) = code.len;
+		max_angle.at(index) = code.max;
+		max_rate = code.max_rate;
+	};
+
+	/**
+	 * Learning kernel: adds the weight change to the clean weights, clips them
+	 * at zero and sets the incoming connections to the clean weights plus
+	 * uniform synaptic noise in one pass without temporaries. Without noise the
+	 * generator is only advanced by the same number of draws, so the noise
+	 * stream (shared with the controller) stays the same.
+	 *
+	 * @param (mat) clean: clean weights (updated in place, same size as input_conns)
+	 * @param (mat) change: weight change (same size as input_conns)
+	 * @param (double) width: width of the uniform synaptic noise
+	 * @param (int) col: first column updated (default: 0)
+	 * @param (int) num_cols: number of columns updated (default: -1 = all from col)
+	 * @return (void)
+	 */
+	void apply_weight_change(mat& clean, const mat& change, double width, int col = 0, int num_cols = -1){
+		if(num_cols < 0)
+			num_cols = input_conns.n_cols - col;
+		const int n = num_cols*input_conns.n_rows;
+		const double* dw = change.colptr(col);
+		double* cw = clean.colptr(col);
+		double* w = input_conns.colptr(col);
+		if(width != 0.0){
+			for(int i = 0; i < n; i++){
+				cw[i] += dw[i];
+				if(cw[i] < 0.0)
+					cw[i] = 0.0;
+				w[i] = cw[i] + rng->uniform()*width;
+			}
+		}
+		else{
+			for(int i = 0; i < n; i++){
+				cw[i] += dw[i];
+				if(cw[i] < 0.0)
+					cw[i] = 0.0;
+				w[i] = cw[i];
+			}
+			rng->discard(n);
+		}
+	};
+
+	/**
+	 * Sets the random number generator used for noise (shared with the controller)
+	 *
+	 * @param (RNG*) _rng: random number generator
+	 * @return (void)
+	 */
+	void set_rng(RNG* _rng){
+		rng = _rng;
+	};
+
 	/**
 	 * Sets the incoming connections to the array
 	 *
@@ -326,7 +797,7 @@ public:
 	 * @param (vec) input: vector
 	 * @return (double) average angle of maximum firing
 	 */
-	void update_piavg(vec input){
+	void update_piavg(const vec& input){
 		double sum_act = 0.0;
 		double output = 0.0;
 		int _start = 0;
@@ -339,15 +810,6 @@ public:
 				_start = (i+1)%N;
 		}
 
-		int factor = 1;
-
-		double sins = 0.;
-		double coss = 0.;
-
-
-		uword index;
-		double maxmax = input.max(index);
-
 		if(_start > _end)
 			_end+=N;
 
@@ -365,7 +827,7 @@ public:
 		}
 	};
 
-	Angle update_avg(vec input){
+	Angle update_avg(const vec& input){
 		double sum_act = 0.0;
 		double output = 0.0;
 		int _start = 0;
@@ -378,14 +840,6 @@ public:
 				_start = (i+1)%N;
 		}
 
-		int factor = 1;
-
-		double sins = 0.;
-		double coss = 0.;
-
-		uword index;
-		double maxmax = input.max(index);
-
 		if(_start > _end)
 			_end+=N;
 
@@ -412,11 +866,11 @@ public:
 	 * @param (vec) input: vector
 	 * @return (double)
 	 */
-	double update_len(vec input){
+	double update_len(const vec& input){
 		return scale_factor * sum(input)/(N*N);
 	}
 
-	void update_pilen(vec input){
+	void update_pilen(const vec& input){
 		length.at(0) = scale_factor * sum(input)/(N*N);
 	}
 
@@ -425,7 +879,7 @@ public:
 	 *
 	 * @return (Angle)
 	 */
-	Angle update_max(vec input){
+	Angle update_max(const vec& input){
 		uword index;
 		max_rate = input.max(index);
 		return Angle(preferred_angle(index));
@@ -443,12 +897,44 @@ public:
 		output_rate = rate;
 	};
 
-	Angle vector_avg(vec input){
+	/**
+	 * Writes the tuning curve cos(theta - preferred angle) of all neurons
+	 * (fast policy: from the cached cos/sin basis with one sincos of theta)
+	 *
+	 * @param (double) theta: input angle (rad)
+	 * @param (double*) out: N values
+	 * @return (void)
+	 */
+	template<class M = Trig>
+	void cos_tuning(double theta, double* out) const {
+		if(M::fast){
+			double s, c;
+			M::sincos(theta, s, c);
+			for(int i = 0; i < N; i++)
+				out[i] = c*cos_preferred(i) + s*sin_preferred(i);
+		}
+		else{
+			for(int i = 0; i < N; i++)
+				out[i] = M::cos(theta - preferred_angle(i));
+		}
+	};
+
+	Angle vector_avg(const vec& input){
 		double x = 0.;
 		double y = 0.;
-		for(int index = 0; index < input.n_elem; index++){
-			x += input(index)*cos(2*M_PI*index/input.n_elem);
-			y += input(index)*sin(2*M_PI*index/input.n_elem);
+		if(input.n_elem == N){
+			// preferred angles are 2*M_PI*index/N, so the cached basis is exact
+			const double* in = input.memptr();
+			for(int index = 0; index < N; index++){
+				x += in[index]*cos_preferred(index);
+				y += in[index]*sin_preferred(index);
+			}
+		}
+		else{
+			for(int index = 0; index < input.n_elem; index++){
+				x += input(index)*cos(2*M_PI*index/input.n_elem);
+				y += input(index)*sin(2*M_PI*index/input.n_elem);
+			}
 		}
 		Vec sum = Vec(x,y);
 		return sum.ang();
@@ -463,7 +949,7 @@ public:
 	 */
 	vec vnoise(int dim, double width){
 		if(width > 0.0){
-			return randn<vec>(dim)*width;
+			return rng->randn(dim, width);
 		}
 		else
 			return zeros<vec>(dim);
@@ -478,6 +964,15 @@ public:
 		return input_conns;
 	};
 
+	/**
+	 * Returns a reference to the weight matrix of the array (no copy)
+	 *
+	 *  @return (mat&)
+	 */
+	mat& w_ref(){
+		return input_conns;
+	};
+
 	/**
 	 * Returns the weight vector of the array
 	 *
@@ -499,7 +994,10 @@ protected:
 	vec output_rate;								// Activity rate of neuron array
 	mat input_conns;                                // incoming connections
 	vec preferred_angle;                            // Preferred angle of neurons
+	vec cos_preferred;                              // Cosine of preferred angles
+	vec sin_preferred;                              // Sine of preferred angles
 	vector<Angle> new_vector_avg;
+	RNG* rng;                                       // Random number generator (own or shared)
 
 private:
 
@@ -512,7 +1010,7 @@ private:
 
 	vec input_rate;                                 // Input activity rate to the array
 	vec bias;										// Bias vector
-	unsigned int seed;
+	RNG own_rng;                                    // Default generator for standalone arrays
 };
 
 
@@ -7,7 +7,8 @@
 
 #include "controller.h"
 
-Controller::Controller(int num_neurons, int _num_gv_units, int _num_lv_units, double sensory_noise, double leakage, double uncorr_noise, double syn_noise, vector<bool> opt_switches){
+Controller::Controller(int num_neurons, int _num_gv_units, int _num_lv_units, double sensory_noise, double leakage, double uncorr_noise, double syn_noise, vector<bool> opt_switches, const string& out_dir){
+	path = out_dir;
 	homing_on = opt_switches.at(0);
 	gvlearn_on = opt_switches.at(1);
 	lvlearn_on = opt_switches.at(2);
@@ -16,15 +17,20 @@ Controller::Controller(int num_neurons, int _num_gv_units, int _num_lv_units, do
 	numneurons = num_neurons;
 	pin = new PIN(numneurons, leakage, sensory_noise, uncorr_noise, SILENT);
 	pin->VERBOSE=true;
+	pin->set_rng(&engine);
 
 	num_colors = _num_gv_units;
-	if(gvlearn_on)
-		gvl = new GoalLearning(numneurons, syn_noise, &inward, false, SILENT);
+	if(gvlearn_on){
+		gvl = new GoalLearning(numneurons, syn_noise, &inward, false, SILENT, path);
+		gvl->set_rng(&engine);
+	}
 	gl_array.resize(num_colors);
 
 	num_lv_units = _num_lv_units;
-	if(lvlearn_on)
-		lvl = new RouteLearning(numneurons, num_lv_units, 0.0, &inward, false, SILENT);
+	if(lvlearn_on){
+		lvl = new RouteLearning(numneurons, num_lv_units, 0.0, &inward, false, SILENT, path);
+		lvl->set_rng(&engine);
+	}
 
 	rand_m = 0.0;
 	pi_m = 0.0;
@@ -34,11 +40,14 @@ Controller::Controller(int num_neurons, int _num_gv_units, int _num_lv_units, do
 	pi_w = 1.0;
 	gl_w = 0.0;
 	rl_w = 0.0;
+	output_rand = 0.0;
+	output_hv = 0.0;
+	output_gv = 0.0;
+	output_lv = 0.0;
 	output = 0.0;
 	inward = 0.0;
 	goal_factor = 0.0;
 	expl_beta = 0.01;//0.01;//0.1;	//0.5
-	seed = 12345678;
 
 	cGV.resize(num_colors);
 	accum_reward = zeros(num_colors);
@@ -63,13 +72,14 @@ Controller::Controller(int num_neurons, int _num_gv_units, int _num_lv_units, do
 	pin_on = true;
 	gvnavi_on = false;
 	beta_on = false;
+	const_expl = false;
 
 	write = true;
 	state_matrc = true;
-	stream.open("./data/control.dat");
-	r_stream.open("./data/reward.dat");
-	lm_stream.open("./data/lm_rec.dat");
-	pi_stream.open("./data/pi_activity.dat");
+	stream.open((path + "data/control.dat").c_str());
+	r_stream.open((path + "data/reward.dat").c_str());
+	lm_stream.open((path + "data/lm_rec.dat").c_str());
+	pi_stream.open((path + "data/pi_activity.dat").c_str());
 
 	rx = 0.0;
 	ry = 0.0;
@@ -94,6 +104,65 @@ Controller::~Controller() {
 	pi_stream.close();
 }
 
+void Controller::checkpoint(Checkpoint& cp){
+	cp.check(num_colors, "number of GV units");
+	cp.check(num_lv_units, "number of LV units");
+	cp.check(pin_on + 2*gvlearn_on + 4*lvlearn_on, "controller modules");
+	engine.checkpoint(cp);
+	if(pin_on)
+		pin->checkpoint(cp);
+	if(gvlearn_on)
+		gvl->checkpoint(cp);
+	if(lvlearn_on)
+		lvl->checkpoint(cp);
+	pi_array.checkpoint(cp);
+	gv_array.checkpoint(cp);
+	for(int i = 0; i < lv_array.size(); i++)
+		lv_array.at(i).checkpoint(cp);
+	ref_array.checkpoint(cp);
+
+	cp.pod(inward);
+	cp.pod(goal_factor);
+	cp.io(lv_value);
+	cp.io(cGV);
+	cp.io(cLV);
+	cp.io(accum_reward);
+	cp.io(reward);
+	cp.io(td_error);
+	cp.io(value);
+	cp.io(dvalue);
+	cp.pod(expl_beta);
+	cp.pod(delta_beta);
+	cp.pod(beta_on);
+	cp.pod(const_expl);
+	cp.pod(inv_sampling_rate);
+	cp.io(expl_factor);
+	cp.io(d_expl_factor);
+	cp.pod(current_goal);
+	cp.io(prob);
+	cp.io(act);
+	cp.pod(choice);
+	cp.pod(beta);
+	cp.pod(rx);
+	cp.pod(ry);
+	cp.pod(t);
+	cp.pod(t_home);
+	cp.pod(run);
+	cp.pod(rand_w);
+	cp.pod(pi_w);
+	cp.pod(gl_w);
+	cp.pod(rl_w);
+	cp.pod(rand_m);
+	cp.pod(pi_m);
+	cp.pod(gl_m);
+	cp.pod(rl_m);
+	cp.pod(output_rand);
+	cp.pod(output_hv);
+	cp.pod(output_gv);
+	cp.pod(output_lv);
+	cp.pod(output);
+}
+
 double Controller::el_lm(int index){
 	return lvl->el_lm(index);
 }
@@ -204,16 +273,11 @@ Vec Controller::RV(){
 }
 
 double Controller::randn(double mean, double stdev) {
-//	static random_device e { };
-//	static normal_distribution<double> d(mean, stdev);
-//	return d(e);
-	boost::mt19937 rng; // I don't seed it on purpouse (it's not relevant)
+	return engine.normal(mean, stdev);
+}
 
-	rng.seed((++seed) + time(NULL));
-	boost::normal_distribution<> nd(mean, stdev);
-	boost::variate_generator<boost::mt19937&,
-	boost::normal_distribution<> > var_nor(rng, nd);
-	return var_nor();
+RNG* Controller::rng(){
+	return &engine;
 }
 
 void Controller::reset() {
@@ -242,7 +306,7 @@ void Controller::set_inward(int _time) {
 
 void Controller::save_matrices() {
 	printf("Save matrices.\n");
-	pi_array.save("./data/mat/pi_activity.mat", raw_ascii);
+	pi_array.save(path + "data/mat/pi_activity.mat");
 //	mat first = pi_array.cols(495,504);
 //	mat second = pi_array.cols(995,1004);
 //	mat third = pi_array.cols(1495,1504);
@@ -252,17 +316,38 @@ void Controller::save_matrices() {
 //	third.save("./data/mat/pi_1500.mat", raw_ascii);
 //	fourth.save("./data/mat/pi_2000.mat", raw_ascii);
 
-	gv_array.save("./data/mat/gv_activity.mat", raw_ascii);
+	gv_array.save(path + "data/mat/gv_activity.mat");
 
 	stringstream lv_;
 	for(int i = 0; i < lv_array.size(); i++){
 		lv_.str(string());
-		lv_ << "./data/mat/lv_activity_" << i << ".mat";
+		lv_ << path << "data/mat/lv_activity_" << i << ".mat";
 		cout << lv_.str() << endl;
-		lv_array.at(i).save(lv_.str().c_str(), raw_ascii);
+		lv_array.at(i).save(lv_.str());
 	}
 
-	ref_array.save("./data/mat/ref_activity.mat", raw_ascii);
+	ref_array.save(path + "data/mat/ref_activity.mat");
+}
+
+void Controller::reserve_samples(int num_trials, int steps_per_trial){
+	int num_samples = num_trials * ((steps_per_trial + inv_sampling_rate - 1) / inv_sampling_rate);
+	pi_array.reserve(num_samples);
+	gv_array.reserve(num_samples);
+	for(int i = 0; i < lv_array.size(); i++)
+		lv_array.at(i).reserve(num_samples);
+	ref_array.reserve(num_samples);
+}
+
+void Controller::seed(uint64_t master_seed, int stream){
+	engine.seed(master_seed, stream);
+}
+
+void Controller::set_record_window(int K){
+	pi_array.set_window(K);
+	gv_array.set_window(K);
+	for(int i = 0; i < lv_array.size(); i++)
+		lv_array.at(i).set_window(K);
+	ref_array.set_window(K);
 }
 
 void Controller::set_delta_expl(int _index, double _value, bool _const){
@@ -282,15 +367,22 @@ void Controller::set_sample_int(int _val){
 }
 
 double Controller::update(Angle angle, double speed, double inReward, vec inLmr, int color) {
+	begin_update(angle, speed);
+	integrate();
+	return end_update(angle, speed, inReward, inLmr, color);
+}
+
+void Controller::begin_update(Angle angle, double speed) {
 	if(t%inv_sampling_rate == 0 && !SILENT){
-		pi_array = join_rows(pi_array, pin->get_output());
+		PROFILE(PROF_RECORD);
+		pi_array.push(pin->array(PI)->rate_ref());
 		if(gvlearn_on){
-			gv_array = join_rows(gv_array, gvl->w(0));
+			gv_array.push(gvl->w(0));
 		}
 		if(lvlearn_on){
 			for(int i = 0; i < lv_array.size(); i++)
-				lv_array.at(i) = join_rows(lv_array.at(i), lvl->w(i));
-			ref_array = join_rows(ref_array, lvl->RefPI());
+				lv_array.at(i).push(lvl->w(i));
+			ref_array.push(lvl->RefPI());
 		}
 	}
 	t++;
@@ -302,8 +394,24 @@ double Controller::update(Angle angle, double speed, double inReward, vec inLmr,
 	}
 
 	/*** Path Integration Mechanism ***/
-	if(pin_on)
-		pin->update(angle, speed);
+	if(pin_on){
+		PROFILE(PROF_PI);
+		pin->sense(angle, speed);
+	}
+}
+
+void Controller::integrate() {
+	if(pin_on && !pin->batched()){
+		PROFILE(PROF_PI);
+		pin->integrate();
+	}
+}
+
+double Controller::end_update(Angle angle, double speed, double inReward, const vec& inLmr, int color) {
+	if(pin_on){
+		PROFILE(PROF_PI);
+		pin->decode();
+	}
 
 	if(gvlearn_on && gl_w > 0.)
 		pi_w = HV().len() * (1. - expl_factor(0))*(1.-accu(lv_value));
@@ -324,8 +432,11 @@ double Controller::update(Angle angle, double speed, double inReward, vec inLmr,
 
 	/*** Reward and value update ***/
 	if(lvlearn_on){
-		for(int i = 0; i < num_lv_units; i++)
-			lv_value(i) = 1. - exp(-0.5*lvl->eligibility_value(i));
+		PROFILE(PROF_LV);
+		for(int i = 0; i < num_lv_units; i++){
+			double el_value = lvl->eligibility_value(i);	// zero except for the unit(s) with maximum trace
+			lv_value(i) = (el_value == 0.0) ? 0.0 : 1. - exp(-0.5*el_value);
+		}
 	}
 	delta_beta = mu_beta*((1./expl_beta) + lambda * value(0) * expl_factor(0));
 	if(beta_on)
@@ -354,6 +465,7 @@ double Controller::update(Angle angle, double speed, double inReward, vec inLmr,
 
 	/*** Global Vector Learning Circuits TODO ***/
 	if(gvlearn_on){
+		PROFILE(PROF_GV);
 		for(int i = 0; i < num_colors; i++){
 			gvl->update(pin->get_output(), reward(i), expl_factor(i));
 			cGV.at(i) = (GV(i) - HV());
@@ -367,17 +479,20 @@ double Controller::update(Angle angle, double speed, double inReward, vec inLmr,
 
 	/*** Local Vector Learning Circuits TODO ***/
 	if(lvlearn_on){
-
+		PROFILE(PROF_LV);
 		lvl->update(angle, speed, inReward, inLmr);
 
 		rl_m = 0.0;
 		rl_w = (1. - inward);
-		for(int i = 0; i < num_lv_units; i++){
-			//cLV.at(i) = (LV(i) - HV());
-			if(inward == 0.){
-				gl_w = 0.0;
-				pi_w = 0.0;
-				rl_m += lv_value(i) * (LV().len()*(LV().ang() - angle).S() + RV().len()*(RV().ang().i() - angle).S());
+		if(inward == 0. && num_lv_units > 0){
+			Vec lv = LV();		// LV() searches all landmark units, so it is taken once per step
+			Vec rv = RV();
+			double lv_m = lv.len()*(lv.ang() - angle).S() + rv.len()*(rv.ang().i() - angle).S();
+			gl_w = 0.0;
+			pi_w = 0.0;
+			for(int i = 0; i < num_lv_units; i++){
+				//cLV.at(i) = (LV(i) - HV());
+				rl_m += lv_value(i) * lv_m;
 			}
 		}
 		//if(VERBOSE && t%100==0)
@@ -388,16 +503,19 @@ double Controller::update(Angle angle, double speed, double inReward, vec inLmr,
 		output_lv = 0.;
 
 	/*** Random foraging ***/
-	if(lvlearn_on){
-		rand_w = (1. - inward)*0.6*expl_factor(0)*(1.-accu(lv_value));
-	}
-	else
-		rand_w = (1. - inward)*0.6*expl_factor(0);
-	rand_m = randn(0.0, 1.);
-	if(inward == 1)
-		rand_m = 0.;
+	{
+		PROFILE(PROF_RANDOM);
+		if(lvlearn_on){
+			rand_w = (1. - inward)*0.6*expl_factor(0)*(1.-accu(lv_value));
+		}
+		else
+			rand_w = (1. - inward)*0.6*expl_factor(0);
+		rand_m = randn(0.0, 1.);
+		if(inward == 1)
+			rand_m = 0.;
 
-	output_rand = rand_w * rand_m;
+		output_rand = rand_w * rand_m;
+	}
 
 	/*** Navigation Control Output ***/
 	output = output_rand + output_hv + output_gv + output_lv;
@@ -14,8 +14,10 @@
 #include <sstream>
 #include <vector>
 #include "pin.h"
+#include "profiler.h"
 #include "geom.h"
 #include "goallearning.h"
+#include "recorder.h"
 #include "routelearning.h"
 using namespace std;
 using namespace arma;
@@ -45,9 +47,10 @@ public:
 	 *	@param (double) leakage: leakage of PI memory
 	 *	@param (double) uncorr_noise: uncorrelated noise at input layer
 	 *	@param (double) syn_noise: synaptic noise at GV layer
+	 *	@param (string) out_dir: output directory containing data/ and save/ (default: "./")
 	 *
 	 */
-	Controller(int num_neurons, int num_gv_units, int num_lv_units, double sensory_noise, double leakage, double uncorr_noise, double syn_noise, vector<bool> opt_switches);
+	Controller(int num_neurons, int num_gv_units, int num_lv_units, double sensory_noise, double leakage, double uncorr_noise, double syn_noise, vector<bool> opt_switches, const string& out_dir = "./");
 
 	/**
 	 * Destructor
@@ -55,6 +58,15 @@ public:
 	 */
 	~Controller();
 
+	/**
+	 * Writes or reads the state of the controller and its modules (including
+	 * the noise engine and the recorded activities)
+	 *
+	 *  @param (Checkpoint&) cp: snapshot file
+	 *  @return (void)
+	 */
+	void checkpoint(Checkpoint& cp);
+
 	/**
 	 * Returns current goal vector angle of goal i
 	 *
@@ -288,6 +300,13 @@ public:
 	 */
 	double randn(double mean=0.0, double stdev=1.0);
 
+	/**
+	 * Returns the random number generator of this controller
+	 *
+	 * @return (RNG*)
+	 */
+	RNG* rng();
+
 	/**
 	 * Returns a random number drawn from a uniform distribution
 	 *
@@ -311,6 +330,15 @@ public:
 	 */
 	//void reset_matrices();
 
+	/**
+	 * Preallocates the activity/weight recordings for a run
+	 *
+	 *	@param (int) num_trials: number of trials
+	 *	@param (int) steps_per_trial: maximum number of time steps per trial
+	 *  @return (void)
+	 */
+	void reserve_samples(int num_trials, int steps_per_trial);
+
 	/**
 	 * Save activity/weight matrices
 	 *
@@ -318,6 +346,23 @@ public:
 	 */
 	void save_matrices();
 
+	/**
+	 * Seeds the random number generator of this controller and its modules
+	 *
+	 *	@param (uint64_t) master_seed: master seed of the simulation
+	 *	@param (int) stream: index of independent stream (e.g., agent index; default: 0)
+	 * 	@return (void)
+	 */
+	void seed(uint64_t master_seed, int stream=0);
+
+	/**
+	 * Keeps only the last K samples of the activity/weight recordings (0 = keep all)
+	 *
+	 *	@param (int) K: number of samples kept
+	 * 	@return (void)
+	 */
+	void set_record_window(int K);
+
 	/**
 	 * Set change of exploration rate to value (constant, if second argument is true)
 	 *
@@ -373,6 +418,34 @@ public:
 	 */
 	double update(Angle angle, double speed, double inReward, vec inLmr, int color);
 
+	/**
+	 * First step of update: samples activities, checks inward state and feeds the PI network
+	 *
+	 *  @param (Angle) angle: Input angle from compass
+	 *  @param (double) speed: Input walking speed from odometry
+	 *  @return (void)
+	 */
+	void begin_update(Angle angle, double speed);
+
+	/**
+	 * Second step of update: integrates the PI network (done by a PINBatch, if batched)
+	 *
+	 *  @return (void)
+	 */
+	void integrate();
+
+	/**
+	 * Last step of update: decodes the home vector and computes the control output
+	 *
+	 *  @param (Angle) angle: Input angle from compass
+	 *  @param (double) speed: Input walking speed from odometry
+	 *  @param (double) inReward: Reward from environment
+	 *  @param (vec) inLmr: landmark recognition signals
+	 *  @param (int) color: Color of nearest goal
+	 *  @return (double) control output
+	 */
+	double end_update(Angle angle, double speed, double inReward, const vec& inLmr, int color);
+
 	/**
 	 * Updates the state matrices
 	 *
@@ -403,14 +476,14 @@ private:
 	double goal_factor;
 
 	//************ Path Integration Parameters ************//
-	mat pi_array;
+	Recorder pi_array;
 
 	//************ Goal Learning Parameters ************//
 	vector<mat> gl_array;
-	mat gv_array;
+	Recorder gv_array;
 
-	vector<mat> lv_array;
-	mat ref_array;
+	vector<Recorder> lv_array;
+	Recorder ref_array;
 	vec lv_value;
 	int num_lv_units;
 
@@ -457,7 +530,7 @@ private:
 	int trial_t;
 	int t_home;
 	int run;
-	unsigned int seed;
+	RNG engine;							// one noise engine shared by all modules of this controller
 
 public:
 	// command weights
@@ -487,6 +560,7 @@ public:
 	bool const_expl;
 	bool write;
 	bool SILENT;			// no activity matrices sampling
+	string path;			// output directory
 	bool state_matrc;
 	int inv_sampling_rate;	//for activations stored in matrix ([s])
 };
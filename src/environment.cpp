@@ -26,10 +26,18 @@
  ****************************************************************************/
 
 #include <cmath>
+#include <limits>
 #include "environment.h"
 using namespace std;
 
-Environment::Environment(int num_agents){
+Environment::Environment(int num_agents, const string& out_dir, uint64_t _seed){
+	path = out_dir;
+	rng.seed(_seed, num_agents);
+	fast_forward = false;
+	agent_batch = false;
+	pin_batch = nullptr;
+	workers = nullptr;
+	set_threads(1);
 	t_step = 0;
 	inv_sampling_rate = 1;
 	stop_trial = false;
@@ -53,10 +61,20 @@ Environment::Environment(int num_agents){
 	lm_stats.last_seen = ones<vec>(agent_list.size());
 	lm_stats.last_seen *= -1;
 	in_pipe = zeros<mat>(agent_list.size(), pipe_list.size());
+	goal_contact.resize(agent_list.size());
+	free_steps.assign(agent_list.size(), 0);
+	lm_contact.resize(agent_list.size());
 	open_streams();
 }
 
-Environment::Environment(int num_goals, int num_landmarks, double max_radius, int num_agents){
+Environment::Environment(int num_goals, int num_landmarks, double max_radius, int num_agents, const string& out_dir, uint64_t _seed){
+	path = out_dir;
+	rng.seed(_seed, num_agents);
+	fast_forward = false;
+	agent_batch = false;
+	pin_batch = nullptr;
+	workers = nullptr;
+	set_threads(1);
 	inv_sampling_rate = 1;
 
 	(VERBOSE)?printf("\nCREATE %u AGENTS\n", num_agents):VERBOSE;
@@ -67,18 +85,14 @@ Environment::Environment(int num_goals, int num_landmarks, double max_radius, in
 		agent_list.push_back(agent);
 	}
 	(VERBOSE)?printf("\nAGENTS CREATED\n\n"):VERBOSE;
-	(VERBOSE)?printf("\nCREATE %u GOALS\n\n", num_goals):VERBOSE;
-	/** SET UP GOALS **/
-	for(unsigned int i = 0; i < num_goals; i++){
-		add_goal(max_radius);
-	}
-	(VERBOSE)?printf("\nGOALS CREATED\n\n"):VERBOSE;
-	(VERBOSE)?printf("\nCREATE %u LANDMARKS\n\n", num_landmarks):VERBOSE;
-	/** SET UP LANDMARKS **/
-	for(unsigned int i = 0; i < num_landmarks; i++){
-		add_landmark(max_radius);
-	}
-	(VERBOSE)?printf("\nLANDMARKS CREATED\n\n"):VERBOSE;
+	(VERBOSE)?printf("\nCREATE %u GOALS AND %u LANDMARKS\n\n", num_goals, num_landmarks):VERBOSE;
+	/** SET UP GOALS AND LANDMARKS (Poisson disk sampling) **/
+	shared_ptr<const WorldLayout> world = WorldLayout::random(num_goals, num_landmarks, max_radius, rng());
+	for(int j = 0; j < world->goals().size(); j++)
+		add_goal(world->goals().x[j], world->goals().y[j]);
+	for(int j = 0; j < world->landmarks().size(); j++)
+		add_landmark(world->landmarks().x[j], world->landmarks().y[j]);
+	(VERBOSE)?printf("\nGOALS AND LANDMARKS CREATED\n\n"):VERBOSE;
 
 	reward.resize(agent_list.size());
 	trial_reward.resize(agent_list.size());
@@ -89,12 +103,17 @@ Environment::Environment(int num_goals, int num_landmarks, double max_radius, in
 	lm_stats.visible = zeros<mat>(landmark_list.size(), agent_list.size());
 	lm_stats.seen = zeros<mat>(landmark_list.size(), agent_list.size());
 	lm_stats.catchment = zeros<mat>(landmark_list.size(), agent_list.size());
+	goal_contact.resize(agent_list.size());
+	free_steps.assign(agent_list.size(), 0);
+	lm_contact.resize(agent_list.size());
 	open_streams();
 }
 
 Environment::~Environment(){
 	stream_h << "0.0" << "\t" << "0.0" << endl;
 	stream_h.close();
+	delete workers;
+	delete pin_batch;
 	for(unsigned int i = 0; i < agent_list.size(); i++)
 		delete agent_list.at(i);
 	for(unsigned int i = 0; i < goal_list.size(); i++){
@@ -139,78 +158,103 @@ void Environment::add_agent(double x, double y){
 	agent_list.push_back(agent);
 	g_stats.collisions = zeros<mat>(agent_list.size(), goal_list.size());
 	g_stats.hits = zeros<mat>(agent_list.size(), goal_list.size());
+	goal_contact.assign(agent_list.size(), vector<int>());
+	free_steps.assign(agent_list.size(), 0);
+	lm_contact.resize(agent_list.size());
 }
 
 void Environment::add_goal(double x, double y, int color, double size, bool decay){
+	detach_layout();
 	Goal* goal = new Goal(x,y,VERBOSE,color, size, decay);
+	int j = goal->bind(&goals);
+	goal_grid.insert(j, goals.x[j], goals.y[j]);
 	goal_list.push_back(goal);
 	g_stats.collisions = zeros<mat>(agent_list.size(), goal_list.size());
 	g_stats.hits = zeros<mat>(agent_list.size(), goal_list.size());
+	goal_contact.assign(agent_list.size(), vector<int>());
+	free_steps.assign(agent_list.size(), 0);
 }
 
 void Environment::add_goal(double max_radius){
-	flag = false;
-	Goal* goal;
-	while(!flag){
-		goal = new Goal(max_radius,VERBOSE);
-		if(goal_list.size()==0)
-			flag = true;
-		count = 0;
-		for(unsigned int j = 0; j < goal_list.size(); j++){
-			if(d(goal_list.at(j), goal) > 3.){
-				count++;
-			}
-			else
-			{
-				(VERBOSE)?printf("Too close = %g\n", d(goal_list.at(j), goal)):VERBOSE;
-			}
-		}
-		if(count==goal_list.size())
-			flag = true;
-		if(!flag){
-			(VERBOSE)?printf("\nWARNING: Goal too close to each other.\nGOAL DELETED\n\n"):VERBOSE;
-			delete goal;
-		}
+	double x, y;
+	if(!random_position(1., max_radius, 3., 0.5, x, y)){
+		printf("WARNING: No free position for a goal within radius %g.\n", max_radius);
+		return;
 	}
-	goal_list.push_back(goal);
-	g_stats.collisions = zeros<mat>(agent_list.size(), goal_list.size());
-	g_stats.hits = zeros<mat>(agent_list.size(), goal_list.size());
+	add_goal(x, y);
 }
 
 void Environment::add_landmark(double x, double y){
+	detach_layout();
 	Landmark* lm = new Landmark(x,y,VERBOSE);
+	int j = landmarks.add(lm->x(), lm->y());
+	lm_grid.insert(j, landmarks.x[j], landmarks.y[j]);
 	landmark_list.push_back(lm);
 	lm_stats.visible = zeros<mat>(landmark_list.size(), agent_list.size());
 	lm_stats.seen = zeros<mat>(landmark_list.size(), agent_list.size());
 	lm_stats.catchment = zeros<mat>(landmark_list.size(), agent_list.size());
+	lm_contact.assign(agent_list.size(), vector<int>());
+	free_steps.assign(agent_list.size(), 0);
 }
 
 void Environment::add_landmark(double max_radius){
-	Landmark* landmark;
-	flag = false;
-	while(!flag){
-		landmark = new Landmark(max_radius,VERBOSE);
-		if(landmark_list.size()==0)
-			flag = true;
-		count = 0;
-		for(unsigned int j = 0; j < goal_list.size(); j++){
-			if(d(landmark, goal_list.at(j)) > .5){
-				count++;
-			}
-		}
-		for(unsigned int j = 0; j < landmark_list.size(); j++){
-			if(d(landmark_list.at(j), landmark) > 1.){
-				count++;
-			}
-		}
-		if(count==goal_list.size()+landmark_list.size())
-			flag = true;
-		if(!flag){
-			(VERBOSE)?printf("\nWARNING: Landmark too close to each other.\nLANDMARK DELETED\n\n"):VERBOSE;
-			delete landmark;
-		}
+	double x, y;
+	if(!random_position(0.5, max_radius, 0.5, 1., x, y)){
+		printf("WARNING: No free position for a landmark within radius %g.\n", max_radius);
+		return;
+	}
+	add_landmark(x, y);
+}
+
+bool Environment::random_position(double min_radius, double max_radius, double goal_dist, double lm_dist, double& x, double& y){
+	/// dart throwing against the grids of the placed goals and landmarks
+	const int tries = 30;
+	for(int t = 0; t < tries; t++){
+		double r = sqrt(rng.uniform(min_radius*min_radius, max_radius*max_radius));
+		double a = 2.*M_PI*rng.uniform(0., 1.);
+		x = r*cos(a);
+		y = r*sin(a);
+		if(free_position(x, y, goal_dist, lm_dist))
+			return true;
 	}
-	landmark_list.push_back(landmark);
+
+	/// darts keep missing (dense world): free positions of one Poisson disk fill, drawn until they run out
+	/// (the fill is near-maximal and objects are only added, so there is no second fill for the same key)
+	double key[4] = {min_radius, max_radius, goal_dist, lm_dist};
+	if(!filled || !equal(key, key+4, fill_key)){
+		copy(key, key+4, fill_key);
+		PoissonDisk disk(max(goal_dist, lm_dist), min_radius, max_radius);
+		for(int j = 0; j < goals.size(); j++)
+			disk.avoid(goals.x[j], goals.y[j], goal_dist);
+		for(int j = 0; j < landmarks.size(); j++)
+			disk.avoid(landmarks.x[j], landmarks.y[j], lm_dist);
+		disk.sample(rng, numeric_limits<int>::max(), fill_x, fill_y);
+		filled = true;
+	}
+	while(fill_x.size() > 0){
+		int k = min(int(rng.uniform(0., 1.)*fill_x.size()), int(fill_x.size()) - 1);
+		x = fill_x[k];
+		y = fill_y[k];
+		fill_x[k] = fill_x.back();
+		fill_y[k] = fill_y.back();
+		fill_x.pop_back();
+		fill_y.pop_back();
+		if(free_position(x, y, goal_dist, lm_dist))
+			return true;
+	}
+	return false;
+}
+
+bool Environment::free_position(double x, double y, double goal_dist, double lm_dist){
+	goal_index->query(x, y, goal_dist, near);
+	for(unsigned int k = 0; k < near.size(); k++)
+		if(hypot(x - goals.x[near[k]], y - goals.y[near[k]]) <= goal_dist)
+			return false;
+	lm_index->query(x, y, lm_dist, near);
+	for(unsigned int k = 0; k < near.size(); k++)
+		if(hypot(x - landmarks.x[near[k]], y - landmarks.y[near[k]]) <= lm_dist)
+			return false;
+	return true;
 }
 
 void Environment::add_pipe(double x0, double x1, double y0, double y1){
@@ -221,6 +265,59 @@ void Environment::add_pipe(double x0, double x1, double y0, double y1){
 	in_pipe = zeros<mat>(agent_list.size(), pipe_list.size());
 }
 
+void Environment::checkpoint(Checkpoint& cp){
+	cp.check(agent_list.size(), "number of agents");
+	cp.check(goal_list.size(), "number of goals");
+	cp.check(landmark_list.size(), "number of landmarks");
+	cp.check(pipe_list.size(), "number of pipes");
+	for(unsigned int i = 0; i < agent_list.size(); i++)
+		agent_list.at(i)->checkpoint(cp, pipe_angle);
+
+	/// goals and landmarks: positions and reward state, the grids are rebuilt from the arrays (or
+	/// the shared layout is kept, if the positions are the same)
+	cp.io(goals.x);
+	cp.io(goals.y);
+	cp.io(goals.amount);
+	cp.io(goals.amount_rate);
+	cp.io(goals.color);
+	cp.io(landmarks.x);
+	cp.io(landmarks.y);
+	for(unsigned int j = 0; j < goal_list.size(); j++)
+		cp.io(goal_list.at(j)->pos);
+	for(unsigned int j = 0; j < landmark_list.size(); j++)
+		cp.io(landmark_list.at(j)->pos);
+	if(!cp.save() && !same_layout()){
+		detach_layout();
+		goal_grid.clear();
+		for(unsigned int j = 0; j < goals.size(); j++)
+			goal_grid.insert(j, goals.x[j], goals.y[j]);
+		lm_grid.clear();
+		for(unsigned int j = 0; j < landmarks.size(); j++)
+			lm_grid.insert(j, landmarks.x[j], landmarks.y[j]);
+	}
+
+	cp.io(g_stats.collisions);
+	cp.io(g_stats.hits);
+	cp.io(lm_stats.visible);
+	cp.io(lm_stats.seen);
+	cp.io(lm_stats.catchment);
+	cp.io(lm_stats.last_seen);
+	cp.io(in_pipe);
+	cp.io(reward);
+	cp.io(trial_reward);
+	cp.io(total_reward);
+	cp.io(lm_recogn);
+	cp.io(goal_contact);
+	cp.io(lm_contact);
+	cp.io(free_steps);
+	cp.pod(count);
+	cp.pod(count_lm);
+	cp.pod(flag);
+	cp.pod(mode);
+	cp.pod(t_step);
+	cp.pod(stop_trial);
+}
+
 /*int Environment::color(){
 	if(goal_list.size()>0){
 		int out = nearest(x(),y())->color();
@@ -231,6 +328,95 @@ void Environment::add_pipe(double x0, double x1, double y0, double y1){
 		return 0;
 }*/
 
+void Environment::copy_layout(Environment* other){
+	if(other->layout == nullptr || !use_layout(other->layout)){
+		for(unsigned int j = 0; j < other->goal_list.size(); j++)
+			add_goal(other->goals.x[j], other->goals.y[j], other->goals.color[j], other->goals.amount[j], other->goals.amount_rate[j] > 0.);
+		for(unsigned int j = 0; j < other->landmark_list.size(); j++)
+			add_landmark(other->landmarks.x[j], other->landmarks.y[j]);
+	}
+	for(unsigned int j = 0; j < other->goal_list.size(); j++){
+		goals.amount[j] = other->goals.amount[j];
+		goals.amount_rate[j] = other->goals.amount_rate[j];
+		goal_list.at(j)->pos = other->goal_list.at(j)->pos;
+	}
+	for(unsigned int j = 0; j < other->landmark_list.size(); j++)
+		landmark_list.at(j)->pos = other->landmark_list.at(j)->pos;
+	for(unsigned int j = 0; j < other->pipe_list.size(); j++){
+		Pipe* pipe = other->pipe_list.at(j);
+		add_pipe(pipe->x0(), pipe->x1(), pipe->y0(), pipe->y1());
+	}
+	set_fast_forward(other->fast_forward);
+	set_agent_batch(other->agent_batch);
+	set_threads((other->workers != nullptr) ? other->workers->num_threads() : 1);
+	inv_sampling_rate = other->inv_sampling_rate;
+}
+
+bool Environment::use_layout(const shared_ptr<const WorldLayout>& world){
+	if(goal_list.size() > 0 || landmark_list.size() > 0){
+		printf("WARNING: Layout not used (environment has goals or landmarks).\n");
+		return false;
+	}
+	const GoalArrays& g = world->goals();
+	const LandmarkArrays& l = world->landmarks();
+	if(world->goal_index().size() != goal_grid.size() || world->lm_index().size() != lm_grid.size()){
+		/// other cell sizes: own index (queries must give the same candidates as the own grids)
+		for(int j = 0; j < g.size(); j++){
+			add_goal(g.x[j], g.y[j], g.color[j], g.amount[j], g.amount_rate[j] > 0.);
+			goals.amount_rate[j] = g.amount_rate[j];
+		}
+		for(int j = 0; j < l.size(); j++)
+			add_landmark(l.x[j], l.y[j]);
+		return true;
+	}
+	/// per-run views and reward state on top of the shared positions and index
+	for(int j = 0; j < g.size(); j++){
+		Goal* goal = new Goal(g.x[j], g.y[j], VERBOSE, g.color[j], g.amount[j], g.amount_rate[j] > 0.);
+		goal->bind(&goals);
+		goals.amount_rate[j] = g.amount_rate[j];
+		goal_list.push_back(goal);
+	}
+	for(int j = 0; j < l.size(); j++){
+		Landmark* lm = new Landmark(l.x[j], l.y[j], VERBOSE);
+		landmarks.add(lm->x(), lm->y());
+		landmark_list.push_back(lm);
+	}
+	g_stats.collisions = zeros<mat>(agent_list.size(), goal_list.size());
+	g_stats.hits = zeros<mat>(agent_list.size(), goal_list.size());
+	lm_stats.visible = zeros<mat>(landmark_list.size(), agent_list.size());
+	lm_stats.seen = zeros<mat>(landmark_list.size(), agent_list.size());
+	lm_stats.catchment = zeros<mat>(landmark_list.size(), agent_list.size());
+	goal_contact.assign(agent_list.size(), vector<int>());
+	lm_contact.assign(agent_list.size(), vector<int>());
+	free_steps.assign(agent_list.size(), 0);
+	layout = world;
+	goal_index = &world->goal_index();
+	lm_index = &world->lm_index();
+	return true;
+}
+
+shared_ptr<const WorldLayout> Environment::world() const {
+	return layout;
+}
+
+void Environment::detach_layout(){
+	if(!layout)
+		return;
+	goal_grid = layout->goal_index();
+	lm_grid = layout->lm_index();
+	goal_index = &goal_grid;
+	lm_index = &lm_grid;
+	layout.reset();
+}
+
+bool Environment::same_layout() const {
+	if(!layout)
+		return false;
+	const GoalArrays& g = layout->goals();
+	const LandmarkArrays& l = layout->landmarks();
+	return goals.x == g.x && goals.y == g.y && landmarks.x == l.x && landmarks.y == l.y;
+}
+
 double Environment::d(Object* o1, Object* o2){
 	return (o1->v() - o2->v()).len();
 }
@@ -247,6 +433,12 @@ double Environment::d(double x0, double x1){
 	return pow(x0-x1,2);
 }
 
+double Environment::d(const Vec& p, double x, double y){
+	double dx = p.x - x;
+	double dy = p.y - y;
+	return sqrt(dx*dx + dy*dy + p.z*p.z);
+}
+
 /*int Environment::get_hits(){
 	int sum = 0;
 	for(unsigned int j = 0; j < goal_list.size(); j++)
@@ -271,16 +463,18 @@ double Environment::get_total_r(int index){
 }
 
 Landmark* Environment::get_visible_LM(int i){
-	for(unsigned int j = 0; j < landmark_list.size(); j++){
-		if(d(agent_list.at(i), landmark_list.at(j)) < lm_catch_radius)
-			return landmark_list.at(j);
+	lm_index->query(x(i), y(i), lm_catch_radius, near);
+	for(unsigned int k = 0; k < near.size(); k++){
+		if(d(agent_list.at(i)->pos, landmarks.x[near[k]], landmarks.y[near[k]]) < lm_catch_radius)
+			return landmark_list.at(near[k]);
 	}
 	return nullptr;
 }
 
 double Environment::get_visible_LM_th(int i){
-	if(get_visible_LM(i) != nullptr)
-		return phi(get_visible_LM(i), agent_list.at(i)).rad();
+	Landmark* lm = get_visible_LM(i);
+	if(lm != nullptr)
+		return phi(lm, agent_list.at(i)).rad();
 	else
 		return 0.0;
 }
@@ -289,6 +483,10 @@ Goal* Environment::g(int i){
 	return goal_list.at(i);
 }
 
+Landmark* Environment::l(int i){
+	return landmark_list.at(i);
+}
+
 vec Environment::lmr(int i){
 	if(i < lm_stats.visible.n_cols)
 		return lm_stats.visible.col(i);
@@ -296,25 +494,48 @@ vec Environment::lmr(int i){
 		return vec(0.0);
 }
 
-/*int Environment::n_goals(){
+int Environment::n_goals(){
 	return goal_list.size();
-}*/
+}
+
+int Environment::n_landmarks(){
+	return landmark_list.size();
+}
 
 Goal* Environment::nearest(double x, double y){
 	double min_dist;
 	//cout << goal_list.size() << endl;
 	if(goal_list.size()>0)
-		min_dist = sqrt( d(goal_list.at(0)->x(), x) + d(goal_list.at(0)->y(), y));
+		min_dist = sqrt( d(goals.x[0], x) + d(goals.y[0], y));
 	else
 		return new Goal(0., 0.);
 	double dist;
 	int idx=0;
-	for(int i=1; i<goal_list.size(); i++){
-		dist = sqrt( d(goal_list.at(i)->x(), x) + d(goal_list.at(i)->y(), y));
-		if(dist<min_dist){
-			idx = i;
-			min_dist = dist;
+	int kmax = goal_index->max_ring(x, y);
+	if((2*kmax+1)*(2*kmax+1) > 4*goal_list.size()){
+		/// sparse grid around (x,y): a linear scan is cheaper than the ring search
+		for(int i=1; i<goal_list.size(); i++){
+			dist = sqrt( d(goals.x[i], x) + d(goals.y[i], y));
+			if(dist<min_dist){
+				idx = i;
+				min_dist = dist;
+			}
 		}
+		return goal_list.at(idx);
+	}
+	/// ring search: goals beyond ring k are at least k cells away
+	for(int k = 0; k <= kmax; k++){
+		near.clear();
+		goal_index->ring(x, y, k, near);
+		for(unsigned int n = 0; n < near.size(); n++){
+			dist = sqrt( d(goals.x[near[n]], x) + d(goals.y[near[n]], y));
+			if(dist<min_dist || (dist==min_dist && near[n]<idx)){
+				idx = near[n];
+				min_dist = dist;
+			}
+		}
+		if(min_dist < k*goal_index->size())
+			break;
 	}
 	return goal_list.at(idx);
 }
@@ -330,11 +551,11 @@ void Environment::open_streams(){
 //			stream_a.at(i).open("TODO");
 //	else
 //		stream_a.at(0).open("agent.dat");
-	stream_h.open("./data/home.dat");
-	stream_g.open("./data/goals.dat");
-	stream_lm.open("./data/landmarks.dat");
-	stream_p.open("./data/pipes.dat");
-	stream_food.open("./data/food.dat");
+	stream_h.open((path + "data/home.dat").c_str());
+	stream_g.open((path + "data/goals.dat").c_str());
+	stream_lm.open((path + "data/landmarks.dat").c_str());
+	stream_p.open((path + "data/pipes.dat").c_str());
+	stream_food.open((path + "data/food.dat").c_str());
 }
 
 double Environment::r(int index){
@@ -350,6 +571,9 @@ void Environment::reset(){
 	lm_stats.seen = zeros<mat>(landmark_list.size(), agent_list.size());
 	lm_stats.catchment = zeros<mat>(landmark_list.size(), agent_list.size());
 	lm_stats.visible = zeros<mat>(landmark_list.size(), agent_list.size());
+	goal_contact.assign(agent_list.size(), vector<int>());
+	free_steps.assign(agent_list.size(), 0);
+	lm_contact.assign(agent_list.size(), vector<int>());
 	std::fill(trial_reward.begin(), trial_reward.end(), 0.);
 	for(unsigned int i = 0; i < agent_list.size(); i++)
 		agent_list.at(i)->reset();
@@ -357,6 +581,48 @@ void Environment::reset(){
 		goal_list.at(j)->reset();*/
 }
 
+void Environment::set_fast_forward(bool _opt){
+	fast_forward = _opt;
+	free_steps.assign(agent_list.size(), 0);
+}
+
+void Environment::set_agent_batch(bool _opt){
+	agent_batch = _opt;
+	if(!agent_batch){
+		delete pin_batch;
+		pin_batch = nullptr;
+	}
+}
+
+void Environment::seed(uint64_t master_seed){
+	rng.seed(master_seed, agent_list.size());
+}
+
+void Environment::set_threads(int _threads){
+	delete workers;
+	workers = nullptr;
+	if(_threads != 1)
+		workers = new WorkerPool(_threads);
+	int num_workers = (workers != nullptr) ? workers->num_threads() : 1;
+	worker_near.resize(num_workers);
+	worker_next.resize(num_workers);
+}
+
+void Environment::for_agents(int first, const function<void(int)>& fn){
+	int n = int(agent_list.size()) - first;
+	if(n <= 0)
+		return;
+	if(workers == nullptr){
+		for(int i = first; i < first + n; i++)
+			fn(i);
+		return;
+	}
+	workers->run(n, [&](int begin, int end, int w){
+		for(int i = first + begin; i < first + end; i++)
+			fn(i);
+	});
+}
+
 void Environment::set_mode(int in_mode){
 	mode = in_mode;
 }
@@ -375,75 +641,221 @@ void Environment::update(){
 	update_rewards();
 	update_collisions();
 	update_pipe();
+	if(fast_forward)
+		update_clearance();
 	update_agents();
 }
 
 void Environment::update_agents(){
+	PROFILE(PROF_AGENTS);
+	/// landmark control of agent i > 0 depends on agent 0 having moved; everything else is per agent
+	bool batched = prepare_batch();
+	if(agent_list.size() > 0){
+		update_lm_control(0);
+		agent_list.at(0)->begin_update();
+	}
+	for(unsigned int i = 1; i < agent_list.size(); i++)
+		update_lm_control(i);
+	for_agents(1, [this](int i){
+		agent_list.at(i)->begin_update();
+	});
+	/// batched: PI networks of all agents are integrated together
+	if(batched){
+		PROFILE(PROF_PI);
+		pin_batch->update();
+	}
+	for_agents(0, [this](int i){
+		agent_list.at(i)->c()->integrate();
+		if(i < lm_stats.visible.n_rows)
+			agent_list.at(i)->end_update(reward.at(i), lm_stats.visible.col(i));
+		else
+			agent_list.at(i)->end_update(reward.at(i), vec(0.0));
+	});
+	for(unsigned int i = 0; i < agent_list.size(); i++)
+		check_stop(i);
+}
+
+bool Environment::prepare_batch(){
+	if(!agent_batch || agent_list.size() < 2)
+		return false;
+	batch_pins.clear();
 	for(unsigned int i = 0; i < agent_list.size(); i++){
-		count_lm=0;
-		if(VERBOSE && t_step%100==0)
-			printf("Last seen = %1.0f\n", lm_stats.last_seen(i));
-		for(unsigned int j = 0; j < landmark_list.size(); j++){
-			if(lm_stats.catchment(j,i) == 1 && lm_stats.seen(j,i) == 0 && lm_stats.last_seen(i) != j){
-				agent_list.at(i)->lm_catch = true;
-				lm_stats.last_seen(i) = j;
-			}
-			if(agent_list.at(i)->lm_catch){
-				Angle lm_phi = phi(landmark_list.at(i), agent_list.at(i));
-				double landmark_attract = 0.5*sin(get_visible_LM_th(0) - agent_list.at(i)->phi().rad());
-				if(VERBOSE && t_step%100==0)
-					printf("LM attract %g at (%g,%g) -> %u || Theta = %g\n", landmark_attract, a(0)->x(), a(0)->y(), agent_list.at(i)->lm_catch, get_visible_LM_th(0));
-				agent_list.at(i)->set_lmcontrol(landmark_attract);
-			}
-			if(lm_stats.seen(j,i) == 1 || lm_stats.catchment(j,i) == 0)
-				count_lm++;
+		if(!agent_list.at(i)->c()->pin_on){
+			delete pin_batch;
+			pin_batch = nullptr;
+			return false;
 		}
-		if(count_lm==3){
-			agent_list.at(i)->set_lmcontrol(0.0);
-			agent_list.at(i)->lm_catch = false;
+		batch_pins.push_back(agent_list.at(i)->c()->pi());
+	}
+	/// the batch is kept only while it binds the current networks (controllers may be replaced)
+	if(pin_batch != nullptr && pin_batch->binds(batch_pins))
+		return true;
+	/// networks are released by the old batch before the new one binds them
+	delete pin_batch;
+	pin_batch = nullptr;
+	/// networks of different size or kernel integrate on their own
+	if(!PINBatch::compatible(batch_pins))
+		return false;
+	pin_batch = new PINBatch(batch_pins);
+	return true;
+}
+
+void Environment::check_stop(int i){
+	if((agent_list.at(i)->d() < home_radius && agent_list.at(i)->c()->get_state()) ||
+			(!(agent_list.at(i)->c()->homing_on) && agent_list.at(i)->c()->get_state())){
+		//printf("stop it\n");
+		stop_trial = true;
+	}
+}
+
+void Environment::update_lm_control(int i){
+	count_lm=0;
+	if(VERBOSE && t_step%100==0)
+		printf("Last seen = %1.0f\n", lm_stats.last_seen(i));
+	/// only landmarks in catchment (lm_contact) can be caught; all others count as passed
+	count_lm = landmark_list.size();
+	const vector<int>& catching = lm_contact.at(i);
+	for(unsigned int k = 0; k < catching.size(); k++){
+		int j = catching[k];
+		if(lm_stats.seen(j,i) == 0 && lm_stats.last_seen(i) != j){
+			agent_list.at(i)->lm_catch = true;
+			lm_stats.last_seen(i) = j;
 		}
-		if(i < lm_stats.visible.n_rows)
-			agent_list.at(i)->update(reward.at(i), lm_stats.visible.col(i));
-		else
-			agent_list.at(i)->update(reward.at(i), vec(0.0));
-		if((agent_list.at(i)->d() < home_radius && agent_list.at(i)->c()->get_state()) ||
-				(!(agent_list.at(i)->c()->homing_on) && agent_list.at(i)->c()->get_state())){
-			//printf("stop it\n");
-			stop_trial = true;
+		if(lm_stats.seen(j,i) == 0)
+			count_lm--;
+	}
+	if(landmark_list.size() > 0 && agent_list.at(i)->lm_catch){
+		double landmark_attract = 0.5*sin(get_visible_LM_th(0) - agent_list.at(i)->phi().rad());
+		if(VERBOSE && t_step%100==0)
+			printf("LM attract %g at (%g,%g) -> %u || Theta = %g\n", landmark_attract, a(0)->x(), a(0)->y(), agent_list.at(i)->lm_catch, get_visible_LM_th(0));
+		agent_list.at(i)->set_lmcontrol(landmark_attract);
+	}
+	if(count_lm==3){
+		agent_list.at(i)->set_lmcontrol(0.0);
+		agent_list.at(i)->lm_catch = false;
+	}
+}
+
+void Environment::update_clearance(){
+	if(workers == nullptr){
+		for(unsigned int i = 0; i < agent_list.size(); i++)
+			update_clearance(i, worker_near[0]);
+		return;
+	}
+	workers->run(agent_list.size(), [this](int begin, int end, int w){
+		for(int i = begin; i < end; i++)
+			update_clearance(i, worker_near[w]);
+	});
+}
+
+void Environment::update_clearance(int i, vector<int>& cand){
+	if(free_steps.at(i) > 0){
+		free_steps.at(i)--;
+		return;
+	}
+	/// checks only skipped with no contacts and no pipes (pipes move the agent)
+	if(!goal_contact.at(i).empty() || !lm_contact.at(i).empty() || pipe_list.size() > 0 || agent_list.at(i)->in_pipe)
+		return;
+	const Vec& p = agent_list.at(i)->pos;
+	/// the agent moves at most step per update; k steps are safe while k*step < clearance
+	double step = agent_list.at(i)->step_length()*(1. + 1e-9) + 1e-12;
+	/// clearance beyond max_free_steps steps does not change the result: search no further
+	double clearance = min(max_clearance, (max_free_steps + 1.)*step);
+	clearance = nearest_clearance(*goal_index, goals.x, goals.y, goal_radius, p, clearance, cand);
+	clearance = nearest_clearance(*lm_index, landmarks.x, landmarks.y, lm_catch_radius, p, clearance, cand);
+	clearance -= 1e-9;
+	if(clearance > 0.)
+		free_steps.at(i) = int(min(clearance/step, double(max_free_steps)));
+}
+
+double Environment::nearest_clearance(const SpatialGrid& index, const vector<double>& x, const vector<double>& y, double radius, const Vec& p, double clearance, vector<int>& cand){
+	int kmax = index.max_ring(p.x, p.y);
+	if((2*kmax+1)*(2*kmax+1) > 4*int(x.size())){
+		/// sparse grid around p: a linear scan is cheaper than the ring search
+		for(unsigned int j = 0; j < x.size(); j++){
+			double dx = p.x - x[j];
+			double dy = p.y - y[j];
+			clearance = min(clearance, sqrt(dx*dx+dy*dy) - radius);
 		}
+		return clearance;
 	}
+	/// ring search: objects in ring k are more than (k-1) cells away
+	for(int k = 0; k <= kmax && (k-1)*index.size() - radius < clearance; k++){
+		cand.clear();
+		index.ring(p.x, p.y, k, cand);
+		for(unsigned int n = 0; n < cand.size(); n++){
+			double dx = p.x - x[cand[n]];
+			double dy = p.y - y[cand[n]];
+			clearance = min(clearance, sqrt(dx*dx+dy*dy) - radius);
+		}
+	}
+	return clearance;
 }
 
 void Environment::update_collisions(){
-	for(unsigned int i = 0; i < agent_list.size(); i++){
-		for(unsigned int j = 0; j < goal_list.size(); j++){
-			if(d(agent_list.at(i), goal_list.at(j)) < goal_radius){
-				if(g_stats.collisions(i,j) == 0)
-					g_stats.hits(i,j)++;
-				g_stats.collisions(i,j) = 1;
-			}
-			else
-				g_stats.collisions(i,j) = 0;
+	PROFILE(PROF_COLLISIONS);
+	/// agent i only writes its own contacts and statistics (row i / column i)
+	if(workers == nullptr){
+		for(unsigned int i = 0; i < agent_list.size(); i++)
+			update_collisions(i, worker_near[0], worker_next[0]);
+		return;
+	}
+	workers->run(agent_list.size(), [this](int begin, int end, int w){
+		for(int i = begin; i < end; i++)
+			update_collisions(i, worker_near[w], worker_next[w]);
+	});
+}
+
+void Environment::update_collisions(int i, vector<int>& cand, vector<int>& next){
+	if(free_steps.at(i) > 0)
+		return;
+	const Vec& p = agent_list.at(i)->pos;
+	/// goals: only grid candidates are tested, contacts of the last step are cleared
+	goal_index->query(p.x, p.y, goal_radius, cand);
+	next.clear();
+	for(unsigned int k = 0; k < cand.size(); k++){
+		int j = cand[k];
+		if(d(p, goals.x[j], goals.y[j]) < goal_radius){
+			if(g_stats.collisions(i,j) == 0)
+				g_stats.hits(i,j)++;
+			next.push_back(j);
 		}
-		for(unsigned int j = 0; j < landmark_list.size(); j++){
-			if(d(agent_list.at(i), landmark_list.at(j)) < lm_catch_radius){
-				lm_stats.catchment(j,i) = 1;
-			}
-			else{
-				lm_stats.catchment(j,i) = 0;
-				lm_stats.seen(j,i) = 0;
-			}
-			if(d(agent_list.at(i), landmark_list.at(j)) < lm_radius){
-				lm_stats.visible(j,i) = 1;//10.*(0.1 - d(agent_list.at(i), landmark_list.at(j)));
-				lm_stats.seen(j,i) = 1;
-			}
-			else
-				lm_stats.visible(j,i) = 0;
+	}
+	vector<int>& touching = goal_contact.at(i);
+	for(unsigned int k = 0; k < touching.size(); k++)
+		g_stats.collisions(i,touching[k]) = 0;
+	for(unsigned int k = 0; k < next.size(); k++)
+		g_stats.collisions(i,next[k]) = 1;
+	touching.swap(next);
+
+	/// landmarks: leaving the catchment resets catchment, seen and visible
+	lm_index->query(p.x, p.y, lm_catch_radius, cand);
+	vector<int>& catching = lm_contact.at(i);
+	for(unsigned int k = 0; k < catching.size(); k++){
+		lm_stats.catchment(catching[k],i) = 0;
+		lm_stats.visible(catching[k],i) = 0;
+	}
+	next.clear();
+	for(unsigned int k = 0; k < cand.size(); k++){
+		int j = cand[k];
+		double dist = d(p, landmarks.x[j], landmarks.y[j]);
+		if(dist < lm_catch_radius){
+			lm_stats.catchment(j,i) = 1;
+			next.push_back(j);
+		}
+		if(dist < lm_radius){
+			lm_stats.visible(j,i) = 1;//10.*(0.1 - d(agent_list.at(i), landmark_list.at(j)));
+			lm_stats.seen(j,i) = 1;
 		}
 	}
+	for(unsigned int k = 0; k < catching.size(); k++)
+		if(lm_stats.catchment(catching[k],i) == 0)
+			lm_stats.seen(catching[k],i) = 0;
+	catching.swap(next);
 }
 
 void Environment::update_pipe(){
+	PROFILE(PROF_PIPE);
 	for(unsigned int i = 0; i < agent_list.size(); i++){
 		for(unsigned int j = 0; j < pipe_list.size(); j++){
 			double dis = d(agent_list.at(i), pipe_list.at(j)->in());
@@ -467,16 +879,47 @@ void Environment::update_pipe(){
 }
 
 void Environment::update_rewards(){
+	PROFILE(PROF_REWARDS);
 	std::fill(reward.begin(), reward.end(), 0.);
 	std::fill(lm_recogn.begin(), lm_recogn.end(), 0.);
+	reward_goals.resize(agent_list.size());
+	reward_dist.resize(agent_list.size());
+	/// goals in reach are found in parallel ...
+	if(workers == nullptr){
+		for(unsigned int i = 0; i < agent_list.size(); i++)
+			find_rewards(i, worker_near[0]);
+	}
+	else{
+		workers->run(agent_list.size(), [this](int begin, int end, int w){
+			for(int i = begin; i < end; i++)
+				find_rewards(i, worker_near[w]);
+		});
+	}
+	/// ... and rewarded and depleted in agent order (later agents see the depleted amount)
 	for(unsigned int i = 0; i < agent_list.size(); i++){
-		for(unsigned int j = 0; j < goal_list.size(); j++){
-			if(d(agent_list.at(i), goal_list.at(j)) < goal_radius && agent_list.at(i)->c()->get_state() == 0){
-				reward.at(i) += goal_list.at(j)->a()*(1./goal_radius)*(goal_radius-d(agent_list.at(i), goal_list.at(j)));
-				trial_reward.at(i) += reward.at(i);
-				total_reward.at(i) += reward.at(i);
-				goal_list.at(j)->da();
-			}
+		for(unsigned int k = 0; k < reward_goals[i].size(); k++){
+			int j = reward_goals[i][k];
+			reward.at(i) += goals.amount[j]*(1./goal_radius)*(goal_radius-reward_dist[i][k]);
+			trial_reward.at(i) += reward.at(i);
+			total_reward.at(i) += reward.at(i);
+			goals.da(j);
+		}
+	}
+}
+
+void Environment::find_rewards(int i, vector<int>& cand){
+	reward_goals[i].clear();
+	reward_dist[i].clear();
+	if(agent_list.at(i)->c()->get_state() != 0 || free_steps.at(i) > 0)
+		return;
+	const Vec& p = agent_list.at(i)->pos;
+	goal_index->query(p.x, p.y, goal_radius, cand);
+	for(unsigned int k = 0; k < cand.size(); k++){
+		int j = cand[k];
+		double dist = d(p, goals.x[j], goals.y[j]);
+		if(dist < goal_radius){
+			reward_goals[i].push_back(j);
+			reward_dist[i].push_back(dist);
 		}
 	}
 }
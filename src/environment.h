@@ -32,7 +32,13 @@
 #include "goal.h"
 #include "landmark.h"
 #include "pipe.h"
+#include "profiler.h"
+#include "rng.h"
+#include "spatialgrid.h"
+#include "worldlayout.h"
+#include "workerpool.h"
 #include <algorithm>
+#include <memory>
 #include <vector>
 #include <iostream>
 #include <fstream>
@@ -67,9 +73,11 @@ public:
 	 * Constructor for an empty environment
 	 *
 	 *	@param (int) num_agents: number of agents in this environment (default: 1)
+	 *	@param (string) out_dir: directory containing data/ (default: "./")
+	 *	@param (uint64_t) _seed: master seed of random object placement (default: 5489)
 	 *
 	 */
-	Environment(int num_agents=1);
+	Environment(int num_agents=1, const string& out_dir="./", uint64_t _seed=5489u);
 
 	/**
 	 * Constructor for an environment with randomly distributed goals and landmarks
@@ -78,9 +86,11 @@ public:
 	 *	@param (int) num_landmarks: number of landmarks in enviornment
 	 *	@param (double) max_radius: maximum radius of objects in environment
 	 *	@param (int) num_agents: number of agents in this environment (default: 1)
+	 *	@param (string) out_dir: directory containing data/ (default: "./")
+	 *	@param (uint64_t) _seed: master seed of the layout and random object placement (default: 5489)
 	 *
 	 */
-	Environment(int num_goals, int num_landmarks, double max_radius, int num_agents=1);
+	Environment(int num_goals, int num_landmarks, double max_radius, int num_agents=1, const string& out_dir="./", uint64_t _seed=5489u);
 
 	/**
 	 * Destructor
@@ -130,7 +140,7 @@ public:
 	void add_goal(double x, double y, int color = 0, double size = 1., bool decay=false);
 
 	/**
-	 * Adds a randomly placed goal
+	 * Adds a randomly placed goal (more than 3 from goals and 0.5 from landmarks)
 	 *
 	 *	@param (double) max_radius: maximum radius of placement
 	 * 	@return (void)
@@ -147,7 +157,7 @@ public:
 	void add_landmark(double x, double y);
 
 	/**
-	 * Adds a randomly placed landmark
+	 * Adds a randomly placed landmark (more than 0.5 from goals and 1 from landmarks)
 	 *
 	 *	@param (double) max_radius: maximum radius of placement
 	 * 	@return (void)
@@ -165,6 +175,43 @@ public:
 	 */
 	void add_pipe(double x0, double y0, double x1, double y1);
 
+	/**
+	 * Writes or reads the state of the environment and all agents. Goal and
+	 * landmark positions are stored (random placement differs between runs),
+	 * the spatial grids are rebuilt on loading.
+	 *
+	 *	@param (Checkpoint&) cp: snapshot file
+	 *	@return (void)
+	 */
+	void checkpoint(Checkpoint& cp);
+
+	/**
+	 * Adds the goals, landmarks and pipes of another environment (same
+	 * positions and reward state) and takes over its update options
+	 *
+	 *	@param (Environment*) other: environment to be copied
+	 *	@return (void)
+	 */
+	void copy_layout(Environment* other);
+
+	/**
+	 * Adds the goals and landmarks of a shared layout (only into an
+	 * environment without goals and landmarks). The environment queries the
+	 * index of the layout instead of building its own; adding further goals
+	 * or landmarks later gives it a private copy of the index.
+	 *
+	 *	@param (shared_ptr<const WorldLayout>) world: layout shared with other environments
+	 *	@return (bool) true, if the layout is used
+	 */
+	bool use_layout(const shared_ptr<const WorldLayout>& world);
+
+	/**
+	 * Returns the shared layout in use (nullptr, if the environment has its own index)
+	 *
+	 *	@return (shared_ptr<const WorldLayout>)
+	 */
+	shared_ptr<const WorldLayout> world() const;
+
 	/**
 	 * Returns color index of nearest goal
 	 *
@@ -245,6 +292,14 @@ public:
 	 */
 	Goal* g(int i=0);
 
+	/**
+	 * Return landmark pointer with given index
+	 *
+	 *	@param (int) i: index of landmark (default: 0)
+	 *	@return (Landmark*)
+	 */
+	Landmark* l(int i=0);
+
 	/**
 	 * Returns landmark recognition signal
 	 *
@@ -257,7 +312,14 @@ public:
 	 *
 	 * 	@return (int)
 	 */
-	//int n_goals();
+	int n_goals();
+
+	/**
+	 * Returns number of landmarks (own, random and layout landmarks)
+	 *
+	 * 	@return (int)
+	 */
+	int n_landmarks();
 
 	/**
 	 * Returns goal pointer of the nearest goal from a given position
@@ -336,6 +398,43 @@ public:
 	 */
 	void update_agents();
 
+	/**
+	 * Sets the fast-forward option: reward, collision and landmark checks are skipped
+	 * for as many steps as the agent cannot reach any goal or landmark catchment
+	 *
+	 *	@param (bool) _opt: true, if fast-forward on
+	 * 	@return (void)
+	 */
+	void set_fast_forward(bool _opt);
+
+	/**
+	 * Sets the agent batch option: the PI networks of all agents are integrated
+	 * together in one pass (PINBatch), trajectories are the same as without batching
+	 *
+	 *	@param (bool) _opt: true, if batching on
+	 * 	@return (void)
+	 */
+	void set_agent_batch(bool _opt);
+
+	/**
+	 * Seeds the random object placement (add_goal/add_landmark with radius) with the
+	 * stream after those of the agents' controllers
+	 *
+	 *	@param (uint64_t) master_seed: master seed of the simulation
+	 * 	@return (void)
+	 */
+	void seed(uint64_t master_seed);
+
+	/**
+	 * Sets the number of threads the agents are split across in each update.
+	 * Shared goal state is updated in agent order afterwards, so results are
+	 * the same for any number of threads.
+	 *
+	 *	@param (int) _threads: number of threads, 0 = all cores (default: 1)
+	 * 	@return (void)
+	 */
+	void set_threads(int _threads = 1);
+
 	/**
 	 * Updates any collisions between objects
 	 *
@@ -395,16 +494,183 @@ private:
 	int mode = 0; 						// 0 = outb, 1 = inb
 	int inv_sampling_rate;
 	int t_step;
+	string path;						// output directory
+	RNG rng;							// random object placement
 
 	//************ Object containers ************//
 	vector<Agent*> agent_list;
-	vector<Goal*> goal_list;
-	vector<Landmark*> landmark_list;
+	vector<Goal*> goal_list;				// views on goals
+	vector<Landmark*> landmark_list;		// views on landmarks
+	GoalArrays goals;						// goal positions and reward state (SoA)
+	LandmarkArrays landmarks;				// landmark positions (SoA)
 	vector<Pipe*> pipe_list;
 	vector<Angle*> pipe_angle;
 	ObjStats g_stats;
 	mat in_pipe;
 
+	/**
+	 * Returns the distance between position p and the point (x,y) on the ground plane
+	 *
+	 * 	@param (const Vec&) p: position (agent)
+	 * 	@param (double) x: x position of the point
+	 * 	@param (double) y: y position of the point
+	 * 	@return (double)
+	 */
+	double d(const Vec& p, double x, double y);
+
+	/**
+	 * Counts down the steps without possible contact or computes them from
+	 * the distance to the nearest goal and landmark catchment (fast-forward)
+	 *
+	 *	@return (void)
+	 */
+	void update_clearance();
+
+	/**
+	 * Computes the steps agent i cannot reach any object (parallel phase of update_clearance)
+	 *
+	 *	@param (int) i: agent index
+	 *	@param (vector<int>&) cand: scratch for grid candidates
+	 *	@return (void)
+	 */
+	void update_clearance(int i, vector<int>& cand);
+
+	/**
+	 * Returns the distance from p to the nearest object border, at most clearance (grid ring search)
+	 *
+	 *	@param (SpatialGrid&) index: grid of the objects
+	 *	@param (vector<double>&) x: x positions of the objects
+	 *	@param (vector<double>&) y: y positions of the objects
+	 *	@param (double) radius: object radius
+	 *	@param (Vec&) p: position
+	 *	@param (double) clearance: upper bound of the result (search horizon)
+	 *	@param (vector<int>&) cand: scratch for grid candidates
+	 *	@return (double)
+	 */
+	double nearest_clearance(const SpatialGrid& index, const vector<double>& x, const vector<double>& y, double radius, const Vec& p, double clearance, vector<int>& cand);
+
+	/**
+	 * Sets the landmark control of agent i from its landmark catchments
+	 *
+	 *	@param (int) i: agent index
+	 *	@return (void)
+	 */
+	void update_lm_control(int i);
+
+	/**
+	 * Returns true, if the PI networks of all agents can be batched (and (re)builds the batch)
+	 *
+	 *	@return (bool)
+	 */
+	bool prepare_batch();
+
+	/**
+	 * Checks whether agent i has finished the trial
+	 *
+	 *	@param (int) i: agent index
+	 *	@return (void)
+	 */
+	void check_stop(int i);
+
+	/**
+	 * Runs fn(i) for all agents in [first, number of agents), split across the worker threads
+	 *
+	 *	@param (int) first: first agent index
+	 *	@param (function) fn: function of agent index
+	 *	@return (void)
+	 */
+	void for_agents(int first, const function<void(int)>& fn);
+
+	/**
+	 * Updates goal and landmark contacts of agent i (parallel phase of update_collisions)
+	 *
+	 *	@param (int) i: agent index
+	 *	@param (vector<int>&) cand: scratch for grid candidates
+	 *	@param (vector<int>&) next: scratch for contacts found in this step
+	 *	@return (void)
+	 */
+	void update_collisions(int i, vector<int>& cand, vector<int>& next);
+
+	/**
+	 * Finds the goals rewarding agent i (parallel phase of update_rewards)
+	 *
+	 *	@param (int) i: agent index
+	 *	@param (vector<int>&) cand: scratch for grid candidates
+	 *	@return (void)
+	 */
+	void find_rewards(int i, vector<int>& cand);
+
+	/**
+	 * Draws a random position clear of all goals and landmarks (darts against the object grids; once darts
+	 * keep missing, positions of one Poisson disk fill of the free space; drawn from the environment RNG)
+	 *
+	 *	@param (double) min_radius: minimum distance from the origin
+	 *	@param (double) max_radius: maximum distance from the origin
+	 *	@param (double) goal_dist: minimum distance from goals
+	 *	@param (double) lm_dist: minimum distance from landmarks
+	 *	@param (double&) x: x position
+	 *	@param (double&) y: y position
+	 *	@return (bool) false, if there is no free position
+	 */
+	bool random_position(double min_radius, double max_radius, double goal_dist, double lm_dist, double& x, double& y);
+
+	/**
+	 * Returns true, if a position is more than the given distances away from all goals and landmarks
+	 *
+	 *	@param (double) x: x position
+	 *	@param (double) y: y position
+	 *	@param (double) goal_dist: minimum distance from goals (exclusive)
+	 *	@param (double) lm_dist: minimum distance from landmarks (exclusive)
+	 *	@return (bool)
+	 */
+	bool free_position(double x, double y, double goal_dist, double lm_dist);
+
+	/**
+	 * Replaces the index of the shared layout by a private copy (before goals or landmarks change)
+	 *
+	 *	@return (void)
+	 */
+	void detach_layout();
+
+	/**
+	 * Returns true, if a shared layout is used and has the positions of the goals and landmarks
+	 *
+	 *	@return (bool)
+	 */
+	bool same_layout() const;
+
+	//************ Spatial index ************//
+	SpatialGrid goal_grid = SpatialGrid(goal_radius);		// goals, cell size = reward/collision radius
+	SpatialGrid lm_grid = SpatialGrid(lm_catch_radius);	// landmarks, cell size = catchment radius
+	shared_ptr<const WorldLayout> layout;	// shared layout (nullptr: own index)
+	const SpatialGrid* goal_index = &goal_grid;	// index in use: own or of the layout
+	const SpatialGrid* lm_index = &lm_grid;
+	vector<vector<int> > goal_contact;		// goals currently colliding with agent i
+	vector<vector<int> > lm_contact;		// landmarks whose catchment contains agent i
+	vector<int> near;						// scratch: candidates of the last grid query
+	vector<int> next_contact;				// scratch: contacts found in this step
+	bool fast_forward;						// skip checks while no object is reachable
+	vector<int> free_steps;					// steps agent i cannot reach any object
+	const double max_clearance = 1e6;		// clearance without any objects
+	const int max_free_steps = 1 << 20;
+
+	//************ Agent batch ************//
+	bool agent_batch;						// integrate PI networks of all agents together
+	PINBatch* pin_batch;					// batch of the PI networks (built on first update)
+	vector<PIN*> batch_pins;				// scratch: networks of the agents in this step
+
+	//************ Random placement ************//
+	vector<double> fill_x, fill_y;			// unused free positions of the last Poisson disk fill
+	double fill_key[4] = {0., 0., 0., 0.};	// radii and clearances of this fill
+	bool filled = false;					// a fill with these radii and clearances was made
+
+	//************ Threads ************//
+	WorkerPool* workers;					// worker threads (nullptr = sequential)
+	vector<vector<int> > worker_near;		// scratch: grid candidates per worker
+	vector<vector<int> > worker_next;		// scratch: contacts per worker
+	vector<vector<int> > reward_goals;		// goals rewarding agent i in this step
+	vector<vector<double> > reward_dist;	// distances of agent i to these goals
+
 	//************ output file streams ************//
 	//vector<ofstream> stream_a;		//agents
 	ofstream stream_g;		//goal positions
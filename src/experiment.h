@@ -0,0 +1,505 @@
+/*****************************************************************************
+ *  experiment.h                                                             *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef EXPERIMENT_H_
+#define EXPERIMENT_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "batch.h"
+#include "simulation.h"
+using namespace std;
+
+
+/**
+ * Experiment Specification
+ *
+ * 	One simulation experiment (environment layout, controller options and
+ * 	parameters, run length) read from a text file of "key = value" lines.
+ * 	Goals, landmarks and pipes are given by repeated lines; "#" starts a
+ * 	comment. A line "sweep key = v1 v2 ..." (or "sweep key = from:step:to")
+ * 	adds a grid axis over any scalar key. Example:
+ *
+ * 		trials = 500
+ * 		duration = 100
+ * 		homing = 1
+ * 		gvlearn = 1
+ * 		goal = -1 2            # x y [color] [amount]
+ * 		landmark = 0 1         # x y
+ * 		sweep sensory_noise = 0.01 0.05 0.1
+ *
+ */
+
+struct ExperimentSpec {
+	//************ Run ************//
+	string name = "experiment";         // name (printed)
+	string out = "data/experiment/";    // root of the output directories (<out>/<index>/)
+	int trials = 100;                   // number of trials
+	int agents = 1;                     // number of agents
+	double duration = 100.;             // duration of a trial T [s]
+	double interval = 0.1;              // time step dt [s]
+	double inward = 0.;                 // time until agents turn home [s] (0: run() default)
+	int cycles = 1;                     // repetitions of each grid point (different seeds)
+	int threads = 0;                    // simulations run at the same time (0: all cores)
+	uint64_t seed = 5489u;              // seed of the sweep
+	bool silent = true;                 // no per-trial output and traces
+	//************ Environment ************//
+	bool random_env = false;            // random goals and landmarks (per simulation, from its master seed)
+	string world;                       // layout file shared by all simulations (WorldLayout::save)
+	vector<double> random_world;        // goals, landmarks, radius of one random layout shared by all simulations
+	vector<vector<double> > goals;      // x, y, color, amount
+	vector<vector<double> > landmarks;  // x, y
+	vector<vector<double> > pipes;      // x0, y0, x1, y1
+	//************ Controller ************//
+	bool homing = false;
+	bool gvlearn = false;
+	bool lvlearn = false;
+	bool beta = false;
+	int neurons = 18;                   // neurons per layer
+	int gv_units = 1;                   // number of GV units
+	int lv_units = 0;                   // number of LV units (0: number of landmarks of the built world)
+	double sensory_noise = 0.05;
+	double uncor_noise = 0.0;
+	double leakage = 0.0;
+	double syn_noise = 0.0;
+	//************ Sweep ************//
+	vector<string> axis_keys;           // swept keys
+	vector<vector<string> > axis_values;// values of each swept key
+
+	/**
+	 * Reads a specification file
+	 *
+	 *  @param (string) filename: specification file
+	 *  @return (bool) true, if the file was read without errors
+	 */
+	bool load(const string& filename){
+		ifstream in(filename.c_str());
+		if(!in.is_open()){
+			printf("WARNING: Cannot open experiment %s.\n", filename.c_str());
+			return false;
+		}
+		string line;
+		bool ok = true;
+		for(int n = 1; getline(in, line); n++){
+			line = line.substr(0, line.find('#'));
+			size_t eq = line.find('=');
+			if(trim(line).empty())
+				continue;
+			if(eq == string::npos){
+				printf("WARNING: %s:%d: expected key = value.\n", filename.c_str(), n);
+				ok = false;
+				continue;
+			}
+			string key = trim(line.substr(0, eq));
+			string value = trim(line.substr(eq + 1));
+			if(key.compare(0, 6, "sweep ") == 0){
+				key = trim(key.substr(6));
+				vector<string> values = expand(value);
+				bool valid = !values.empty() && key != "goal" && key != "landmark" && key != "pipe";
+				for(unsigned int i = 0; i < values.size() && valid; i++){
+					ExperimentSpec probe = *this;
+					valid = probe.set(key, values[i]);
+				}
+				if(!valid){
+					printf("WARNING: %s:%d: cannot sweep %s.\n", filename.c_str(), n, key.c_str());
+					ok = false;
+					continue;
+				}
+				axis_keys.push_back(key);
+				axis_values.push_back(values);
+			}
+			else if(!set(key, value)){
+				printf("WARNING: %s:%d: invalid %s = %s.\n", filename.c_str(), n, key.c_str(), value.c_str());
+				ok = false;
+			}
+		}
+		return ok;
+	};
+
+	/**
+	 * Sets a parameter by name (the same keys as in the file)
+	 *
+	 *  @param (string) key: parameter name
+	 *  @param (string) value: value as text
+	 *  @return (bool) true, if key and value are valid
+	 */
+	bool set(const string& key, const string& value){
+		if(key == "name")               name = value;
+		else if(key == "out")           out = (value.empty() || value[value.size()-1] == '/') ? value : value + "/";
+		else if(key == "trials")        return number(value, trials) && trials > 0;
+		else if(key == "agents")        return number(value, agents) && agents > 0;
+		else if(key == "duration")      return number(value, duration) && duration > 0.;
+		else if(key == "interval")      return number(value, interval) && interval > 0.;
+		else if(key == "inward")        return number(value, inward);
+		else if(key == "cycles")        return number(value, cycles) && cycles > 0;
+		else if(key == "threads")       return number(value, threads);
+		else if(key == "seed")          return number(value, seed);
+		else if(key == "silent")        return number(value, silent);
+		else if(key == "random_env")    return number(value, random_env);
+		else if(key == "world")         world = value;
+		else if(key == "random_world")  return list(value, 3, random_world) && random_world[0] >= 0. && random_world[1] >= 0.;
+		else if(key == "homing")        return number(value, homing);
+		else if(key == "gvlearn")       return number(value, gvlearn);
+		else if(key == "lvlearn")       return number(value, lvlearn);
+		else if(key == "beta")          return number(value, beta);
+		else if(key == "neurons")       return number(value, neurons) && neurons > 0;
+		else if(key == "gv_units")      return number(value, gv_units);
+		else if(key == "lv_units")      return number(value, lv_units);
+		else if(key == "sensory_noise") return number(value, sensory_noise);
+		else if(key == "uncor_noise")   return number(value, uncor_noise);
+		else if(key == "leakage")       return number(value, leakage);
+		else if(key == "syn_noise")     return number(value, syn_noise);
+		else if(key == "goal")          return row(value, 2, 4, goals);
+		else if(key == "landmark")      return row(value, 2, 2, landmarks);
+		else if(key == "pipe")          return row(value, 4, 4, pipes);
+		else                            return false;
+		return true;
+	};
+
+	/**
+	 * Returns the number of grid points (product of the axis sizes)
+	 *
+	 *  @return (int)
+	 */
+	int num_points() const {
+		int n = 1;
+		for(unsigned int a = 0; a < axis_values.size(); a++)
+			n *= axis_values[a].size();
+		return n;
+	};
+
+	/**
+	 * Returns the specification of a grid point (last axis varies fastest)
+	 *
+	 *  @param (int) point: grid point index (0..num_points()-1)
+	 *  @return (ExperimentSpec)
+	 */
+	ExperimentSpec at(int point) const {
+		ExperimentSpec spec = *this;
+		for(int a = int(axis_values.size()) - 1; a >= 0; a--){
+			int n = axis_values[a].size();
+			spec.set(axis_keys[a], axis_values[a][point % n]);
+			point /= n;
+		}
+		return spec;
+	};
+
+	/**
+	 * Returns the value of a swept key at a grid point
+	 *
+	 *  @param (int) point: grid point index
+	 *  @param (int) axis: axis index
+	 *  @return (string)
+	 */
+	string value(int point, int axis) const {
+		for(int a = int(axis_values.size()) - 1; a > axis; a--)
+			point /= axis_values[a].size();
+		return axis_values[axis][point % axis_values[axis].size()];
+	};
+
+	/**
+	 * Returns the layout shared by all simulations (world file or random_world), if any
+	 *
+	 *  @return (shared_ptr<const WorldLayout>) layout, nullptr if none or on errors
+	 */
+	shared_ptr<const WorldLayout> shared_world() const {
+		if(!world.empty())
+			return WorldLayout::load(world);
+		if(random_world.size() == 3)
+			return WorldLayout::random(int(random_world[0]), int(random_world[1]), random_world[2], seed);
+		return nullptr;
+	};
+
+	/**
+	 * Builds the simulation of this specification
+	 *
+	 *  @param (string) dir: output directory (with data/, data/mat/ and save/)
+	 *  @param (uint64_t) master_seed: master seed of the agents and of a random environment
+	 *  @param (shared_ptr<const WorldLayout>) layout: shared layout (goals and landmarks before the listed ones; default: none)
+	 *  @return (Simulation*)
+	 */
+	Simulation* build(const string& dir, uint64_t master_seed, const shared_ptr<const WorldLayout>& layout = nullptr) const {
+		Simulation* sim = new Simulation(trials, agents, random_env && !layout, dir, master_seed);
+		sim->SILENT = silent;
+		if(layout)
+			sim->use_layout(layout);
+		for(unsigned int j = 0; j < goals.size(); j++)
+			sim->add_goal(goals[j][0], goals[j][1], goals[j].size() > 2 ? int(goals[j][2]) : 0, goals[j].size() > 3 ? goals[j][3] : 1.);
+		for(unsigned int k = 0; k < landmarks.size(); k++)
+			sim->add_landmark(landmarks[k][0], landmarks[k][1]);
+		for(unsigned int p = 0; p < pipes.size(); p++)
+			sim->add_pipe(pipes[p][0], pipes[p][1], pipes[p][2], pipes[p][3]);
+		sim->homing(homing);
+		sim->gvlearn(gvlearn);
+		sim->lvlearn(lvlearn);
+		sim->beta(beta);
+		int num_lv = (lv_units > 0) ? lv_units : sim->e()->n_landmarks();
+		sim->init_controller(neurons, gv_units, (num_lv > 0) ? num_lv : 1, sensory_noise, uncor_noise, leakage, syn_noise);
+		if(inward > 0.)
+			for(int i = 0; i < agents; i++)
+				sim->c(i)->set_inward(int(inward/interval));
+		return sim;
+	};
+
+	/**
+	 * Writes the specification (without sweep axes), so that one grid point can be rerun
+	 *
+	 *  @param (string) filename: specification file
+	 *  @return (void)
+	 */
+	void write(const string& filename) const {
+		ofstream o(filename.c_str());
+		o << "name = " << name << "\nout = " << out << "\ntrials = " << trials << "\nagents = " << agents;
+		o << "\nduration = " << text(duration) << "\ninterval = " << text(interval) << "\ninward = " << text(inward);
+		o << "\ncycles = " << cycles << "\nthreads = " << threads << "\nseed = " << seed << "\nsilent = " << silent;
+		o << "\nrandom_env = " << random_env;
+		if(!world.empty())
+			o << "\nworld = " << world;
+		if(random_world.size() == 3)
+			o << "\nrandom_world = " << text(random_world[0]) << " " << text(random_world[1]) << " " << text(random_world[2]);
+		o << "\nhoming = " << homing << "\ngvlearn = " << gvlearn;
+		o << "\nlvlearn = " << lvlearn << "\nbeta = " << beta << "\nneurons = " << neurons;
+		o << "\ngv_units = " << gv_units << "\nlv_units = " << lv_units << "\nsensory_noise = " << text(sensory_noise);
+		o << "\nuncor_noise = " << text(uncor_noise) << "\nleakage = " << text(leakage) << "\nsyn_noise = " << text(syn_noise) << "\n";
+		write_rows(o, "goal", goals);
+		write_rows(o, "landmark", landmarks);
+		write_rows(o, "pipe", pipes);
+	};
+
+private:
+
+	static string trim(const string& s){
+		size_t first = s.find_first_not_of(" \t\r");
+		if(first == string::npos)
+			return "";
+		return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+	};
+
+	/// shortest text that reads back as the same value
+	static string text(double v){
+		ostringstream o;
+		o.precision(15);
+		o << v;
+		if(atof(o.str().c_str()) != v){
+			o.str("");
+			o.precision(17);
+			o << v;
+		}
+		return o.str();
+	};
+
+	template<class T>
+	static bool number(const string& s, T& value){
+		istringstream in(s);
+		T v;
+		if(!(in >> v) || !(in >> ws).eof())
+			return false;
+		value = v;
+		return true;
+	};
+
+	static bool list(const string& s, unsigned int n, vector<double>& values){
+		istringstream in(s);
+		vector<double> r;
+		double v;
+		while(in >> v)
+			r.push_back(v);
+		if(!(in >> ws).eof() || r.size() != n)
+			return false;
+		values = r;
+		return true;
+	};
+
+	static bool row(const string& s, unsigned int min_n, unsigned int max_n, vector<vector<double> >& rows){
+		istringstream in(s);
+		vector<double> r;
+		double v;
+		while(in >> v)
+			r.push_back(v);
+		if(!(in >> ws).eof() || r.size() < min_n || r.size() > max_n)
+			return false;
+		rows.push_back(r);
+		return true;
+	};
+
+	/// "v1 v2 ..." or "from:step:to" (inclusive, up to round-off)
+	static vector<string> expand(const string& s){
+		vector<string> values;
+		double from, step, to;
+		char c1, c2;
+		istringstream range(s);
+		if((range >> from >> c1 >> step >> c2 >> to) && c1 == ':' && c2 == ':' && (range >> ws).eof()){
+			if(step <= 0. || to < from)
+				return values;
+			for(int i = 0; from + i*step <= to + 1e-9*step; i++)
+				values.push_back(text(from + i*step));
+			return values;
+		}
+		istringstream in(s);
+		string v;
+		while(in >> v)
+			values.push_back(v);
+		return values;
+	};
+
+	static void write_rows(ostream& o, const char* key, const vector<vector<double> >& rows){
+		for(unsigned int i = 0; i < rows.size(); i++){
+			o << key << " =";
+			for(unsigned int j = 0; j < rows[i].size(); j++)
+				o << " " << text(rows[i][j]);
+			o << "\n";
+		}
+	};
+};
+
+
+/**
+ * Sweep Point Result
+ *
+ * 	Summary of one simulation of a sweep
+ *
+ */
+
+struct SweepResult {
+	int point;                          // grid point index
+	int cycle;                          // repetition of the point
+	double expl;                        // exploration rate after the last trial
+	double home_rate;                   // mean homing rate over all trials
+	double goal_rate;                   // mean goal rate over all trials
+	int trial_converge;                 // trials until goal-directed behavior (0: never)
+	double pi_error;                    // mean PI error of the last trial
+};
+
+
+/**
+ * Sweep Class
+ *
+ * 	This class runs all grid points and cycles of an experiment specification
+ * 	on the BatchRunner (one simulation per instance, instances run concurrently
+ * 	on all cores). Instance i = point*cycles + cycle writes into <out>/<i>/
+ * 	together with its specification (experiment.cfg). All grid points use the
+ * 	same seed for the same cycle, so that points are compared on the same noise
+ * 	(and, with random_env, on the same random world).
+ * 	A world given by the specification (world file or random_world) is built
+ * 	once and shared read-only by all simulations (saved to <out>/world.layout).
+ * 	The summary of all instances is written to <out>/sweep.dat.
+ *
+ */
+
+class Sweep {
+public:
+
+	/**
+	 * Constructor
+	 *
+	 *  @param (ExperimentSpec) _spec: experiment with sweep axes
+	 */
+	Sweep(const ExperimentSpec& _spec) : spec(_spec) {};
+
+	/**
+	 * Runs all instances and writes the summary
+	 *
+	 *  @return (vector<SweepResult>) results in instance order
+	 */
+	vector<SweepResult> run(){
+		BatchRunner batch(spec.out, spec.seed, spec.threads);
+		int points = spec.num_points();
+		int cycles = spec.cycles;
+		vector<uint64_t> cycle_seed(cycles);
+		for(int c = 0; c < cycles; c++)
+			cycle_seed[c] = batch.instance(c).seed;
+		printf("Run %s: %d points x %d cycles on %d threads.\n", spec.name.c_str(), points, cycles, batch.num_threads());
+
+		/// one world for all simulations, built or read once
+		shared_ptr<const WorldLayout> world = spec.shared_world();
+		if(!spec.world.empty() && !world)
+			printf("WARNING: Cannot read world %s, simulations use their own.\n", spec.world.c_str());
+		if(world)
+			world->save(spec.out + "world.layout");
+
+		const ExperimentSpec& s = spec;
+		vector<SweepResult> results = batch.run(points*cycles, [&s, &cycle_seed, &world, cycles](const BatchInstance& inst){
+			SweepResult result;
+			result.point = inst.index / cycles;
+			result.cycle = inst.index % cycles;
+			ExperimentSpec point = s.at(result.point);
+			point.write(inst.dir + "experiment.cfg");
+			Simulation* sim = point.build(inst.dir, cycle_seed[result.cycle], world);
+			sim->run(point.trials, point.duration, point.interval);
+			result.expl = sim->expl_rate.back();
+			result.home_rate = mean_of(sim->home_rate);
+			result.goal_rate = mean_of(sim->goal_rate);
+			result.trial_converge = sim->trial_converge;
+			result.pi_error = sim->pi_error.mean();
+			delete sim;
+			return result;
+		});
+		write(results, spec.out + "sweep.dat");
+		return results;
+	};
+
+	/**
+	 * Writes one row per instance: index, point, cycle, swept values and summary
+	 *
+	 *  @param (vector<SweepResult>) results: results in instance order
+	 *  @param (string) filename: output file
+	 *  @return (void)
+	 */
+	void write(const vector<SweepResult>& results, const string& filename) const {
+		ofstream o(filename.c_str());
+		o << "#index\tpoint\tcycle";
+		for(unsigned int a = 0; a < spec.axis_keys.size(); a++)
+			o << "\t" << spec.axis_keys[a];
+		o << "\texpl\thome_rate\tgoal_rate\ttrial_converge\tpi_error\n";
+		for(unsigned int i = 0; i < results.size(); i++){
+			const SweepResult& r = results[i];
+			o << i << "\t" << r.point << "\t" << r.cycle;
+			for(unsigned int a = 0; a < spec.axis_keys.size(); a++)
+				o << "\t" << spec.value(r.point, a);
+			o << "\t" << r.expl << "\t" << r.home_rate << "\t" << r.goal_rate << "\t" << r.trial_converge << "\t" << r.pi_error << "\n";
+		}
+	};
+
+private:
+
+	static double mean_of(const vector<double>& v){
+		double sum = 0.;
+		for(unsigned int i = 0; i < v.size(); i++)
+			sum += v[i];
+		return v.empty() ? 0. : sum/v.size();
+	};
+
+	ExperimentSpec spec;                            // experiment with sweep axes
+};
+
+
+#endif /* EXPERIMENT_H_ */
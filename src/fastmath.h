@@ -0,0 +1,145 @@
+/*****************************************************************************
+ *  fastmath.h                                                               *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef FASTMATH_H_
+#define FASTMATH_H_
+
+#include <cmath>
+using namespace std;
+
+
+/**
+ * Precise Math Policy
+ *
+ * 	Trigonometric functions of the standard library (reference results)
+ *
+ */
+
+struct PreciseMath {
+	static double sin(double x){ return std::sin(x); }
+	static double cos(double x){ return std::cos(x); }
+	static double atan2(double y, double x){ return std::atan2(y, x); }
+	static void sincos(double x, double& s, double& c){ s = std::sin(x); c = std::cos(x); }
+	static const bool fast = false;
+};
+
+
+/**
+ * Fast Math Policy
+ *
+ * 	Table-driven sine/cosine and polynomial arctangent with bounded error:
+ *
+ * 	sin, cos: nearest entry of a 1024-point table of sin/cos and a
+ * 		second-order Taylor step from it (|d| <= pi/1024),
+ * 		absolute error <= |d|^3/6 < 5e-9 for |x| < 1e6
+ * 	atan2: octant reduction and the minimax polynomial of Abramowitz &
+ * 		Stegun 4.4.49, absolute error < 2e-8 rad
+ *
+ * 	Arguments outside |x| < 1e6 (and NaN) fall back to the standard library.
+ *
+ */
+
+struct FastMath {
+	static const int table_size = 1024;				// entries per period (power of two)
+	static const bool fast = true;
+
+	static double sin(double x){
+		double s, c;
+		sincos(x, s, c);
+		return s;
+	}
+
+	static double cos(double x){
+		double s, c;
+		sincos(x, s, c);
+		return c;
+	}
+
+	/// sine and cosine of x with one table lookup
+	static void sincos(double x, double& s, double& c){
+		if(!(fabs(x) < 1e6)){
+			s = std::sin(x);
+			c = std::cos(x);
+			return;
+		}
+		const Table& t = table();
+		double k = floor(x*(table_size/(2.*M_PI)) + 0.5);
+		double d = x - k*(2.*M_PI/table_size);
+		int i = int((long long)(k) & (table_size-1));
+		double s0 = t.sin_[i];
+		double c0 = t.cos_[i];
+		s = s0 + d*(c0 - 0.5*d*s0);
+		c = c0 - d*(s0 + 0.5*d*c0);
+	}
+
+	static double atan2(double y, double x){
+		double ax = fabs(x);
+		double ay = fabs(y);
+		if(ax == 0. && ay == 0.)
+			return std::atan2(y, x);				// signed zeros
+		if(!(ax < 1e300 && ay < 1e300))
+			return std::atan2(y, x);				// inf, NaN
+		bool swap = ay > ax;
+		double z = swap ? ax/ay : ay/ax;			// z in [0,1]
+		double z2 = z*z;
+		double r = z*(1. + z2*(-0.3333314528 + z2*(0.1999355085 + z2*(-0.1420889944 + z2*(0.1065626393
+				+ z2*(-0.0752896400 + z2*(0.0429096138 + z2*(-0.0161657367 + z2*0.0028662257))))))));
+		if(swap)
+			r = 0.5*M_PI - r;
+		if(x < 0.)
+			r = M_PI - r;
+		return (y < 0.) ? -r : r;
+	}
+
+private:
+	struct Table {
+		double sin_[table_size];
+		double cos_[table_size];
+		Table(){
+			for(int i = 0; i < table_size; i++){
+				sin_[i] = std::sin(2.*M_PI*i/table_size);
+				cos_[i] = std::cos(2.*M_PI*i/table_size);
+			}
+		}
+	};
+
+	static const Table& table(){
+		static const Table t;
+		return t;
+	}
+};
+
+
+/*** Compile-time choice of the trigonometric policy used in the control loop (-DNAVISIM_FAST_MATH) ***/
+#ifdef NAVISIM_FAST_MATH
+typedef FastMath Trig;
+#else
+typedef PreciseMath Trig;
+#endif
+
+
+#endif /* FASTMATH_H_ */
@@ -12,6 +12,7 @@
 #include <cmath>
 #include <cstdio>
 #include <vector>
+#include "fastmath.h"
 using namespace std;
 
 /**
@@ -23,168 +24,80 @@ using namespace std;
 
 enum aunit{inRad,inDeg,inGon};
 
+/**
+ *  Angle is a plain value type: the angle is stored once in radians,
+ *  wrapped to [0, 2pi), and degrees/gons are computed on demand.
+ *  It holds no heap memory and is trivially copyable.
+ */
+
 class Angle {
 public:
-	Angle()
-	{
-		val.resize(3);
-		vmax.resize(3);
-		vmin.resize(3);
-
-		vmin.at(inRad) = 0.;
-		vmax.at(inRad) = 2.*M_PI;
-		vmin.at(inDeg) = 0.;
-		vmax.at(inDeg) = 360.;
-		vmin.at(inGon) = 0.;
-		vmax.at(inGon) = 200.;
-
-
-		rad_ = &val.at(inRad);
-		deg_ = &val.at(inDeg);
-		gon_ = &val.at(inGon);
-
-		for(int x=inRad; x<=inDeg; x++)
-			val.at(x) = 0.;
-	}
-	Angle(double _val)
-	{
-		val.resize(3);
-		vmax.resize(3);
-		vmin.resize(3);
-
-		vmin.at(inRad) = 0.;
-		vmax.at(inRad) = 2.*M_PI;
-		vmin.at(inDeg) = 0.;
-		vmax.at(inDeg) = 360.;
-		vmin.at(inGon) = 0.;
-		vmax.at(inGon) = 200.;
-
-		rad_ = &val.at(inRad);
-		deg_ = &val.at(inDeg);
-		gon_ = &val.at(inGon);
-
-		val.at(inRad) = fmod(_val,(vmax.at(inRad)));
-		if(val.at(inRad) >= vmax.at(inRad))
-			val.at(inRad) -= vmax.at(inRad);
-		convertTo(val.at(inRad), inRad);
-	}
-	Angle(double _val, int _unit)
-	{
-		val.resize(3);
-		vmax.resize(3);
-		vmin.resize(3);
-
-		vmin.at(inRad) = 0.;
-		vmax.at(inRad) = 2.*M_PI;
-		vmin.at(inDeg) = 0.;
-		vmax.at(inDeg) = 360.;
-		vmin.at(inGon) = 0.;
-		vmax.at(inGon) = 400.;
-
-		rad_ = &val.at(inRad);
-		deg_ = &val.at(inDeg);
-		gon_ = &val.at(inGon);
-
-		val.at(_unit) = fmod(_val,(vmax.at(_unit)));
-		if(val.at(_unit) >= vmax.at(_unit))
-			val.at(_unit) -= vmax.at(_unit);
-		convertTo(val.at(_unit), _unit);
-	}
+	constexpr Angle() : rad_(0.) {}
+	Angle(double _val) : rad_(wrap(_val, 2.*M_PI)) {}
+	Angle(double _val, int _unit) : rad_(toRad(wrap(_val, period(_unit)), _unit)) {}
 
-	double C(){return cos(rad());}
-
-	void convertTo(double _val, int _unit){
-		if(_unit == inRad){
-			val.at(inDeg) = _val*180./M_PI;
-			val.at(inGon) = _val*200./M_PI;
-		}
-		if(_unit == inDeg){
-			val.at(inRad) = _val*M_PI/180.;
-			val.at(inGon) = _val*200./180.;
-		}
-		if(_unit == inGon){
-			val.at(inRad) = _val*M_PI/200.;
-			val.at(inDeg) = _val*180./200.;
-
-		}
-	}
+	/// trigonometric functions use the Trig policy (fastmath.h), unless another policy is given
+	template<class M = Trig> double C() const {return M::cos(rad_);}
 
-	double Cos(){return cos(rad());}
+	template<class M = Trig> double Cos() const {return M::cos(rad_);}
 
-	double deg(){return *deg_;}
+	double deg() const {return rad_*180./M_PI;}
 
-	double fmod(double _x, double _y){
-		if(_x > 0.)
-			return std::fmod(_x,_y);
-		else
-			return std::fmod(_x,_y) + _y;
+	/// wraps _x into [0, _y); values in (-_y, 0] are shifted up by one period
+	static double wrap(double _x, double _y){
+		double r = std::fmod(_x,_y);
+		r += (r <= 0.) * _y;
+		r -= (r >= _y) * _y;
+		return r;
 	}
 
-	double gon(){return *gon_;}
+	double gon() const {return rad_*200./M_PI;}
 
-	Angle i(){return Angle(this->rad() + M_PI);}
+	Angle i() const {return Angle(rad_ + M_PI);}
 
-	Angle inv(){return Angle(this->rad() + M_PI);}
+	Angle inv() const {return Angle(rad_ + M_PI);}
 
 	friend Angle operator+(Angle lhs, Angle rhs)
 	{
-		double number = lhs.rad() + rhs.rad();
-		Angle ra(number);
-		return ra;
+		return Angle(lhs.rad_ + rhs.rad_);
 	}
 	friend Angle operator-(Angle lhs, Angle rhs)
 	{
-		double number = lhs.rad() - rhs.rad();
-		Angle ra(number);
-		return ra;
+		return Angle(lhs.rad_ - rhs.rad_);
 	}
-	Angle operator*(double f)
+	Angle operator*(double f) const
 	{
-		double number = rad()*f;
-		Angle ra(number);
-		return ra;
+		return Angle(rad_*f);
 	}
-	Angle operator/(double f)
+	Angle operator/(double f) const
 	{
-		double number = rad()/f;
-		Angle ra(number);
-		return ra;
+		return Angle(rad_/f);
 	}
 	friend ostream& operator<<(ostream& out, const Angle& a) // output
 	{
-	    out << *(a.rad_);
+	    out << a.rad_;
 	    return out;
 	}
 
-	double rad(){return *rad_;}
+	constexpr double rad() const {return rad_;}
 
-	double S(){return sin(rad());}
+	template<class M = Trig> double S() const {return M::sin(rad_);}
 
 	void to(double _val, int _unit = inRad){
-		val.at(_unit) = _val;
-		if(_unit == inRad){
-			val.at(inDeg) = _val*180./M_PI;
-			val.at(inGon) = _val*200./M_PI;
-		}
-		if(_unit == inDeg){
-			val.at(inRad) = _val*M_PI/180.;
-			val.at(inGon) = _val*200./180.;
-		}
-		if(_unit == inGon){
-			val.at(inRad) = _val*M_PI/200.;
-			val.at(inDeg) = _val*180./200.;
-		}
+		rad_ = toRad(_val, _unit);
 	}
 
-	double Sin(){return sin(rad());}
+	template<class M = Trig> double Sin() const {return M::sin(rad_);}
 
 private:
-	double* deg_;
-	double* gon_;
-	double* rad_;
-	vector<double> val;
-	vector<double> vmax;
-	vector<double> vmin;
+	static constexpr double period(int _unit){
+		return (_unit == inDeg) ? 360. : ((_unit == inGon) ? 400. : 2.*M_PI);
+	}
+	static constexpr double toRad(double _val, int _unit){
+		return (_unit == inDeg) ? _val*M_PI/180. : ((_unit == inGon) ? _val*M_PI/200. : _val);
+	}
+
+	double rad_;
 };
 
 /**
@@ -199,19 +112,19 @@ public:
 	Vec(){ x=y=z=0.; array[0]=array[1]=array[2]=0.; const_vec=false;}
 	Vec(double _x, double _y){	x=_x; y=_y; z=0.; array[0]=array[1]=array[2]=0.; const_vec=false;}
 	Vec(double _x, double _y, double _z){	x=_x; y=_y; z=_z; array[0]=array[1]=array[2]=0.; const_vec=false;}
-	~Vec(){}
 
-	Angle ang(){ return azimuth();}
-	Angle azimuth() {
-		if(isfinite(atan2(y,x)))
-			return Angle(atan2(y,x));
+	template<class M = Trig> Angle ang() const { return azimuth<M>();}
+	template<class M = Trig> Angle azimuth() const {
+		double phi = M::atan2(y,x);
+		if(isfinite(phi))
+			return Angle(phi);
 		else
 			return Angle(0.0);
 	}
-	Angle elevation() { return Angle(atan2(z, len())); }
-	Vec i(){return Vec(-x,-y);}
-	double len() { return sqrt(x*x+y*y+z*z); }
-	bool lock(){ return const_vec; }
+	Angle elevation() const { return Angle(atan2(z, len())); }
+	Vec i() const {return Vec(-x,-y);}
+	double len() const { return sqrt(x*x+y*y+z*z); }
+	bool lock() const { return const_vec; }
 	void lock(bool _in){ const_vec = _in; }
 
 	void move(double _dx, double _dy, double _dz=0) { x+=_dx; y+=_dy; z+=_dz; }
@@ -48,6 +48,8 @@ Goal::Goal(double max_radius, bool in_verbose, int color, double size, bool deca
 	//bool s = sample(prob_blue);			// Sampling with probability for blue
 	//amount = (s ? 0.0 : 1.0);
 	goal_type = color;//(s ? 0 : 1);
+	arrays = nullptr;
+	index = -1;
 }
 
 Goal::Goal(double x, double y, bool in_verbose, int color, double size, bool decay):
@@ -61,29 +63,51 @@ Goal::Goal(double x, double y, bool in_verbose, int color, double size, bool dec
 		amount_rate = 0.0;
 	goal_type = color;
 	//amount = (goal_type ? 1.0 : 0.25);
+	arrays = nullptr;
+	index = -1;
 }
 
 Goal::~Goal(){
 
 }
 
+int Goal::bind(GoalArrays* _arrays){
+	index = _arrays->add(pos.x, pos.y, amount, amount_rate, goal_type);
+	arrays = _arrays;
+	return index;
+}
+
 double Goal::a(){
+	if(arrays)
+		return arrays->amount[index];
 	return amount;
 }
 
 void Goal::a(const double value){
-	amount = value;
+	if(arrays)
+		arrays->amount[index] = value;
+	else
+		amount = value;
 }
 
 int Goal::color(){
+	if(arrays)
+		return arrays->color[index];
 	return goal_type;
 }
 
 void Goal::color(const int value){
-	goal_type = value;
+	if(arrays)
+		arrays->color[index] = value;
+	else
+		goal_type = value;
 }
 
 void Goal::da(){
+	if(arrays){
+		arrays->da(index);
+		return;
+	}
 	amount -= amount_rate;
 	if(amount<0.0)
 		amount = 0.0;
@@ -92,23 +116,18 @@ void Goal::da(){
 double Goal::r(double x, double y, int mode){   //TODO move to environment
 	if(d(x,y) < goal_radius && mode == 0){         //20 cm radius
 		//factor = in_factor;
-		amount -= amount_rate;
+		da();
 		//total_hits++;
-		if(amount < 0.0){
-			amount = 0.0;
-			//hit = 0;
-			//total_hits--;
-		}
 		//printf("Reward @ (%f, %f) = %f\n", x, y, amount);
-		return (1./goal_radius)*(goal_radius-d(x,y))*amount*(1./d());
+		return (1./goal_radius)*(goal_radius-d(x,y))*a()*(1./d());
 	}
 	else
 		return 0.0;
 }
 
 double Goal::rand(double min, double max){
-	static random_device e{};
-	static uniform_real_distribution<double> d(min, max);
+	thread_local random_device e{};
+	thread_local uniform_real_distribution<double> d(min, max);
 	return d(e);
 }
 
@@ -121,5 +140,5 @@ bool Goal::sample(double P){
 }
 
 void Goal::swap(){
-	amount = 1. - amount;
+	a(1. - a());
 }
@@ -29,9 +29,62 @@
 #define GOAL_H_
 
 #include "object.h"
+#include <vector>
 using namespace std;
 
 
+/**
+ * Goal Arrays
+ *
+ * 	Structure-of-arrays storage of the goals of an environment.
+ * 	Positions and reward state are held contiguously, so that the
+ * 	collision and reward loops run over plain arrays.
+ *
+ */
+
+struct GoalArrays {
+	vector<double> x;						// x positions
+	vector<double> y;						// y positions
+	vector<double> amount;					// amount of reward
+	vector<double> amount_rate;				// rate of reward loss
+	vector<int> color;						// goal type (color index)
+
+	/**
+	 * Appends a goal and returns its index
+	 *
+	 * @return (int)
+	 */
+	int add(double _x, double _y, double _amount, double _rate, int _color){
+		x.push_back(_x);
+		y.push_back(_y);
+		amount.push_back(_amount);
+		amount_rate.push_back(_rate);
+		color.push_back(_color);
+		return x.size()-1;
+	}
+
+	/**
+	 * Decreases the amount of reward stored at goal j
+	 *
+	 * @return (void)
+	 */
+	void da(int j){
+		amount[j] -= amount_rate[j];
+		if(amount[j]<0.0)
+			amount[j] = 0.0;
+	}
+
+	/**
+	 * Returns the number of goals
+	 *
+	 * @return (int)
+	 */
+	int size() const {
+		return x.size();
+	}
+};
+
+
 /**
  * Goal Class
  *
@@ -75,6 +128,15 @@ public:
 
 	//************ Class functions ************//
 
+	/**
+	 * Moves the reward state of the goal into the given arrays;
+	 * afterwards the goal is a view on its entry (position is fixed)
+	 *
+	 *	@param (GoalArrays*) _arrays: goal storage of the environment
+	 *	@return (int) index of the goal in the arrays
+	 */
+	int bind(GoalArrays* _arrays);
+
 	/**
 	 * Returns the amount of reward stored at the goal
 	 *
@@ -157,6 +219,8 @@ private:
 	double amount_rate;			// rate of reward loss
 	int goal_type;				// color
 	const double goal_radius = 0.2;
+	GoalArrays* arrays;			// storage the goal is bound to (nullptr if unbound)
+	int index;					// index in arrays
 
 	//************ Debugging ************//
 	bool VERBOSE;
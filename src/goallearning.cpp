@@ -29,7 +29,8 @@
 using namespace std;
 
 
-GoalLearning::GoalLearning(int num_neurons, double nnoise, double* forage, bool opt_load, bool in_silent) : CircArray(num_neurons,1) {
+GoalLearning::GoalLearning(int num_neurons, double nnoise, double* forage, bool opt_load, bool in_silent, const string& out_dir) : CircArray(num_neurons,1) {
+	path = out_dir;
 	SILENT = in_silent;
 	type = 1;
 	threshold = 3.*nnoise;
@@ -43,8 +44,9 @@ GoalLearning::GoalLearning(int num_neurons, double nnoise, double* forage, bool
 	load_weights = opt_load;
 	new_vector_avg.resize(1);
 	white_weights.zeros(N,K);
+	weight_change.zeros(N,K);
 	if(load_weights)
-		w().load("./save/goalweights.mat", raw_ascii);
+		w().load(path + "save/goalweights.mat", raw_ascii);
 
 	if(!SILENT){
 		printf("=== GV learning parameters ===\n");
@@ -59,7 +61,16 @@ GoalLearning::GoalLearning(int num_neurons, double nnoise, double* forage, bool
 }
 
 GoalLearning::~GoalLearning(){
-	w().save("./save/goalweights.mat", raw_ascii);
+	w().save(path + "save/goalweights.mat", raw_ascii);
+}
+
+void GoalLearning::checkpoint(Checkpoint& cp){
+	CircArray::checkpoint(cp);
+	cp.io(global_vector);
+	cp.pod(reward);
+	cp.pod(expl_rate);
+	cp.io(white_weights);
+	cp.io(weight_change);
 }
 
 mat GoalLearning::dW(){
@@ -97,10 +108,10 @@ void GoalLearning::update(vec pi_input, double in_reward, double in_expl){
 	vec input = (1. - *foraging_state)*ones<vec>(K);
 	update_rate(input_conns*input);
 	update_weights(pi_input);
-	set_avg(update_avg(input_conns.col(0)));
-	set_len(update_len(input_conns.col(0)));
-	set_max(update_max(input_conns.col(0)));
-	new_vector_avg.at(0) = vector_avg(input_conns.col(0));
+	PopulationCode code;
+	decode(input_conns.colptr(0), code);
+	set_code(code.pva, code);
+	new_vector_avg.at(0) = code.avg;
 
 	if(input_conns.max() > 10000 || input_conns.min() < -1000)
 		printf("Eta = %g\tR = %g\texp = %g\n", 1.-*foraging_state, reward, expl_rate);
@@ -109,13 +120,16 @@ void GoalLearning::update(vec pi_input, double in_reward, double in_expl){
 	//printf("(x,y) = (%g,%g)\tlen = %g\tavg = %g\n", GV(0).x, GV(0).y, len(), avg().deg());
 }
 
-void GoalLearning::update_weights(vec pi_input){
+void GoalLearning::update_weights(const vec& pi_input){
 	//printf("%u / %u X %u\n", pi_input.n_elem, input_conns.n_rows, input_conns.n_cols);
-	weight_change = learn_rate * reward /* expl_rate*/ * (1. - *foraging_state) * (pi_input-input_conns);// - /*0.0000004*/0.000001*input_conns;
-	white_weights += weight_change;
-	white_weights.elem( find(white_weights < 0.0) ).zeros();
-
-	input_conns = white_weights+randu<vec>(N)*neural_noise;
+	const double eta = learn_rate * reward /* expl_rate*/ * (1. - *foraging_state);
+	for(int j = 0; j < K; j++){
+		const double* w = input_conns.colptr(j);
+		double* dw = weight_change.colptr(j);
+		for(int i = 0; i < N; i++)
+			dw[i] = eta * (pi_input(i) - w[i]);// - /*0.0000004*/0.000001*input_conns;
+	}
+	apply_weight_change(white_weights, weight_change, neural_noise);
 }
 
 Angle GoalLearning::vec_avg(){
@@ -52,8 +52,9 @@ public:
 	 *  @param (int) input_dim: number of incoming signals (default: 0)
 	 *  @param (double*) forage: pointer to agent's foraging state
 	 *  @param (bool) opt_load: true, if loading learned weights from file
+	 *  @param (string) out_dir: directory containing save/ (default: "./")
 	 */
-	GoalLearning(int num_neurons, double nnoise, double* forage, bool opt_load=false, bool in_silent=false);
+	GoalLearning(int num_neurons, double nnoise, double* forage, bool opt_load=false, bool in_silent=false, const string& out_dir="./");
 
 	/**
 	 * Destructor
@@ -61,6 +62,14 @@ public:
 	 */
 	~GoalLearning();
 
+	/**
+	 * Writes or reads the state of the learning circuit (weights, global vectors and the last reward)
+	 *
+	 * @param (Checkpoint&) cp: snapshot file
+	 * @return (void)
+	 */
+	void checkpoint(Checkpoint& cp);
+
 	/**
 	 * Return weight change matrix
 	 *
@@ -126,7 +135,7 @@ public:
 	 *  @param (double) speed: Input walking speed from odometry (legged: "differential step counter")
 	 *  @return (void)
 	 */
-	void update_weights(vec pi_input);
+	void update_weights(const vec& pi_input);
 
 	/**
 	 * Return vector average of circular array activity
@@ -164,6 +173,7 @@ private:
 	mat weight_change;
 
 	bool load_weights;
+	string path;
 	bool no_learning;
 };
 
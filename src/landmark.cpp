@@ -50,8 +50,8 @@ Landmark::~Landmark(){
 }
 
 double Landmark::rand(double min, double max){
-	static random_device e{};
-	static uniform_real_distribution<double> d(min, max);
+	thread_local random_device e{};
+	thread_local uniform_real_distribution<double> d(min, max);
 	return d(e);
 }
 
@@ -29,8 +29,41 @@
 #define LANDMARK_H_
 
 #include "object.h"
+#include <vector>
 using namespace std;
 
+/**
+ * Landmark Arrays
+ *
+ * 	Structure-of-arrays storage of the landmark positions of an environment
+ *
+ */
+
+struct LandmarkArrays {
+	vector<double> x;						// x positions
+	vector<double> y;						// y positions
+
+	/**
+	 * Appends a landmark and returns its index
+	 *
+	 * @return (int)
+	 */
+	int add(double _x, double _y){
+		x.push_back(_x);
+		y.push_back(_y);
+		return x.size()-1;
+	}
+
+	/**
+	 * Returns the number of landmarks
+	 *
+	 * @return (int)
+	 */
+	int size() const {
+		return x.size();
+	}
+};
+
 /**
  * Landmark Class
  *
@@ -31,14 +31,18 @@ PIN::PIN(int num_neurons, double leak, double sens_noise, double neur_noise, boo
 	t_step = 0;
 	SILENT = in_silent;
 	VERBOSE = false;
+	leak_rate = leak;
+	snoise = sens_noise;
+	nnoise = neur_noise;
+	sensed_angle = 0.0;
+	sensed_speed = 0.0;
+	neuron_noise.zeros(N);
+	batch = nullptr;
 	if(!SILENT){
 		printf("=== PI parameters ============\n");
 		printf("Neurons: %u\n", N);
-		leak_rate = leak;
 		printf("Leak: %g\n", leak_rate);
-		snoise = sens_noise;
 		printf("Sensory noise: %g\n", snoise);
-		nnoise = neur_noise;
 		printf("Uncorrelated noise: %g\n", nnoise);
 		printf("==============================\n\n");
 	}
@@ -50,7 +54,7 @@ PIN::PIN(int num_neurons, double leak, double sens_noise, double neur_noise, boo
 		CircArray* array = new CircArray(N,N);
 		ar.push_back(array);
 	}
-	w_cos = ar.at(PI)->cos_kernel();
+	w_cos = ar.at(PI)->cos_kernel_op();
 }
 
 PIN::~PIN(){
@@ -58,6 +62,23 @@ PIN::~PIN(){
 		delete ar.at(i);
 }
 
+bool PIN::batched(){
+	return batch != nullptr;
+}
+
+void PIN::checkpoint(Checkpoint& cp){
+	CircArray::checkpoint(cp);
+	cp.check(ar.size(), "PI layers");
+	for(int i = 0; i < ar.size(); i++)
+		ar.at(i)->checkpoint(cp);
+	cp.io(home_vector);
+	cp.io(home_vector_max);
+	cp.pod(t_step);
+	cp.pod(sensed_angle);
+	cp.pod(sensed_speed);
+	cp.io(neuron_noise);
+}
+
 CircArray* PIN::array(int i){
 	return ar.at(i);
 }
@@ -66,6 +87,14 @@ vec PIN::get_output(){
 	return ar.at(PI)->rate();
 }
 
+const vec& PIN::output_ref(){
+	return ar.at(PI)->rate_ref();
+}
+
+int PIN::kernel_type(){
+	return w_cos.type;
+}
+
 Vec PIN::HV(){
 	return home_vector;
 }
@@ -79,44 +108,71 @@ void PIN::reset(){
 }
 
 void PIN::update(Angle angle, double speed){
+	sense(angle, speed);
+	integrate();
+	decode();
+}
+
+void PIN::sense(Angle angle, double speed){
 	t_step++;
 	//---Sensory Noise
 	Angle noisy_angle = angle + Angle(2.*M_PI*snoise*boost_noise(1.));
 	double noisy_speed = speed + 0.1*snoise*boost_noise(1.);
 	if(noisy_speed < 0.0)
 		noisy_speed = 0.0;
+	sensed_angle = noisy_angle.rad();
+	sensed_speed = noisy_speed;
+	//---Neural noise of the head direction layer (drawn in neuron order)
+	if(nnoise > 0.0)
+		for(int i = 0; i < N; i++)
+			neuron_noise(i) = rng->normal(0.0, nnoise);
+}
 
-	//---Layer 1 -> Head Direction Layer
-	vec input = cos(noisy_angle.rad()*ones<vec>(N) - preferred_angle)*(-0.5) + 0.5*ones<vec>(N) + vnoise(N,nnoise);
-	// Multiplicative modulation:
-	//vec input = cos(noisy_angle.rad()*ones<vec>(N) - preferred_angle) + vnoise(N,nnoise);
-
-	ar.at(HD)->update_rate(input);
+void PIN::integrate(){
+	//--- Layers are one-to-one (identity connections), so they are updated
+	//--- elementwise and in place on the arrays' rate vectors
+	double* hd = ar.at(HD)->rate_ref().memptr();
+	double* gater = ar.at(G)->rate_ref().memptr();
+	double* memory = ar.at(M)->rate_ref().memptr();
+	const double theta = sensed_angle;
+	const double noisy_speed = sensed_speed;
+	const double retain = 1.0 - leak_rate;
+	cos_tuning(theta, hd);
+	for(int i = 0; i < N; i++){
+		//---Layer 1 -> Head Direction Layer
+		hd[i] = hd[i]*(-0.5) + 0.5;
+		if(nnoise > 0.0)
+			hd[i] += neuron_noise(i);
+		// Multiplicative modulation:
+		//hd[i] = cos(theta - preferred_angle(i)) + noise;
 
-	//---Layer 2 -> Gater Layer
-	ar.at(G)->update_rate(lin_rect(-eye<mat>(N,N)*ar.at(HD)->rate()+(noisy_speed)*ones<vec>(N)) /*+ vnoise(N,nnoise)*/);
-	// Multiplicative modulation:
-	//vec gater_input = eye<mat>(N,N)*ar.at(HD)->rate();
-	//ar.at(G)->update_rate( lin_rect(gater_input*noisy_speed) );
+		//---Layer 2 -> Gater Layer
+		gater[i] = -hd[i] + noisy_speed;
+		if(gater[i] < 0.0)
+			gater[i] = 0.0;
+		// Multiplicative modulation:
+		//gater[i] = hd[i]*noisy_speed;
 
-	//---Layer 3 -> Memory Layer
-	ar.at(M)->update_rate(lin_rect(eye<mat>(N,N)*ar.at(G)->rate() + (1.0-leak_rate)*eye<mat>(N,N)*ar.at(M)->rate()) /*+ vnoise(N,nnoise)*/);
+		//---Layer 3 -> Memory Layer
+		memory[i] = gater[i] + retain*memory[i];
+		if(memory[i] < 0.0)
+			memory[i] = 0.0;
+	}
 	//---Layer 4 -> Vector Decoding Layer
-	ar.at(PI)->update_rate(lin_rect(w_cos * ar.at(M)->rate()) /*+ vnoise(N,nnoise)*/);
+	vec& decoded = ar.at(PI)->rate_ref();
+	w_cos.apply(ar.at(M)->rate_ref(), decoded);
+	lin_rect_inplace(decoded);
+}
 
+void PIN::decode(){
 	//Output parameters
-	vec out = ar.at(PI)->rate();
+	const vec& out = ar.at(PI)->rate_ref();
 
 	//*** Update vector representation ***//
-	/// home vector TODO
-	Angle hv_angle = vector_avg(out);
-	Angle hv_angle_new = pva_angle(out);
-	double hv_len = pva_len(out);
-	//local_vector.to(lv_len*lv_angle.C(), lv_len*lv_angle.S());
-
-	update_piavg(out);
-	update_pilen(out);
-	set_max(update_max(out), 0);
+	/// home vector: bump average, length and maximum decoded in one sweep
+	PopulationCode code;
+	CircArray::decode(out.memptr(), code);
+	set_code(code.bump, code);
 	home_vector.to(len()*avg().C(), len()*avg().S());
 	home_vector_max.to(len()*max().C(), len()*max().S());
 }
@@ -128,3 +184,95 @@ double PIN::x(){
 double PIN::y(){
 	return home_vector.y;
 }
+
+PINBatch::PINBatch(const vector<PIN*>& _pins){
+	pins = _pins;
+	if(!compatible(pins)){
+		/// layers are bound as columns of one size and share the kernel of the first network
+		printf("WARNING: Batched networks differ in size or decoding kernel. Nothing is batched.\n");
+		pins.clear();
+	}
+	int A = pins.size();
+	N = (A > 0) ? pins.at(0)->N : 0;
+	hd.zeros(N, A);
+	gater.zeros(N, A);
+	memory.zeros(N, A);
+	decoded.zeros(N, A);
+	theta.zeros(A);
+	speed.zeros(A);
+	retain.zeros(A);
+	for(int a = 0; a < A; a++){
+		pins.at(a)->ar.at(HD)->bind_rate(hd.colptr(a));
+		pins.at(a)->ar.at(G)->bind_rate(gater.colptr(a));
+		pins.at(a)->ar.at(M)->bind_rate(memory.colptr(a));
+		pins.at(a)->ar.at(PI)->bind_rate(decoded.colptr(a));
+		pins.at(a)->batch = this;
+	}
+}
+
+PINBatch::~PINBatch(){
+	for(unsigned int a = 0; a < pins.size(); a++){
+		for(int layer = HD; layer <= PI; layer++)
+			pins.at(a)->ar.at(layer)->release_rate();
+		pins.at(a)->batch = nullptr;
+	}
+}
+
+bool PINBatch::compatible(const vector<PIN*>& _pins){
+	for(unsigned int a = 1; a < _pins.size(); a++)
+		if(_pins[a]->N != _pins[0]->N || _pins[a]->kernel_type() != _pins[0]->kernel_type())
+			return false;
+	return true;
+}
+
+bool PINBatch::binds(const vector<PIN*>& _pins){
+	return pins == _pins;
+}
+
+int PINBatch::size(){
+	return pins.size();
+}
+
+void PINBatch::update(){
+	const int A = pins.size();
+	if(A == 0)
+		return;
+	for(int a = 0; a < A; a++){
+		theta(a) = pins[a]->sensed_angle;
+		speed(a) = pins[a]->sensed_speed;
+		retain(a) = 1.0 - pins[a]->leak_rate;
+	}
+
+	//--- Layers 1-3 for all agents (same operations as PIN::integrate)
+	for(int a = 0; a < A; a++){
+		double* h = hd.colptr(a);
+		double* g = gater.colptr(a);
+		double* m = memory.colptr(a);
+		const double th = theta(a);
+		const double v = speed(a);
+		const double r = retain(a);
+		pins[0]->cos_tuning(th, h);
+		for(int i = 0; i < N; i++)
+			h[i] = h[i]*(-0.5) + 0.5;
+		if(pins[a]->nnoise > 0.0){
+			const double* noise = pins[a]->neuron_noise.memptr();
+			for(int i = 0; i < N; i++)
+				h[i] += noise[i];
+		}
+		for(int i = 0; i < N; i++){
+			g[i] = -h[i] + v;
+			if(g[i] < 0.0)
+				g[i] = 0.0;
+			m[i] = g[i] + r*m[i];
+			if(m[i] < 0.0)
+				m[i] = 0.0;
+		}
+	}
+
+	//--- Layer 4 for all agents
+	pins[0]->w_cos.apply_cols(memory, decoded);
+	double* out = decoded.memptr();
+	for(int k = 0; k < N*A; k++)
+		if(out[k] < 0.0)
+			out[k] = 0.0;
+}
@@ -39,6 +39,79 @@ using namespace arma;
 
 enum{HD, G, M, PI};    	//HD = Head Direction; G = Gater; M = Memory; PI = Home vector output
 
+class PIN;
+
+/**
+ * Path Integration Batch Class
+ *
+ * 	This class holds the layer rates of the path integration networks of
+ * 	several agents as N x A matrices (one column per agent). The arrays of
+ * 	each bound PIN are views on its columns, so per-agent accessors keep
+ * 	working. update() integrates all agents in one pass: head direction,
+ * 	gater and memory layers column by column, then the decoding kernel
+ * 	over all columns. Each column gets the same arithmetic as PIN::update.
+ *
+ */
+
+class PINBatch {
+public:
+
+	/**
+	 * Constructor
+	 *
+	 *  @param (vector<PIN*>) _pins: networks to be batched (must be compatible, otherwise none is bound)
+	 */
+	PINBatch(const vector<PIN*>& _pins);
+
+	/**
+	 * Returns true, if the networks can share one batch (same number of neurons and decoding kernel)
+	 *
+	 *  @param (vector<PIN*>) _pins: networks to be batched
+	 *  @return (bool)
+	 */
+	static bool compatible(const vector<PIN*>& _pins);
+
+	/**
+	 * Returns true, if the batch holds exactly the given networks in this order
+	 *
+	 *  @param (vector<PIN*>) _pins: networks
+	 *  @return (bool)
+	 */
+	bool binds(const vector<PIN*>& _pins);
+
+	/**
+	 * Destructor. Networks keep their current rates.
+	 *
+	 */
+	~PINBatch();
+
+	/**
+	 * Integrates the sensory input of all networks (see PIN::sense)
+	 *
+	 *  @return (void)
+	 */
+	void update();
+
+	/**
+	 * Returns the number of networks
+	 *
+	 *  @return (int)
+	 */
+	int size();
+
+	mat hd;                                         // Head direction layer (N x A)
+	mat gater;                                      // Gater layer (N x A)
+	mat memory;                                     // Memory layer (N x A)
+	mat decoded;                                    // Vector decoding layer (N x A)
+
+private:
+	vector<PIN*> pins;
+	vec theta;                                      // Noisy compass input per agent
+	vec speed;                                      // Noisy speed input per agent
+	vec retain;                                     // 1 - leak per agent
+	int N;                                          // Number of neurons
+};
+
 
 /**
  * Path Integration Network Class
@@ -71,6 +144,20 @@ public:
 
 	vec get_output();
 
+	/**
+	 * Returns a reference to the output rates of the PI array (no copy)
+	 *
+	 * @return (const vec&)
+	 */
+	const vec& output_ref();
+
+	/**
+	 * Returns the implementation of the decoding kernel
+	 *
+	 * @return (int) dense_kernel, lowrank_kernel or circulant_kernel
+	 */
+	int kernel_type();
+
 	/**
 	 * Return the home vector using average
 	 *
@@ -101,6 +188,45 @@ public:
 	 */
 	void update(Angle angle, double speed);
 
+	/**
+	 * Draws the sensory and neural noise for the next update (first step of update)
+	 *
+	 *  @param (Angle) angle: Input angle from compass
+	 *  @param (double) speed: Input walking speed from odometry
+	 *  @return (void)
+	 */
+	void sense(Angle angle, double speed);
+
+	/**
+	 * Updates the layers from the last sensory input (second step of update; done by PINBatch, if batched)
+	 *
+	 *  @return (void)
+	 */
+	void integrate();
+
+	/**
+	 * Updates the home vectors from the decoding layer (last step of update)
+	 *
+	 *  @return (void)
+	 */
+	void decode();
+
+	/**
+	 * Returns true, if the layers are columns of a PINBatch
+	 *
+	 *  @return (bool)
+	 */
+	bool batched();
+
+	/**
+	 * Writes or reads the state of the network (activities of all layers,
+	 * home vector and the inputs of the last step)
+	 *
+	 *  @param (Checkpoint&) cp: snapshot file
+	 *  @return (void)
+	 */
+	void checkpoint(Checkpoint& cp);
+
 	/**
 	 * Returns the PI x coordinate
 	 *
@@ -119,16 +245,22 @@ public:
 	bool VERBOSE;
 
 private:
+	friend class PINBatch;
 	vector<CircArray*> ar;
 
 	Vec home_vector;
 	Vec home_vector_max;
 
-	mat w_cos;
+	CircKernel w_cos;                               // Cosine decoding kernel (dense, low-rank or FFT)
 	double leak_rate;
 	double snoise;
 	double nnoise;
 	int t_step;
+
+	double sensed_angle;                            // Noisy compass input of the last sense()
+	double sensed_speed;                            // Noisy speed input of the last sense()
+	vec neuron_noise;                               // Noise added to the head direction layer
+	PINBatch* batch;                                // Batch holding the layers (nullptr = own)
 };
 
 
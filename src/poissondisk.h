@@ -0,0 +1,256 @@
+/*****************************************************************************
+ *  poissondisk.h                                                            *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef POISSONDISK_H_
+#define POISSONDISK_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "rng.h"
+#include "spatialgrid.h"
+using namespace std;
+
+
+/**
+ * Poisson Disk Class
+ *
+ * 	This class places random points in the annulus min_radius <= r <=
+ * 	max_radius, more than a given spacing apart and clear of obstacles
+ * 	(e.g., objects of another kind, each with its own distance). Accepted
+ * 	points are kept in a background grid of cell size spacing/sqrt(2), so
+ * 	each candidate is tested against at most 5x5 cells instead of all
+ * 	points placed so far.
+ *
+ * 	Points are first drawn by dart throwing. Once the area is so dense
+ * 	that a number of darts in a row miss, the free space is filled with
+ * 	Bridson's algorithm (candidates in the ring spacing..2*spacing around
+ * 	active points) and the missing points are drawn from this fill. When
+ * 	the active front is exhausted, every empty cell of the background grid
+ * 	is probed with random candidates, so free pockets not connected to the
+ * 	front are filled as well. The fill is near-maximal: fewer points than
+ * 	requested means that the density can practically not be met. Cost is
+ * 	linear in the number of points (dense case: in the area), also near
+ * 	saturation.
+ *
+ */
+
+class PoissonDisk {
+public:
+
+	/**
+	 * Constructor
+	 *
+	 *  @param (double) _spacing: minimum distance between points (exclusive)
+	 *  @param (double) _min_radius: minimum distance from the origin
+	 *  @param (double) _max_radius: maximum distance from the origin
+	 *  @param (int) _tries: candidates per active point, and darts missed in a row before filling (default: 30)
+	 */
+	PoissonDisk(double _spacing, double _min_radius, double _max_radius, int _tries = 30) : obstacle_grid(_spacing) {
+		spacing = _spacing;
+		min_radius = _min_radius;
+		max_radius = _max_radius;
+		tries = _tries;
+		max_clearance = 0.;
+		cell_size = spacing/sqrt(2.);
+		side = std::max(1, int(ceil(2.*max_radius/cell_size)) + 1);
+	};
+
+	/**
+	 * Adds an obstacle: points are placed more than distance away from (x,y)
+	 *
+	 *  @param (double) x: x position of the obstacle
+	 *  @param (double) y: y position of the obstacle
+	 *  @param (double) distance: minimum distance of points (exclusive)
+	 *  @return (void)
+	 */
+	void avoid(double x, double y, double distance){
+		obstacle_grid.insert(obstacle_x.size(), x, y);
+		obstacle_x.push_back(x);
+		obstacle_y.push_back(y);
+		clearance.push_back(distance);
+		max_clearance = std::max(max_clearance, distance);
+	};
+
+	/**
+	 * Places up to n random points
+	 *
+	 *  @param (RNG&) rng: random number generator
+	 *  @param (int) n: number of points
+	 *  @param (vector<double>&) x: x positions (cleared first)
+	 *  @param (vector<double>&) y: y positions (cleared first)
+	 *  @return (int) number of points placed, less than n if they do not fit
+	 */
+	int sample(RNG& rng, int n, vector<double>& x, vector<double>& y){
+		x.clear();
+		y.clear();
+		grid.assign(side*side, -1);
+		int misses = 0;
+		while((int) x.size() < n && misses < tries){
+			double cx, cy;
+			draw(rng, cx, cy);
+			if(valid(cx, cy, x, y)){
+				accept(cx, cy, x, y);
+				misses = 0;
+			}
+			else
+				misses++;
+		}
+		if((int) x.size() < n){
+			int placed = x.size();
+			fill(rng, x, y);
+			/// missing points: random subset of the fill (partial Fisher-Yates)
+			int total = x.size();
+			int m = std::min(n, total);
+			for(int k = placed; k < m; k++){
+				int j = k + std::min(int(rng.uniform(0., 1.)*(total - k)), total - k - 1);
+				std::swap(x[k], x[j]);
+				std::swap(y[k], y[j]);
+			}
+			x.resize(m);
+			y.resize(m);
+		}
+		return x.size();
+	};
+
+private:
+
+	/// uniform position (by area) in the annulus
+	void draw(RNG& rng, double& x, double& y) const {
+		double r = sqrt(rng.uniform(min_radius*min_radius, max_radius*max_radius));
+		double a = 2.*M_PI*rng.uniform(0., 1.);
+		x = r*cos(a);
+		y = r*sin(a);
+	};
+
+	int cell(double v) const {
+		return std::min(side - 1, std::max(0, int((v + max_radius)/cell_size)));
+	};
+
+	/// true, if (x,y) lies in the annulus, more than spacing from all points and clear of all obstacles
+	bool valid(double x, double y, const vector<double>& px, const vector<double>& py){
+		double r2 = x*x + y*y;
+		if(r2 < min_radius*min_radius || r2 > max_radius*max_radius)
+			return false;
+		int cx = cell(x);
+		int cy = cell(y);
+		for(int i = std::max(0, cx-2); i <= std::min(side-1, cx+2); i++)
+			for(int j = std::max(0, cy-2); j <= std::min(side-1, cy+2); j++){
+				int k = grid[i*side + j];
+				if(k >= 0 && hypot(x - px[k], y - py[k]) <= spacing)
+					return false;
+			}
+		if(obstacle_x.size() > 0){
+			obstacle_grid.query(x, y, max_clearance, near);
+			for(unsigned int k = 0; k < near.size(); k++)
+				if(hypot(x - obstacle_x[near[k]], y - obstacle_y[near[k]]) <= clearance[near[k]])
+					return false;
+		}
+		return true;
+	};
+
+	void accept(double x, double y, vector<double>& px, vector<double>& py){
+		grid[cell(x)*side + cell(y)] = px.size();
+		px.push_back(x);
+		py.push_back(y);
+	};
+
+	/// Bridson's algorithm, starting from all points placed so far (new seeds from the sweep)
+	void fill(RNG& rng, vector<double>& px, vector<double>& py){
+		vector<int> active;
+		for(unsigned int k = 0; k < px.size(); k++)
+			active.push_back(k);
+		int next_cell = 0;
+		while(true){
+			if(active.empty() && !sweep(rng, next_cell, px, py, active))
+				return;
+			int a = std::min(int(rng.uniform(0., 1.)*active.size()), int(active.size()) - 1);
+			double ax = px[active[a]];
+			double ay = py[active[a]];
+			bool found = false;
+			for(int t = 0; t < tries && !found; t++){
+				double r = spacing*sqrt(rng.uniform(1., 4.));
+				double phi = 2.*M_PI*rng.uniform(0., 1.);
+				double cx = ax + r*cos(phi);
+				double cy = ay + r*sin(phi);
+				if(valid(cx, cy, px, py)){
+					active.push_back(px.size());
+					accept(cx, cy, px, py);
+					found = true;
+				}
+			}
+			if(!found){
+				active[a] = active.back();
+				active.pop_back();
+			}
+		}
+	};
+
+	/// probes the empty cells from next_cell on (in grid order), returns true when one took a point
+	bool sweep(RNG& rng, int& next_cell, vector<double>& px, vector<double>& py, vector<int>& active){
+		for(; next_cell < side*side; next_cell++){
+			if(grid[next_cell] >= 0)
+				continue;
+			double x0 = (next_cell/side)*cell_size - max_radius;
+			double y0 = (next_cell%side)*cell_size - max_radius;
+			/// cells outside of the annulus
+			double nx = std::max(x0, std::min(0., x0 + cell_size));
+			double ny = std::max(y0, std::min(0., y0 + cell_size));
+			double fx = std::max(fabs(x0), fabs(x0 + cell_size));
+			double fy = std::max(fabs(y0), fabs(y0 + cell_size));
+			if(nx*nx + ny*ny > max_radius*max_radius || fx*fx + fy*fy < min_radius*min_radius)
+				continue;
+			for(int t = 0; t < tries; t++){
+				double cx = x0 + cell_size*rng.uniform(0., 1.);
+				double cy = y0 + cell_size*rng.uniform(0., 1.);
+				if(valid(cx, cy, px, py)){
+					active.push_back(px.size());
+					accept(cx, cy, px, py);
+					return true;
+				}
+			}
+		}
+		return false;
+	};
+
+	double spacing;                                 // minimum distance between points
+	double min_radius;                              // inner radius of the annulus
+	double max_radius;                              // outer radius of the annulus
+	int tries;                                      // candidates per active point
+	double cell_size;                               // cell size of the background grid
+	int side;                                       // cells per side of the background grid
+	vector<int> grid;                               // background grid: point in cell (-1: empty)
+	vector<double> obstacle_x;                      // obstacles
+	vector<double> obstacle_y;
+	vector<double> clearance;                       // minimum distance per obstacle
+	double max_clearance;                           // largest clearance (query radius)
+	SpatialGrid obstacle_grid;                      // index of the obstacles
+	vector<int> near;                               // scratch: obstacle candidates
+};
+
+
+#endif /* POISSONDISK_H_ */
@@ -0,0 +1,351 @@
+/*****************************************************************************
+ *  profiler.h                                                               *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+/*** Phases of a simulation step (nested phases are indented in the summary) ***/
+enum ProfilePhase {
+	PROF_STEP,          // Simulation::update
+	PROF_REWARDS,       // Environment::update_rewards
+	PROF_COLLISIONS,    // Environment::update_collisions
+	PROF_PIPE,          // Environment::update_pipe
+	PROF_AGENTS,        // Environment::update_agents
+	PROF_PI,            // path integration (sense, integrate, decode)
+	PROF_GV,            // global vector learning
+	PROF_LV,            // local vector (route) learning
+	PROF_RANDOM,        // random foraging
+	PROF_RECORD,        // recording of network states
+	PROF_TRIALDATA,     // Simulation::writeTrialData
+	PROF_NUM
+};
+
+
+/**
+ * Profiler Class
+ *
+ * 	This class collects the time spent in the phases of a simulation step.
+ * 	Scoped probes (PROFILE(phase)) add the elapsed steady-clock time and one
+ * 	call to a counter slot of the profiler the calling thread works for. A
+ * 	thread works for a profiler inside a Profiler::Scope: the simulation's
+ * 	thread uses slot 0 during run(), worker pool threads use the slot of
+ * 	their worker index while they run a chunk for that thread. Each slot has
+ * 	a single writer, and all slots are owned by the profiler, so concurrent
+ * 	simulations never mix their counts. Between two trials the slots are
+ * 	summed and the difference to the last trial is stored as one row. Times
+ * 	of phases run by several threads are summed over the threads.
+ *
+ * 	Probes only exist if compiled with -DNAVISIM_PROFILE, otherwise they are
+ * 	empty and the profiler records nothing. Probes outside of a scope are
+ * 	not counted.
+ *
+ */
+
+class Profiler {
+public:
+
+	/*** Counters of one trial ***/
+	struct Counters {
+		uint64_t ns[PROF_NUM];
+		uint64_t calls[PROF_NUM];
+		Counters(){
+			for(int i = 0; i < PROF_NUM; i++)
+				ns[i] = calls[i] = 0;
+		}
+	};
+
+	/*** Live counters of one thread (written by it, summed by the profiler) ***/
+	struct Slot {
+		atomic<uint64_t> ns[PROF_NUM];
+		atomic<uint64_t> calls[PROF_NUM];
+		Slot(){
+			for(int i = 0; i < PROF_NUM; i++){
+				ns[i].store(0, memory_order_relaxed);
+				calls[i].store(0, memory_order_relaxed);
+			}
+		}
+		void add(int phase, uint64_t _ns){
+			ns[phase].fetch_add(_ns, memory_order_relaxed);
+			calls[phase].fetch_add(1, memory_order_relaxed);
+		}
+	};
+
+private:
+
+	/*** Profiler and slot of a thread; the slot is looked up once per (profiler, worker) ***/
+	struct Context {
+		Profiler* prof = nullptr;
+		uint64_t id = 0;
+		int w = -1;
+		Slot* cached = nullptr;                     // slot of (id, w)
+		Slot* slot = nullptr;                       // slot in use (nullptr = not counted)
+		void enter(Profiler* _prof, int _w){
+			prof = _prof;
+			slot = nullptr;
+			if(_prof == nullptr)
+				return;
+			if(_prof->id != id || _w != w){
+				id = _prof->id;
+				w = _w;
+				cached = _prof->slot(_w);
+			}
+			slot = cached;
+		}
+	};
+
+	static Context& context(){
+		thread_local Context mine;
+		return mine;
+	};
+
+public:
+
+	/**
+	 * Scope Class
+	 *
+	 * 	Attributes the probes of the calling thread to slot w of a profiler
+	 * 	until the end of the enclosing block (nullptr = not counted)
+	 *
+	 */
+	class Scope {
+	public:
+		Scope(Profiler* prof, int w) : saved_prof(context().prof), saved_slot(context().slot) {
+			if(enabled)
+				context().enter(prof, w);
+		};
+		~Scope(){
+			if(enabled){
+				context().prof = saved_prof;
+				context().slot = saved_slot;
+			}
+		};
+	private:
+		Profiler* saved_prof;                       // scope of the enclosing block
+		Slot* saved_slot;
+	};
+
+#ifdef NAVISIM_PROFILE
+	static const bool enabled = true;
+#else
+	static const bool enabled = false;
+#endif
+
+	/**
+	 * Constructor
+	 */
+	Profiler() : id(next_id()) {};
+
+	/**
+	 * Returns the counter slot of the calling thread (nullptr outside of a scope)
+	 *
+	 *  @return (Slot*)
+	 */
+	static Slot* local(){
+		return context().slot;
+	};
+
+	/**
+	 * Returns the profiler the calling thread works for (nullptr outside of a scope)
+	 *
+	 *  @return (Profiler*)
+	 */
+	static Profiler* current(){
+		return context().prof;
+	};
+
+	/**
+	 * Returns the name of a phase
+	 *
+	 *  @param (int) phase: phase index
+	 *  @return (const char*)
+	 */
+	static const char* name(int phase){
+		static const char* names[PROF_NUM] = {"step", "  rewards", "  collisions", "  pipe", "  agents",
+				"    pi", "    gv", "    lv", "    random", "    record", "trialdata"};
+		return names[phase];
+	};
+
+	/**
+	 * Starts a trial: stores the current sums of all threads
+	 */
+	void begin_trial(){
+		last = total();
+	};
+
+	/**
+	 * Ends a trial: adds the counters since begin_trial() as one row
+	 *
+	 *  @param (int) trial: trial number
+	 */
+	void end_trial(int trial){
+		Counters now = total();
+		Counters row;
+		for(int i = 0; i < PROF_NUM; i++){
+			row.ns[i] = now.ns[i] - last.ns[i];
+			row.calls[i] = now.calls[i] - last.calls[i];
+		}
+		trials.push_back(trial);
+		rows.push_back(row);
+		last = now;
+	};
+
+	/**
+	 * Prints the summary table of all recorded trials: calls, total time,
+	 * time per call and share of the step time of each phase
+	 */
+	void summary() const {
+		Counters sum = sum_rows();
+		double step = sum.ns[PROF_STEP] > 0 ? double(sum.ns[PROF_STEP]) : 1.;
+		printf("=== Profile (%lu trials) ======================================\n", (unsigned long) rows.size());
+		printf("%-14s\t%12s\t%10s\t%10s\t%7s\n", "phase", "calls", "total[ms]", "ns/call", "%step");
+		for(int i = 0; i < PROF_NUM; i++){
+			if(sum.calls[i] == 0)
+				continue;
+			printf("%-14s\t%12llu\t%10.1f\t%10.1f\t%7.1f\n", name(i), (unsigned long long) sum.calls[i],
+					1e-6*sum.ns[i], double(sum.ns[i])/sum.calls[i], 100.*sum.ns[i]/step);
+		}
+		printf("===============================================================\n");
+	};
+
+	/**
+	 * Writes one row per trial: trial, then calls and time [ns] of each phase
+	 *
+	 *  @param (string) filename: output file (tab-separated, header line starting with #)
+	 */
+	void write(const string& filename) const {
+		ofstream out(filename.c_str());
+		out << "#trial";
+		for(int i = 0; i < PROF_NUM; i++){
+			string phase = name(i);
+			phase = phase.substr(phase.find_first_not_of(' '));
+			out << "\t" << phase << "_calls\t" << phase << "_ns";
+		}
+		out << "\n";
+		for(unsigned int j = 0; j < rows.size(); j++){
+			out << trials[j];
+			for(int i = 0; i < PROF_NUM; i++)
+				out << "\t" << rows[j].calls[i] << "\t" << rows[j].ns[i];
+			out << "\n";
+		}
+	};
+
+	/**
+	 * Removes all recorded trials
+	 */
+	void clear(){
+		trials.clear();
+		rows.clear();
+	};
+
+private:
+
+	static uint64_t next_id(){
+		static atomic<uint64_t> ids(0);
+		return ++ids;
+	};
+
+	Slot* slot(int w){
+		lock_guard<mutex> lock(slots_mutex);
+		while(int(slots.size()) <= w)
+			slots.emplace_back();
+		return &slots[w];
+	};
+
+	Counters total(){
+		Counters sum;
+		lock_guard<mutex> lock(slots_mutex);
+		for(unsigned int t = 0; t < slots.size(); t++)
+			for(int i = 0; i < PROF_NUM; i++){
+				sum.ns[i] += slots[t].ns[i].load(memory_order_relaxed);
+				sum.calls[i] += slots[t].calls[i].load(memory_order_relaxed);
+			}
+		return sum;
+	};
+
+	Counters sum_rows() const {
+		Counters sum;
+		for(unsigned int j = 0; j < rows.size(); j++)
+			for(int i = 0; i < PROF_NUM; i++){
+				sum.ns[i] += rows[j].ns[i];
+				sum.calls[i] += rows[j].calls[i];
+			}
+		return sum;
+	};
+
+	const uint64_t id;                              // Unique id (the address may be reused)
+	deque<Slot> slots;                              // Counters of each thread (by worker index)
+	mutex slots_mutex;
+	Counters last;                                  // sums at the start of the trial
+	vector<int> trials;                             // trial numbers
+	vector<Counters> rows;                          // counters of each trial
+};
+
+
+/**
+ * Profile Probe Class
+ *
+ * 	Adds the time from construction to destruction to a phase of the calling thread
+ *
+ */
+
+class ProfileProbe {
+public:
+	explicit ProfileProbe(int _phase) : phase(_phase), start(chrono::steady_clock::now()) {};
+	~ProfileProbe(){
+		Profiler::Slot* slot = Profiler::local();
+		if(slot != nullptr)
+			slot->add(phase, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+	};
+private:
+	int phase;
+	chrono::steady_clock::time_point start;
+};
+
+
+/*** Scoped probe of a phase until the end of the enclosing block (-DNAVISIM_PROFILE) ***/
+#ifdef NAVISIM_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_NAME_(line) PROFILE_CONCAT_(profile_probe_, line)
+#define PROFILE(phase) ProfileProbe PROFILE_NAME_(__LINE__)(phase)
+#else
+#define PROFILE(phase)
+#endif
+
+
+#endif /* PROFILER_H_ */
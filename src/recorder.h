@@ -0,0 +1,228 @@
+/*****************************************************************************
+ *  recorder.h                                                               *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include <algorithm>
+#include <string>
+#include <armadillo>
+#include "checkpoint.h"
+using namespace arma;
+using namespace std;
+
+
+/**
+ * Activity Recorder Class
+ *
+ * 	This class records column vectors (e.g., activities or weights sampled
+ * 	over time) into a preallocated column-major buffer. Without a known
+ * 	capacity the buffer grows geometrically. In ring mode only the last
+ * 	K samples are kept and the oldest column is overwritten.
+ *
+ */
+
+class Recorder {
+public:
+
+	/**
+	 * Constructor
+	 *
+	 *  @param (int) _window: number of samples kept in ring mode, 0 = keep all (default: 0)
+	 */
+	Recorder(int _window = 0){
+		dim = 0;
+		num = 0;
+		head = 0;
+		capacity = 0;
+		reserved = 0;
+		window = _window;
+	};
+
+	/**
+	 * Sets the expected number of samples; the buffer is allocated on the first sample
+	 *
+	 *  @param (int) num_samples: expected number of samples
+	 *  @return (void)
+	 */
+	void reserve(int num_samples){
+		reserved = num_samples;
+	};
+
+	/**
+	 * Keeps only the last K samples (ring mode); 0 keeps all samples
+	 *
+	 *  @param (int) K: number of samples kept
+	 *  @return (void)
+	 */
+	void set_window(int K){
+		window = K;
+		clear();
+	};
+
+	/**
+	 * Removes all samples (keeps the allocated buffer)
+	 *
+	 *  @return (void)
+	 */
+	void clear(){
+		num = 0;
+		head = 0;
+	};
+
+	/**
+	 * Appends a sample
+	 *
+	 *  @param (const vec&) sample: column to be recorded
+	 *  @return (void)
+	 */
+	void push(const vec& sample){
+		if(dim == 0)
+			dim = sample.n_elem;
+		if(window > 0){
+			if(capacity < window)
+				grow(window);
+			if(num < window){
+				buffer.col(num) = sample;
+				num++;
+			}
+			else{
+				buffer.col(head) = sample;
+				head = (head + 1) % window;
+			}
+			return;
+		}
+		if(num == capacity){
+			int cols = (2*capacity > min_chunk) ? 2*capacity : int(min_chunk);
+			int cap = max_reserve/dim;
+			if(reserved > cols)
+				cols = (reserved < cap) ? reserved : ((cap > cols) ? cap : cols);
+			grow(cols);
+		}
+		buffer.col(num) = sample;
+		num++;
+	};
+
+	/**
+	 * Returns the recorded samples in chronological order (copy)
+	 *
+	 *  @return (mat)
+	 */
+	mat samples(){
+		if(num == 0)
+			return mat();
+		unroll();
+		return buffer.cols(0, num-1);
+	};
+
+	/**
+	 * Returns the number of recorded samples
+	 *
+	 *  @return (int)
+	 */
+	int n_samples(){
+		return num;
+	};
+
+	/**
+	 * Saves the recorded samples in chronological order (same layout as mat::save)
+	 *
+	 *  @param (string) filename: output file
+	 *  @param (file_type) type: armadillo file type (default: raw_ascii)
+	 *  @return (bool)
+	 */
+	bool save(const string& filename, file_type type = raw_ascii){
+		if(num == 0)
+			return mat().save(filename, type);
+		unroll();
+		const mat view(buffer.memptr(), dim, num, false, true);	// alias, no copy
+		return view.save(filename, type);
+	};
+
+	/**
+	 * Writes or reads the recorded samples (in chronological order); the
+	 * expected number of samples is set again by the next run
+	 *
+	 *  @param (Checkpoint&) cp: snapshot file
+	 *  @return (void)
+	 */
+	void checkpoint(Checkpoint& cp){
+		cp.pod(dim);
+		cp.pod(num);
+		cp.pod(capacity);
+		cp.pod(window);
+		if(cp.save() && head > 0){
+			/// wrapped ring: written in order from a copy, the recorder itself is left unchanged
+			mat recorded(dim, num);
+			const double* mem = buffer.memptr();
+			std::rotate_copy(mem, mem + head*dim, mem + num*dim, recorded.memptr());
+			cp.io(recorded);
+			return;
+		}
+		if(!cp.save()){
+			head = 0;
+			buffer.set_size(dim, capacity);
+		}
+		mat recorded(buffer.memptr(), dim, num, false, true);	// alias, no copy
+		cp.io(recorded);
+	};
+
+private:
+
+	/**
+	 * Resizes the buffer to given number of columns (keeps recorded samples)
+	 */
+	void grow(int cols){
+		buffer.resize(dim, cols);
+		capacity = cols;
+	};
+
+	/**
+	 * Rotates a wrapped ring buffer in place, so that the oldest sample is in column 0
+	 */
+	void unroll(){
+		if(head == 0)
+			return;
+		double* mem = buffer.memptr();
+		std::rotate(mem, mem + head*dim, mem + num*dim);
+		head = 0;
+	};
+
+	static const int min_chunk = 1024;				// Smallest growth step (columns)
+	static const int max_reserve = 1 << 24;			// Largest preallocation (elements)
+
+	mat buffer;                                     // Samples (dim x capacity), column-major
+	int dim;                                        // Sample dimension
+	int num;                                        // Number of recorded samples
+	int head;                                       // Oldest sample in ring mode
+	int capacity;                                   // Allocated columns
+	int reserved;                                   // Expected number of samples
+	int window;                                     // Ring size (0 = unbounded)
+};
+
+
+#endif /* RECORDER_H_ */
@@ -0,0 +1,237 @@
+/*****************************************************************************
+ *  rng.h                                                                    *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef RNG_H_
+#define RNG_H_
+
+#include <cstdint>
+#include <limits>
+#include <armadillo>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
+#include "checkpoint.h"
+using namespace arma;
+
+
+/**
+ * Random Number Generator Class
+ *
+ * 	This class holds one persistent xoshiro256++ engine. Independent
+ * 	streams are derived from a master seed by jumping 2^128 draws ahead
+ * 	per stream index, so each agent/controller draws from its own
+ * 	non-overlapping sequence and a run is reproducible from its seed.
+ *
+ */
+
+class RNG {
+public:
+	typedef uint64_t result_type;
+
+	/**
+	 * Constructor
+	 *
+	 *  @param (uint64_t) master_seed: seed shared by all streams of a simulation (default: 5489)
+	 *  @param (int) stream: index of the independent stream (default: 0)
+	 */
+	RNG(uint64_t master_seed = 5489u, int stream = 0){
+		seed(master_seed, stream);
+	};
+
+	/**
+	 * Seeds the engine with a master seed and jumps ahead to the given stream
+	 *
+	 *  @param (uint64_t) master_seed: seed shared by all streams of a simulation
+	 *  @param (int) stream: index of the independent stream (default: 0)
+	 *  @return (void)
+	 */
+	void seed(uint64_t master_seed, int stream = 0){
+		uint64_t sm = master_seed;
+		for(int i = 0; i < 4; i++)
+			s[i] = splitmix64(sm);
+		for(int i = 0; i < stream; i++)
+			jump();
+		normal_dist.reset();
+	};
+
+	/**
+	 * Advances the engine by 2^128 draws (xoshiro256 jump polynomial)
+	 *
+	 *  @return (void)
+	 */
+	void jump(){
+		static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+		uint64_t t[4] = {0, 0, 0, 0};
+		for(int i = 0; i < 4; i++)
+			for(int b = 0; b < 64; b++){
+				if(JUMP[i] & (uint64_t(1) << b))
+					for(int k = 0; k < 4; k++)
+						t[k] ^= s[k];
+				(*this)();
+			}
+		for(int k = 0; k < 4; k++)
+			s[k] = t[k];
+	};
+
+	/**
+	 * Advances the engine by n draws without producing numbers
+	 *
+	 *  @param (unsigned long long) n: number of draws skipped
+	 *  @return (void)
+	 */
+	void discard(unsigned long long n){
+		for(unsigned long long i = 0; i < n; i++)
+			(*this)();
+	};
+
+	static constexpr result_type min(){ return 0; }
+	static constexpr result_type max(){ return std::numeric_limits<result_type>::max(); }
+
+	/**
+	 * Returns the next raw 64-bit draw
+	 *
+	 *  @return (uint64_t)
+	 */
+	result_type operator()(){
+		const uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+		const uint64_t t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+		return result;
+	};
+
+	/**
+	 * Returns a random number drawn from a Gaussian distribution
+	 *
+	 * @param (double) mean: mean of the distribution (default: 0.0)
+	 * @param (double) stdev: width of the distribution (default: 1.0)
+	 * @return (double)
+	 */
+	double normal(double mean = 0.0, double stdev = 1.0){
+		return mean + stdev * normal_dist(*this);
+	};
+
+	/**
+	 * Fills a buffer with Gaussian random numbers
+	 *
+	 * @param (double*) out: buffer to be filled
+	 * @param (int) n: number of values
+	 * @param (double) mean: mean of the distribution (default: 0.0)
+	 * @param (double) stdev: width of the distribution (default: 1.0)
+	 * @return (void)
+	 */
+	void normal(double* out, int n, double mean = 0.0, double stdev = 1.0){
+		for(int i = 0; i < n; i++)
+			out[i] = mean + stdev * normal_dist(*this);
+	};
+
+	/**
+	 * Returns a random number drawn from a uniform distribution
+	 *
+	 * @param (double) min: lower bound of the distribution (default: 0.0)
+	 * @param (double) max: upper bound of the distribution (default: 1.0)
+	 * @return (double)
+	 */
+	double uniform(double min = 0.0, double max = 1.0){
+		return min + (max - min) * unit();
+	};
+
+	/**
+	 * Fills a buffer with uniform random numbers
+	 *
+	 * @param (double*) out: buffer to be filled
+	 * @param (int) n: number of values
+	 * @param (double) min: lower bound of the distribution (default: 0.0)
+	 * @param (double) max: upper bound of the distribution (default: 1.0)
+	 * @return (void)
+	 */
+	void uniform(double* out, int n, double min = 0.0, double max = 1.0){
+		for(int i = 0; i < n; i++)
+			out[i] = min + (max - min) * unit();
+	};
+
+	/**
+	 * Returns vector of Gaussian random numbers
+	 *
+	 *  @param (int) dim: vector dimension
+	 *  @param (double) stdev: width of the distribution (default: 1.0)
+	 *  @return (vec)
+	 */
+	vec randn(int dim, double stdev = 1.0){
+		vec out(dim);
+		normal(out.memptr(), dim, 0.0, stdev);
+		return out;
+	};
+
+	/**
+	 * Returns matrix of uniform random numbers in [0,1)
+	 *
+	 *  @param (int) rows: number of rows
+	 *  @param (int) cols: number of columns (default: 1)
+	 *  @return (mat)
+	 */
+	mat randu(int rows, int cols = 1){
+		mat out(rows, cols);
+		uniform(out.memptr(), rows*cols);
+		return out;
+	};
+
+	/**
+	 * Writes or reads the engine state (the ziggurat normal distribution keeps no state)
+	 *
+	 *  @param (Checkpoint&) cp: snapshot file
+	 *  @return (void)
+	 */
+	void checkpoint(Checkpoint& cp){
+		cp.pod(s);
+	};
+
+private:
+	static uint64_t rotl(const uint64_t x, int k){
+		return (x << k) | (x >> (64 - k));
+	};
+
+	static uint64_t splitmix64(uint64_t& x){
+		uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	};
+
+	double unit(){
+		return ((*this)() >> 11) * (1.0 / 9007199254740992.0);	// 53-bit mantissa in [0,1)
+	};
+
+	uint64_t s[4];                                  // engine state
+	boost::random::normal_distribution<double> normal_dist;
+};
+
+
+#endif /* RNG_H_ */
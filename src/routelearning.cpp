@@ -7,7 +7,8 @@
 
 #include "routelearning.h"
 
-RouteLearning::RouteLearning(int num_neurons, int num_lmr_units, double nnoise, double* forage, bool opt_load, bool in_silent) : CircArray(num_neurons, num_lmr_units) {
+RouteLearning::RouteLearning(int num_neurons, int num_lmr_units, double nnoise, double* forage, bool opt_load, bool in_silent, const string& out_dir) : CircArray(num_neurons, num_lmr_units) {
+	path = out_dir;
 	t_step = 0;
 	no_learning = false;
 	VERBOSE = false;
@@ -23,8 +24,8 @@ RouteLearning::RouteLearning(int num_neurons, int num_lmr_units, double nnoise,
 	white_weights.zeros(N,K);
 	//printf("%u X %u\n", white_weights.n_rows, white_weights.n_cols);
 	if(load_weights){
-		white_weights.load("./save/routeweights.mat", raw_ascii);
-		input_conns.load("./save/routeweights.mat", raw_ascii);
+		white_weights.load(path + "save/routeweights.mat", raw_ascii);
+		input_conns.load(path + "save/routeweights.mat", raw_ascii);
 		printf("Load weights: %f\n", accu(input_conns));
 	}
 
@@ -34,6 +35,13 @@ RouteLearning::RouteLearning(int num_neurons, int num_lmr_units, double nnoise,
 	d_raw_lmr = zeros<vec>(num_lmr_units);
 	clip_lmr = zeros<vec>(num_lmr_units);
 	value = zeros<vec>(num_lmr_units);
+	lm_clock = 0;
+	elig_stamp.assign(K, 0);
+	active_stamp.assign(K, 0);
+	is_idle.assign(K, false);
+	lv_dirty.assign(K, true);
+	stored_codes.resize(K);
+	lm_input.zeros(N);
 	reference_pin = new PIN(N, 0.0, 0.00, 0.0);
 
 	if(!SILENT){
@@ -49,7 +57,7 @@ RouteLearning::RouteLearning(int num_neurons, int num_lmr_units, double nnoise,
 
 RouteLearning::~RouteLearning(){
 	delete reference_pin;
-	input_conns.save("./save/routeweights.mat", raw_ascii);
+	input_conns.save(path + "save/routeweights.mat", raw_ascii);
 	printf("Save weights: %f\n", accu(w()));
 }
 
@@ -57,6 +65,44 @@ double RouteLearning::cl_state_lm(int index){
 	return clip_lmr(index);
 }
 
+void RouteLearning::checkpoint(Checkpoint& cp){
+	CircArray::checkpoint(cp);
+	reference_pin->checkpoint(cp);
+	cp.io(local_vector);
+	cp.io(stored_local_vector);
+	cp.check(stored_codes.size(), "number of LV units");
+	for(unsigned int k = 0; k < stored_codes.size(); k++){
+		PopulationCode& code = stored_codes.at(k);
+		cp.pod(code.avg);
+		cp.pod(code.pva);
+		cp.pod(code.bump);
+		cp.pod(code.len);
+		cp.pod(code.max_rate);
+		cp.pod(code.max_index);
+		cp.pod(code.max);
+	}
+	cp.pod(reward);
+	cp.io(d_raw_lmr);
+	cp.io(clip_lmr);
+	cp.io(raw_lmr);
+	cp.io(eligibility_lmr);
+	cp.io(eligibility_long);
+	cp.io(value);
+	cp.pod(lm_clock);
+	cp.io(elig_stamp);
+	cp.io(active_stamp);
+	cp.io(active_units);
+	cp.io(max_units);
+	cp.io(valued_units);
+	cp.io(learn_units);
+	cp.io(idle_units);
+	cp.io(is_idle);
+	cp.io(lv_dirty);
+	cp.io(lm_input);
+	cp.io(white_weights);
+	cp.io(weight_change);
+	cp.pod(t_step);
+}
 
 mat RouteLearning::dW(){
 	return weight_change;
@@ -81,6 +127,7 @@ Vec RouteLearning::LV(int index){
 void RouteLearning::LV(int index, Vec vector, bool locked){
 	stored_local_vector.at(index).to(vector);
 	stored_local_vector.at(index).lock(locked);
+	lv_dirty.at(index) = true;
 }
 
 double RouteLearning::R(){
@@ -104,6 +151,15 @@ void RouteLearning::reset_el_lm(){
 	reference_pin->reset();
 	eligibility_lmr = zeros<vec>(K);
 	eligibility_long = zeros<vec>(K);
+	elig_stamp.assign(K, lm_clock);
+	is_idle.assign(K, false);
+	idle_units.clear();
+	max_units.clear();
+}
+
+void RouteLearning::set_rng(RNG* _rng){
+	CircArray::set_rng(_rng);
+	reference_pin->set_rng(_rng);
 }
 
 void RouteLearning::set_mu(double* state){
@@ -131,32 +187,98 @@ void RouteLearning::update(Angle angle, double speed, double in_reward, vec inpu
 	d_raw_lmr *= -1;
 
 	//printf("LMR_dim = %u\n", raw_lmr.n_elem);
+	lm_clock++;
+	active_units.clear();
 	clip_lmr = d_raw_lmr;
-	clip_lmr.elem( find(clip_lmr < 0.0) ).zeros();
-	clip_lmr.elem( find(clip_lmr > 0.0) ).ones();
-	double lowpass_elig = 0.995;	//0.995
-	eligibility_long = 1.0*clip_lmr + lowpass_elig*eligibility_long;
-	eligibility_long.elem( find(raw_lmr > 0.0) ).zeros();
-	eligibility_long.elem( find(eligibility_lmr > 1.0) ).ones();
-	eligibility_lmr = eligibility_long;
+	double sum_clip = 0.0;
+	for(int i = 0; i < K; i++){
+		if(clip_lmr(i) < 0.0)
+			clip_lmr(i) = 0.0;
+		if(clip_lmr(i) > 0.0)
+			clip_lmr(i) = 1.0;
+		sum_clip += clip_lmr(i);
+		if(d_raw_lmr(i) != 0.0)		// landmark event
+			activate(i);
+	}
+	for(int k = 0; k < max_units.size(); k++)
+		activate(max_units.at(k));
+	for(int k = 0; k < valued_units.size(); k++)
+		activate(valued_units.at(k));
+	if(in_reward - value_decay > 0.0)	// values of all traced units grow
+		for(int k = 0; k < idle_units.size(); k++)
+			activate(idle_units.at(k));
+	sort(active_units.begin(), active_units.end());
+	bool left_idle = false;
+	for(int k = 0; k < active_units.size(); k++)
+		if(is_idle.at(active_units.at(k))){
+			is_idle.at(active_units.at(k)) = false;
+			left_idle = true;
+		}
+	if(left_idle)
+		idle_units.erase(remove_if(idle_units.begin(), idle_units.end(), [&](int i){ return !is_idle.at(i); }), idle_units.end());
+
+	/// eligibility traces of active units (idle traces only decay)
+	double emax = 0.0;
+	for(int k = 0; k < active_units.size(); k++){
+		int i = active_units.at(k);
+		decay_trace(i, lm_clock - 1);
+		eligibility_long(i) = 1.0*clip_lmr(i) + lowpass_elig*eligibility_long(i);
+		if(raw_lmr(i) > 0.0)
+			eligibility_long(i) = 0.0;
+		if(eligibility_lmr(i) > 1.0)
+			eligibility_long(i) = 1.0;
+		elig_stamp.at(i) = lm_clock;
+		if(eligibility_long(i) > emax)
+			emax = eligibility_long(i);
+	}
+	if(!idle_units.empty()){
+		decay_trace(idle_units.front(), lm_clock);
+		if(eligibility_long(idle_units.front()) > emax)
+			emax = eligibility_long(idle_units.front());
+	}
 
 	/// only maximum active eligibility trace is chosen
-	double emax = arma::max(eligibility_lmr);
-	for(int i=0; i<eligibility_lmr.n_elem; i++){
-		if(eligibility_lmr(i) < emax)
+	max_units.clear();
+	for(int k = 0; k < active_units.size(); k++){
+		int i = active_units.at(k);
+		if(eligibility_long(i) < emax)
 			eligibility_lmr(i) = 0.0;
+		else{
+			eligibility_lmr(i) = eligibility_long(i);
+			if(emax > 0.0)
+				max_units.push_back(i);
+		}
 	}
+	for(int k = 0; k < idle_units.size() && emax > 0.0; k++){
+		int i = idle_units.at(k);
+		decay_trace(i, lm_clock);
+		if(eligibility_long(i) < emax)
+			break;
+		eligibility_lmr(i) = eligibility_long(i);
+		max_units.push_back(i);
+	}
+	sort(max_units.begin(), max_units.end());
 
-	if(accu(clip_lmr) > 0.5/*accu(raw_lmr) > 0.5 || accu(eligibility_lmr) < 0.1*/){
+	if(sum_clip > 0.5/*accu(raw_lmr) > 0.5 || accu(eligibility_lmr) < 0.1*/){
 		reference_pin->reset();
 		if(VERBOSE)
 			printf("t = %u\n", t_step);
 	}
-	value += (in_reward - value_decay)*eligibility_long - global_decay*value;
-	value.elem( find(value < 0.0) ).zeros();
-	vec value_new = 1. - exp(-value);
 
-	double lv_value_reward = as_scalar(value_new.t()*raw_lmr);/// value_k * sigma_k
+	/// values (inactive units have zero value, which does not change)
+	double lv_value_reward = 0.0;/// value_k * sigma_k
+	valued_units.clear();
+	for(int k = 0; k < active_units.size(); k++){
+		int i = active_units.at(k);
+		value(i) += (in_reward - value_decay)*eligibility_long(i) - global_decay*value(i);
+		if(value(i) < 0.0)
+			value(i) = 0.0;
+		lv_value_reward += (1. - exp(-value(i)))*raw_lmr(i);
+		if(value(i) != 0.0)
+			valued_units.push_back(i);
+		else if(eligibility_long(i) > 0.0 && eligibility_lmr(i) == 0.0)
+			insert_idle(i);
+	}
 	reward = in_reward + lv_value_reward;
 
 
@@ -167,31 +289,43 @@ void RouteLearning::update(Angle angle, double speed, double in_reward, vec inpu
 	reference_pin->update(angle, speed);
 	if(VERBOSE && t_step%10==0)
 		printf("t = %u, RV = (%g,%g)\t(%f, %f)\n", t_step, reference_pin->HV().x, reference_pin->HV().y, reference_pin->HV().ang().deg(), reference_pin->HV().len());
-	update_rate(input_conns*sign(eligibility_lmr));
-	double deltaW = -accu(input_conns);
+	/// rate input: input_conns*sign(eligibility_lmr), i.e. the sum of the weights of max units
+	lm_input.zeros();
+	for(int k = 0; k < max_units.size(); k++){
+		const double* w = input_conns.colptr(max_units.at(k));
+		for(int j = 0; j < N; j++)
+			lm_input(j) += w[j];
+	}
+	update_rate(lm_input);
+	double deltaW = VERBOSE ? -accu(input_conns) : 0.0;
 	update_weights();
-	deltaW += accu(input_conns);
-	if(VERBOSE && abs(deltaW) > 0.)
-		printf("t = %u\t postw weights: %f\n", t_step, accu(input_conns));
-	vec output = rate();
-
+	if(VERBOSE){
+		deltaW += accu(input_conns);
+		if(abs(deltaW) > 0.)
+			printf("t = %u\t postw weights: %f\n", t_step, accu(input_conns));
+	}
 	//*** Update vector representations ***//
 	/// active local vector
-	Angle lv_angle = vector_avg(output);
-	Angle lv_angle_new = pva_angle(output);
-	double lv_len = pva_len(output);
+	PopulationCode code;
+	decode(rate_ref().memptr(), code);
+	Angle lv_angle = code.avg;
+	double lv_len = code.len;
 	local_vector.to(lv_len*lv_angle.C(), lv_len*lv_angle.S());
 	if(VERBOSE && t_step%100==0)
 		printf("LV =(%g,%g)\n", local_vector.x, local_vector.y);
 
-	/// stored local vector
+	/// stored local vector (decoded again only if its weights changed)
 	for(int index = 0; index < K; index++){
 //		set_avg(update_avg(input_conns.col(index)));
 //		set_len(update_len(input_conns.col(index)));
 //		set_max(update_max(input_conns.col(index)));
-		Angle lv_angle = vector_avg(input_conns.col(index));
-		double lv_len = pva_len(input_conns.col(index));
-		stored_local_vector.at(index).to(lv_len*lv_angle.C(), lv_len*lv_angle.S());
+		if(lv_dirty.at(index)){
+			decode(input_conns.colptr(index), stored_codes[index]);
+			Angle lv_angle = stored_codes[index].avg;
+			double lv_len = stored_codes[index].len;
+			stored_local_vector.at(index).to(lv_len*lv_angle.C(), lv_len*lv_angle.S());
+			lv_dirty.at(index) = false;
+		}
 		if(VERBOSE && t_step%100==0)
 			printf("LV%u =(%g,%g)\n", index, stored_local_vector.at(index).x, stored_local_vector.at(index).y);
 		//if(input_conns.max() > 10000 || input_conns.min() < -1000)
@@ -202,18 +336,32 @@ void RouteLearning::update(Angle angle, double speed, double in_reward, vec inpu
 }
 
 void RouteLearning::update_weights(){
-	vec ref_output = reference_pin->get_output();
-	for(int i = 0; i < K; i++){
-		vec diff_act = ref_output - input_conns.col(i);
-		weight_change.col(i) = learn_rate * reward * eligibility_lmr(i) * (1. - *foraging_state) * diff_act;// - /*0.0000004*/0.000001*input_conns;
+	const vec& ref_output = reference_pin->output_ref();
+	/// without synaptic noise only the weights of max units (nonzero eligibility) change
+	bool sparse = (neural_noise == 0.0);
+	if(sparse)
+		for(int k = 0; k < learn_units.size(); k++)		// weight changes of last step
+			fill(weight_change.colptr(learn_units.at(k)), weight_change.colptr(learn_units.at(k)) + N, 0.0);
+	learn_units = max_units;
+	for(int k = 0; k < (sparse ? max_units.size() : K); k++){
+		int i = sparse ? max_units.at(k) : k;
+		const double eta = learn_rate * reward * eligibility_lmr(i) * (1. - *foraging_state);
+		const double* w = input_conns.colptr(i);
+		double* dw = weight_change.colptr(i);
+		for(int j = 0; j < N; j++)
+			dw[j] = eta * (ref_output(j) - w[j]);// - /*0.0000004*/0.000001*input_conns;
 		if(VERBOSE && t_step%1==0 && abs(accu(weight_change.col(i))) > 0.1){
 			printf("$t= %u Learning for LV %u: el_lm = %f, R = %f, sum(W) = %f, sum(dW) = %f\n", t_step, i, eligibility_lmr(i), reward, accu(input_conns.col(i)), accu(weight_change.col(i)));
 			printf("RV =(%g,%g)\n", reference_pin->HV().x, reference_pin->HV().y);
 		}
+		if(sparse)
+			apply_weight_change(white_weights, weight_change, 0.0, i, 1);
+		lv_dirty.at(i) = true;
 	}
-	white_weights += weight_change;
-	white_weights.elem( find(white_weights < 0.0) ).zeros();
-	input_conns = white_weights+randu<mat>(N,K)*neural_noise;
+	if(sparse)
+		rng->discard(N*(K - max_units.size()));	// same noise stream as the full update
+	else
+		apply_weight_change(white_weights, weight_change, neural_noise);
 }
 
 Angle RouteLearning::vec_avg(int _index){
@@ -230,5 +378,39 @@ double RouteLearning::lv_value(int _index){
 
 void RouteLearning::lv_value(int _index, double _value){
 	value(_index) = _value;
+	if(_value != 0.0 && std::find(valued_units.begin(), valued_units.end(), _index) == valued_units.end())
+		valued_units.push_back(_index);
+}
+
+void RouteLearning::activate(int index){
+	if(active_stamp.at(index) != lm_clock){
+		active_stamp.at(index) = lm_clock;
+		active_units.push_back(index);
+	}
+}
+
+void RouteLearning::decay_trace(int index, int until){
+	double& trace = eligibility_long(index);
+	while(elig_stamp.at(index) < until && trace != 0.0){
+		trace = lowpass_elig*trace;		// no landmark event (clip_lmr = -0)
+		elig_stamp.at(index)++;
+	}
+	if(elig_stamp.at(index) < until)
+		elig_stamp.at(index) = until;
+}
+
+void RouteLearning::insert_idle(int index){
+	/// the decay is monotone, so the order of idle traces stays the same while they decay
+	int lo = 0, hi = idle_units.size();
+	while(lo < hi){
+		int mid = (lo + hi)/2;
+		decay_trace(idle_units.at(mid), lm_clock);
+		if(eligibility_long(idle_units.at(mid)) >= eligibility_long(index))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	idle_units.insert(idle_units.begin() + lo, index);
+	is_idle.at(index) = true;
 }
 
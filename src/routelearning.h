@@ -8,7 +8,9 @@
 #ifndef ROUTELEARNING_H_
 #define ROUTELEARNING_H_
 
+#include <algorithm>
 #include <armadillo>
+#include <vector>
 #include "pin.h"
 #include "circulararray.h"
 using namespace arma;
@@ -26,8 +28,9 @@ public:
 	 *  @param (double) nnoise: uncorrelated noise in synaptic weights
 	 *  @param (double*) forage: pointer to agent's foraging state
 	 *  @param (bool) opt_load: true, if loading learned weights from file
+	 *  @param (string) out_dir: directory containing save/ (default: "./")
 	 */
-	RouteLearning(int num_neurons, int num_lmr_units, double nnoise, double* forage, bool opt_load=false, bool in_silent=false);
+	RouteLearning(int num_neurons, int num_lmr_units, double nnoise, double* forage, bool opt_load=false, bool in_silent=false, const string& out_dir="./");
 
 	/**
 	 * Destructor
@@ -43,6 +46,15 @@ public:
 	 */
 	double cl_state_lm(int index);
 
+	/**
+	 * Writes or reads the state of the learning circuit (weights, local vectors, eligibility traces
+	 * and the lists of the event-driven update)
+	 *
+	 * @param (Checkpoint&) cp: snapshot file
+	 * @return (void)
+	 */
+	void checkpoint(Checkpoint& cp);
+
 	/**
 	 * Return weight change matrix
 	 *
@@ -114,6 +126,14 @@ public:
 
 	void reset_el_lm();
 
+	/**
+	 * Sets the random number generator (also used by the reference PI)
+	 *
+	 *	@param (RNG*) _rng: random number generator
+	 * 	@return (void)
+	 */
+	void set_rng(RNG* _rng);
+
 	/**
 	 * Sets the foraging state
 	 *
@@ -193,10 +213,37 @@ public:
 	bool VERBOSE;
 
 private:
+
+	/**
+	 * Marks a landmark unit as active in the current step (processed with the full update)
+	 *
+	 * @param (int) index: index of landmark unit
+	 * @return (void)
+	 */
+	void activate(int index);
+
+	/**
+	 * Applies the pending decay steps of a lazy eligibility trace
+	 *
+	 * @param (int) index: index of landmark unit
+	 * @param (int) until: step up to which the trace is decayed
+	 * @return (void)
+	 */
+	void decay_trace(int index, int until);
+
+	/**
+	 * Inserts a landmark unit into the list of idle traces (sorted by trace, descending)
+	 *
+	 * @param (int) index: index of landmark unit
+	 * @return (void)
+	 */
+	void insert_idle(int index);
+
 	PIN * reference_pin;
 
 	Vec local_vector;                   // active local vector
 	vector<Vec> stored_local_vector;            // stored local vectors
+	vector<PopulationCode> stored_codes;        // decoded weight columns (stored local vectors)
 
 	double* foraging_state;
 	double learn_rate;
@@ -210,12 +257,28 @@ private:
 	vec value;
 	const double value_decay = 0.00001;
 	const double global_decay = 0.000001;
+	const double lowpass_elig = 0.995;	//0.995
+
+	/// event-driven landmark state: only units with events, the maximum trace or a
+	/// nonzero value are updated each step; the other traces decay lazily
+	int lm_clock;                               // number of landmark updates (not reset)
+	vector<int> elig_stamp;                     // step up to which eligibility_long is decayed
+	vector<int> active_stamp;                   // last step the unit was active
+	vector<int> active_units;                   // active units of the current step (ascending)
+	vector<int> max_units;                      // units with the maximum eligibility trace (ascending)
+	vector<int> valued_units;                   // units with nonzero value
+	vector<int> learn_units;                    // units with nonzero weight change
+	vector<int> idle_units;                     // units with a decaying trace only (trace descending)
+	vector<bool> is_idle;
+	vector<bool> lv_dirty;                      // stored local vectors to be decoded (weights changed)
+	vec lm_input;                               // rate input (sum of the weights of max_units)
 
 	mat white_weights;
 	mat weight_change;
 	int t_step;
 
 	bool load_weights;
+	string path;
 	bool no_learning;
 };
 
@@ -0,0 +1,215 @@
+/*****************************************************************************
+ *  sampling.h                                                               *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef SAMPLING_H_
+#define SAMPLING_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "rng.h"
+using namespace std;
+
+/*** Events of the recorded agent that trigger samples (bit mask) ***/
+enum{event_goal = 1, event_landmark = 2, event_home = 4, event_pipe = 8};
+
+
+/**
+ * Sampling Policy Class
+ *
+ * 	This class decides which time steps of a trial are written to a data
+ * 	stream. A step is kept if it is a multiple of the sampling interval,
+ * 	if one of the selected events happened in the step before (goal hit,
+ * 	landmark catchment entered, homing success, pipe entered), or if it is
+ * 	one of the first K steps of the trial. The last K steps of a trial are
+ * 	kept as well; since the end of a trial is not known in advance, the
+ * 	stream holds these rows back for K steps. Optionally only K trials,
+ * 	chosen uniformly at random by reservoir sampling over all trials of
+ * 	the run, are written at all.
+ *
+ */
+
+class SamplingPolicy {
+public:
+
+	/**
+	 * Constructor
+	 *
+	 *  @param (int) _every: sampling interval in steps, 0 = none, -1 = default of the simulation (default: -1)
+	 */
+	SamplingPolicy(int _every = -1){
+		interval = _every;
+		event_mask = 0;
+		first_steps = 0;
+		last_steps = 0;
+		num_trials = 0;
+	};
+
+	/**
+	 * Sets the sampling interval
+	 *
+	 *  @param (int) steps: every n-th step of a trial, 0 = none, -1 = default of the simulation
+	 *  @return (void)
+	 */
+	void every(int steps){
+		interval = steps;
+	};
+
+	/**
+	 * Keeps the steps after the given events
+	 *
+	 *  @param (int) events: bit mask of event_goal, event_landmark, event_home, event_pipe
+	 *  @return (void)
+	 */
+	void on(int events){
+		event_mask = events;
+	};
+
+	/**
+	 * Keeps the first K steps of each trial
+	 *
+	 *  @param (int) K: number of steps
+	 *  @return (void)
+	 */
+	void first(int K){
+		first_steps = K;
+	};
+
+	/**
+	 * Keeps the last K steps of each trial (rows are held back for K steps)
+	 *
+	 *  @param (int) K: number of steps
+	 *  @return (void)
+	 */
+	void last(int K){
+		last_steps = K;
+	};
+
+	/**
+	 * Writes only K trials, chosen uniformly at random; 0 = all trials
+	 *
+	 *  @param (int) K: number of trials
+	 *  @return (void)
+	 */
+	void trials(int K){
+		num_trials = K;
+	};
+
+	/**
+	 * Chooses the written trials of a run by reservoir sampling over the trial
+	 * numbers (the same seed chooses the same trials, also after a restart)
+	 *
+	 *  @param (int) N: number of trials of the run
+	 *  @param (uint64_t) seed: seed of the choice
+	 *  @return (void)
+	 */
+	void select_trials(int N, uint64_t seed){
+		selected.clear();
+		if(num_trials <= 0 || num_trials >= N)
+			return;
+		RNG rng(seed);
+		for(int t = 1; t <= N; t++){
+			if(t <= num_trials)
+				selected.push_back(t);
+			else{
+				int j = int(rng.uniform(0., 1.)*t);
+				if(j < num_trials)
+					selected[j] = t;
+			}
+		}
+		sort(selected.begin(), selected.end());
+	};
+
+	/**
+	 * Returns true, if the trial is written
+	 *
+	 *  @param (int) trial: trial number
+	 *  @return (bool)
+	 */
+	bool trial_selected(int trial) const {
+		return selected.empty() || binary_search(selected.begin(), selected.end(), trial);
+	};
+
+	/**
+	 * Returns true, if the row of this step is written
+	 *
+	 *  @param (int) trial: trial number
+	 *  @param (int) step: step of the trial, -1 = after the end of the trial (events only)
+	 *  @param (int) events: events in the step before (bit mask)
+	 *  @return (bool)
+	 */
+	bool keeps(int trial, int step, int events) const {
+		if(!trial_selected(trial))
+			return false;
+		if((events & event_mask) != 0)
+			return true;
+		return step >= 0 && ((interval > 0 && step%interval == 0) || step < first_steps);
+	};
+
+	/**
+	 * Returns true, if the row of this step is needed (written, or held back for the last steps)
+	 *
+	 *  @param (int) trial: trial number
+	 *  @param (int) step: step of the trial, -1 = after the end of the trial (events only)
+	 *  @param (int) events: events in the step before (bit mask)
+	 *  @return (bool)
+	 */
+	bool wants(int trial, int step, int events) const {
+		if(last_steps > 0 && step >= 0)
+			return trial_selected(trial);
+		return keeps(trial, step, events);
+	};
+
+	/**
+	 * Returns the sampling interval (-1: default of the simulation)
+	 *
+	 *  @return (int)
+	 */
+	int every() const {
+		return interval;
+	};
+
+	/**
+	 * Returns the number of last steps held back
+	 *
+	 *  @return (int)
+	 */
+	int last() const {
+		return last_steps;
+	};
+
+private:
+	int interval;                                   // sampling interval in steps (0: none, -1: default)
+	int event_mask;                                 // events that trigger a sample
+	int first_steps;                                // first K steps of a trial
+	int last_steps;                                 // last K steps of a trial
+	int num_trials;                                 // number of written trials (0: all)
+	vector<int> selected;                           // written trials, sorted (empty: all)
+};
+
+
+#endif /* SAMPLING_H_ */
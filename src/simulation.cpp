@@ -27,12 +27,18 @@
 
 #include "simulation.h"
 
-Simulation::Simulation(int in_numtrials, int in_agents, bool random_env){
+Simulation::Simulation(int in_numtrials, int in_agents, bool random_env, const string& out_dir) :
+		Simulation(in_numtrials, in_agents, random_env, out_dir, random_device{}()) {
+}
+
+Simulation::Simulation(int in_numtrials, int in_agents, bool random_env, const string& out_dir, uint64_t _seed){
+	path = out_dir;
 	N = in_numtrials;
 	agents = in_agents;
 	rand_env = random_env;
 	VERBOSE = false;
 	SILENT = false;
+	master_seed = _seed;
 
 	pin_on = true;
 	homing_on = false;
@@ -43,7 +49,7 @@ Simulation::Simulation(int in_numtrials, int in_agents, bool random_env){
 
 	(VERBOSE)?printf("Building environment.\n"):VERBOSE;
 	//environment = (rand_env ? new Environment(10, 10, 25., 1) : new Environment(agents));
-	environment = (rand_env ? new Environment(ngs, nlms, m_rad, agents) : new Environment(agents));
+	environment = (rand_env ? new Environment(ngs, nlms, m_rad, agents, path, master_seed) : new Environment(agents, path, master_seed));
 	(VERBOSE)?printf("Done.\n"):VERBOSE;
 
 	T = 0.;
@@ -61,41 +67,42 @@ Simulation::Simulation(int in_numtrials, int in_agents, bool random_env){
 	home_rate.resize(N);
 	goal_rate.resize(N);
 
-	agent_str.width(10);
-	agent_str << "#Trial\t#Trial_t\t#X\t#Y\t#Dis\t#Phi\t#Theta\t#Global_t\t#EligibLM\n";
-	agent_str.open("data/agent.dat");
-	lmr_attract.width(10);
-	lmr_attract << "#Trial\t#Trial_t\t#X\t#Y\t#LMcatch\t#LMattract\t#LMcatchm\t#LMseen\n";
-	lmr_attract.open("data/lmattract.dat");
-	endpts_str.open("data/endpoints.dat");
+	trace_mode = trace_text;
+	trace_policy = async_off;
+	writer = nullptr;
+	sample_events = 0;
+	prev_hits = 0;
+	prev_lm_catch = false;
+	prev_in_pipe = false;
+	num_LV_units = 0;
+	checkpoint_every = 0;
+	checkpoint_trial = 0;
+	endpts_str.open(path + "data/endpoints");
+	endpts_str.column("trial", col_int);
+	for(unsigned int i = 0; i < agents; i++){
+		endpts_str.column("x");
+		endpts_str.column("y");
+		endpts_str.column("dis", col_general, 6, (i+1 < agents) ? "\t" : "");
+	}
 	//error_dist.open(str_names.at(pos).c_str());
-	homevector_str.open("data/homevector.dat");
-	globalvector_str.width(10);
-	globalvector_str << "#Trial_t\t#Global_t\t#X\t#Y\t#Theta_GV\t#D_GV\t#Expl\t#GoalCount\t#GV_ThPVA\n";
-	globalvector_str.open("data/globalvector.dat");
-	localvector_str.open("data/localvector.dat");
-	refvector_str.open("data/refvector.dat");
-	lmr_signals.open("data/lmr_signals.dat");
-	reward_str.open("data/reward.dat");
-	sim_cfg.open("data/sim.cfg");
+	sim_cfg.open((path + "data/sim.cfg").c_str());
 	sim_cfg << "# Na\t# Nn\t# Sno\t# Leak\t# Uncno" << endl;
 	sim_cfg << agents << "\t";
-	length_scaling.open("data/l_scale.dat");
-	out_signals.open("data/signals.dat");
-	lmr_angles.open("data/lmr_angles.dat");
-	adaptive_expl.open("data/adaptive_expl.dat");
-	trialtimes.open("data/trialtimes.dat");
-	performance_gvl.open("data/performgvl.dat");
-	performance_gvl.width(10);
-	performance_gvl << "#Trial\t#ExplRate\t#HomeRate\t#GoalRate\t#CurrHome\t#CurrGoal\t#HomeLen\t#GoalLen\n";
-	LV_elig_traces.open("data/lv_eligtraces.dat");
-	LV_elig_traces.width(10);
-	LV_elig_traces << fixed;
-	LV_elig_traces << "#Trial\t#Global_t\t#X\t#Y\tR\t";
-	LV_learning.open("data/lv_learning.dat");
-	LV_learning.width(10);
-	LV_learning << fixed;
-	LV_learning << "#Trial\t#Global_t\t#X\t#Y\tR\t";
+	trialtimes.open(path + "data/trialtimes");
+	trialtimes.column("trial", col_int);
+	trialtimes.column("start_t");
+	trialtimes.column("end_t");
+	trialtimes.column("duration", col_general, 6, "");
+	performance_gvl.open(path + "data/performgvl");
+	performance_gvl.comment("#Trial\t#ExplRate\t#HomeRate\t#GoalRate\t#CurrHome\t#CurrGoal\t#HomeLen\t#GoalLen");
+	performance_gvl.column("trial", col_int);
+	performance_gvl.column("expl", col_fixed, 6);
+	performance_gvl.column("home_rate", col_fixed, 6);
+	performance_gvl.column("goal_rate", col_fixed, 6);
+	performance_gvl.column("curr_home", col_int, 0, "\t\t");
+	performance_gvl.column("curr_goal", col_int, 0, "\t\t");
+	performance_gvl.column("home_count", col_fixed, 0, "\t\t");
+	performance_gvl.column("goal_count", col_fixed, 0, "");
 }
 
 Simulation::~Simulation(){
@@ -119,6 +126,7 @@ Simulation::~Simulation(){
 	performance_gvl.close();
 	LV_elig_traces.close();
 	LV_learning.close();
+	delete writer;
 	delete environment;
 }
 
@@ -142,18 +150,98 @@ void Simulation::add_pipe(double x0, double x1, double y0, double y1){
 	environment->add_pipe(x0,x1,y0,y1);
 }
 
+bool Simulation::use_layout(const shared_ptr<const WorldLayout>& world){
+	return environment->use_layout(world);
+}
+
 void Simulation::beta(bool _opt){
 	beta_on = _opt;
 }
 
+void Simulation::batch_agents(bool _opt){
+	environment->set_agent_batch(_opt);
+}
+
 Controller* Simulation::c(int i){
 	return controllers.at(i);
 }
 
+void Simulation::checkpoint(int K, const string& filename){
+	checkpoint_every = K;
+	checkpoint_file = filename;
+}
+
+void Simulation::checkpoint(Checkpoint& cp){
+	cp.check(agents, "number of agents");
+	cp.pod(trial);
+	cp.pod(global_t);
+	cp.pod(trial_t);
+	cp.pod(timestep);
+	cp.pod(start_time);
+	cp.pod(master_seed);
+	cp.io(avg_length);
+	cp.io(is_home);
+	cp.pod(curr_is_home);
+	cp.io(home_rate);
+	cp.io(is_goal);
+	cp.pod(curr_is_goal);
+	cp.io(goal_rate);
+	cp.io(expl_rate);
+	cp.io(avg_reward);
+	cp.pod(count_home);
+	cp.pod(count_goal);
+	cp.pod(prev_expl);
+	cp.pod(trial_converge);
+	cp.io(pi_error);
+	cp.io(pi_error_max);
+	cp.io(total_pi_error);
+	environment->checkpoint(cp);
+}
+
 Environment* Simulation::e(){
 	return environment;
 }
 
+void Simulation::fast_forward(bool _opt){
+	environment->set_fast_forward(_opt);
+}
+
+Simulation* Simulation::fork(const string& out_dir){
+	return fork(out_dir, sens_noise, neur_noise, leak, weight_noise);
+}
+
+Simulation* Simulation::fork(const string& out_dir, double sensory_noise, double uncor_noise, double leakage, double syn_noise){
+	/// same setup: empty environment with the goals, landmarks and pipes of this one
+	Simulation* branch = new Simulation(N, agents, false, out_dir, master_seed);
+	branch->rand_env = rand_env;
+	branch->VERBOSE = VERBOSE;
+	branch->SILENT = SILENT;
+	branch->trace_mode = trace_mode;
+	branch->trace_policy = trace_policy;
+	branch->sampling_policies = sampling_policies;
+	branch->pin_on = pin_on;
+	branch->homing_on = homing_on;
+	branch->gvlearn_on = gvlearn_on;
+	branch->gvnavi_on = gvnavi_on;
+	branch->lvlearn_on = lvlearn_on;
+	branch->beta_on = beta_on;
+	branch->environment->copy_layout(environment);
+	branch->init_controller(neurons, num_GV_units, num_LV_units, sensory_noise, uncor_noise, leakage, syn_noise);
+
+	/// same state: snapshot in memory
+	stringstream state(ios::in | ios::out | ios::binary);
+	Checkpoint out(state, true);
+	checkpoint(out);
+	Checkpoint in(state, false);
+	branch->checkpoint(in);
+	if(!out.good() || !in.good()){
+		delete branch;
+		return nullptr;
+	}
+	branch->checkpoint_trial = trial - 1;
+	return branch;
+}
+
 void Simulation::gvlearn(bool _opt){
 	gvlearn_on = _opt;
 }
@@ -166,18 +254,18 @@ void Simulation::init_controller(int num_neurons, int num_gv_units, int num_lv_u
 	sim_cfg << num_neurons << "\t" << num_gv_units << "\t" << num_lv_units << "\t" << sensory_noise << "\t" << uncor_noise << "\t" << leakage << endl;
 	num_GV_units = num_gv_units;
 	num_LV_units = num_lv_units;
-	LV_elig_traces.width(10);
-	LV_learning.width(10);
-	for(unsigned int index = 0; index < num_LV_units; index++){
-		LV_elig_traces << "#Elig_tr[" << index << "]\t";
-		LV_learning << "Value[" << index << "]\t";
-	}
-	LV_elig_traces << endl;
-	LV_learning << endl;
+	neurons = num_neurons;
+	sens_noise = sensory_noise;
+	neur_noise = uncor_noise;
+	leak = leakage;
+	weight_noise = syn_noise;
 
 	vector<bool> opt_switches = {homing_on, gvlearn_on, lvlearn_on, SILENT};
+	if(!SILENT)
+		printf("Master seed: %llu\n", (unsigned long long) master_seed);
 	for(unsigned int i= 0; i< agents; i++){
-		Controller* control = new Controller(num_neurons, num_gv_units, num_lv_units, sensory_noise, leakage, uncor_noise, syn_noise, opt_switches);
+		Controller* control = new Controller(num_neurons, num_gv_units, num_lv_units, sensory_noise, leakage, uncor_noise, syn_noise, opt_switches, path);
+		control->seed(master_seed, i);
 		int size = N*pow( 10, int(log10( double( num_neurons ) ) ) );
 		control->set_sample_int(size/10);      // sample activity data every 10 time steps
 		control->beta_on = beta_on;
@@ -190,6 +278,238 @@ void Simulation::lvlearn(bool _opt){
 	lvlearn_on = _opt;
 }
 
+void Simulation::open_traces(){
+	int K = (lvlearn_on) ? c()->K() : 0;
+	stringstream name;
+
+	agent_str.open(path + "data/agent", trace_mode);
+	agent_str.column("trial", col_int);
+	agent_str.column("trial_t");
+	agent_str.column("x");
+	agent_str.column("y");
+	agent_str.column("dis");
+	agent_str.column("phi");
+	agent_str.column("theta");
+	agent_str.column("global_t");
+	for(int lm_i = 0; lm_i < K; lm_i++){
+		name.str(string());
+		name << "eligib_lm" << lm_i;
+		agent_str.column(name.str());
+	}
+	agent_str.column("dphi", col_general, 6, "");
+
+	lmr_attract.open(path + "data/lmattract", trace_mode);
+	lmr_attract.column("trial", col_fixed, 0);
+	lmr_attract.column("global_t", col_fixed, 1);
+	lmr_attract.column("x", col_fixed, 6);
+	lmr_attract.column("y", col_fixed, 6);
+	lmr_attract.column("lm_catch", col_int);
+	lmr_attract.column("lm_attract", col_fixed, 6);
+	for(int lm_i = 0; lm_i < 3; lm_i++){
+		name.str(string());
+		name << "catchment" << lm_i;
+		lmr_attract.column(name.str(), col_fixed, 6);
+	}
+	for(int lm_i = 0; lm_i < 3; lm_i++){
+		name.str(string());
+		name << "seen" << lm_i;
+		lmr_attract.column(name.str(), col_fixed, 6);
+	}
+
+	homevector_str.open(path + "data/homevector", trace_mode);
+	homevector_str.column("trial_t");
+	homevector_str.column("global_t");
+	homevector_str.column("hv_x");
+	homevector_str.column("hv_y");
+	homevector_str.column("hvm_x");
+	homevector_str.column("hvm_y");
+	homevector_str.column("hv_theta");
+	homevector_str.column("hvm_theta");
+	homevector_str.column("pi_error");
+	homevector_str.column("hv_len");
+	homevector_str.column("dis", col_general, 6, "");
+
+	globalvector_str.open(path + "data/globalvector", trace_mode);
+	globalvector_str.column("trial_t");
+	globalvector_str.column("global_t");
+	globalvector_str.column("gv_x");
+	globalvector_str.column("gv_y");
+	globalvector_str.column("gv_theta");
+	globalvector_str.column("gv_len");
+	globalvector_str.column("expl");
+	globalvector_str.column("goal_count");
+	globalvector_str.column("gv_th_pva", col_general, 6, "");
+
+	refvector_str.open(path + "data/refvector", trace_mode);
+	refvector_str.column("trial_t");
+	refvector_str.column("global_t");
+	refvector_str.column("rv_x");
+	refvector_str.column("rv_y");
+	refvector_str.column("rv_theta");
+	refvector_str.column("rv_len", col_general, 6, "");
+
+	localvector_str.open(path + "data/localvector", trace_mode);
+	localvector_str.column("trial_t");
+	localvector_str.column("global_t", col_general, 6, (K > 0) ? "\t" : "");
+	for(int lm_i = 0; lm_i < K; lm_i++){
+		name.str(string());
+		name << "lv" << lm_i << "_";
+		localvector_str.column(name.str() + "x");
+		localvector_str.column(name.str() + "y");
+		localvector_str.column(name.str() + "theta");
+		localvector_str.column(name.str() + "len");
+		localvector_str.column(name.str() + "th_pva", col_general, 6, (lm_i < K-1) ? "\t" : "");
+	}
+
+	LV_elig_traces.open(path + "data/lv_eligtraces", trace_mode);
+	LV_learning.open(path + "data/lv_learning", trace_mode);
+	name.str(string());
+	for(int index = 0; index < num_LV_units; index++)
+		name << "#Elig_tr[" << index << "]\t";
+	LV_elig_traces.comment("#Trial\t#Global_t\t#X\t#Y\tR\t" + name.str());
+	name.str(string());
+	for(int index = 0; index < num_LV_units; index++)
+		name << "Value[" << index << "]\t";
+	LV_learning.comment("#Trial\t#Global_t\t#X\t#Y\tR\t" + name.str());
+	TraceStream* lv_streams[] = {&LV_elig_traces, &LV_learning};
+	for(int s = 0; s < 2; s++){
+		lv_streams[s]->column("trial", col_fixed, 0);
+		lv_streams[s]->column("global_t", col_fixed, 1, "\t\t");
+		lv_streams[s]->column("x", col_fixed, 3);
+		lv_streams[s]->column("y", col_fixed, 3);
+		lv_streams[s]->column("lv_reward", col_fixed, 6);
+		for(int index = 0; index < num_LV_units; index++){
+			name.str(string());
+			name << ((s == 0) ? "elig_tr" : "value") << index;
+			lv_streams[s]->column(name.str(), col_fixed, 6);
+		}
+	}
+
+	reward_str.open(path + "data/reward", trace_mode);
+	reward_str.column("trial_t");
+	reward_str.column("global_t");
+	reward_str.column("accum_reward");
+	reward_str.column("value");
+	reward_str.column("reward", col_general, 6, "");
+
+	length_scaling.open(path + "data/l_scale", trace_mode);
+	length_scaling.column("dis");
+	length_scaling.column("sum_pi");
+	length_scaling.column("neurons", col_int, 0, "");
+
+	out_signals.open(path + "data/signals", trace_mode);
+	out_signals.column("trial_t");
+	out_signals.column("global_t");
+	out_signals.column("output_hv");
+	out_signals.column("output_gv");
+	out_signals.column("output_lv");
+	out_signals.column("output_rand", col_general, 6, "");
+
+	lmr_signals.open(path + "data/lmr_signals", trace_mode);
+	lmr_signals.column("trial_t");
+	lmr_signals.column("global_t");
+	const char* lmr_names[] = {"state", "dstate", "cl_state", "elig", "elig_value", "value"};
+	for(int lm_unit = 0; lm_unit < K; lm_unit++)
+		for(int k = 0; k < 6; k++){
+			name.str(string());
+			name << lmr_names[k] << lm_unit;
+			lmr_signals.column(name.str());
+		}
+
+	lmr_angles.open(path + "data/lmr_angles", trace_mode);
+	lmr_angles.column("trial_t");
+	lmr_angles.column("global_t");
+	lmr_angles.column("x");
+	lmr_angles.column("y");
+	lmr_angles.column("lm_theta");
+	lmr_angles.column("phi");
+	lmr_angles.column("lm_attract");
+	lmr_angles.column("lm_x");
+	lmr_angles.column("lm_y", col_general, 6, "");
+
+	adaptive_expl.open(path + "data/adaptive_expl", trace_mode);
+	adaptive_expl.column("trial_t");
+	adaptive_expl.column("global_t");
+	adaptive_expl.column("trial", col_int);
+	adaptive_expl.column("beta");
+	adaptive_expl.column("value");
+	adaptive_expl.column("avg_reward");
+	adaptive_expl.column("expl");
+	adaptive_expl.column("expl_value", col_general, 6, "");
+
+	if(trace_policy != async_off){
+		if(!writer)
+			writer = new TraceWriter(trace_policy);
+		vector<TraceStream*> traces = data_streams();
+		for(unsigned int k = 0; k < traces.size(); k++)
+			if(traces[k]->is_open())
+				traces[k]->async(writer);
+	}
+}
+
+vector<TraceStream*> Simulation::data_streams(){
+	vector<TraceStream*> traces = trace_streams();
+	traces.push_back(&endpts_str);
+	traces.push_back(&trialtimes);
+	traces.push_back(&performance_gvl);
+	return traces;
+}
+
+const vector<TraceStream*>& Simulation::trace_streams(){
+	if(sample_streams.empty()){
+		TraceStream* traces[] = {&agent_str, &lmr_attract, &homevector_str, &globalvector_str, &refvector_str,
+				&localvector_str, &LV_elig_traces, &LV_learning, &reward_str, &length_scaling, &out_signals,
+				&lmr_signals, &lmr_angles, &adaptive_expl};
+		sample_streams.assign(traces, traces + sizeof(traces)/sizeof(traces[0]));
+	}
+	return sample_streams;
+}
+
+void Simulation::apply_sampling(){
+	const vector<TraceStream*>& traces = trace_streams();
+	for(unsigned int k = 0; k < traces.size(); k++){
+		SamplingPolicy policy;
+		if(sampling_policies.count(traces[k]->name()) > 0)
+			policy = sampling_policies[traces[k]->name()];
+		else if(sampling_policies.count("") > 0)
+			policy = sampling_policies[""];
+		if(policy.every() < 0)
+			policy.every(sample_time);
+		policy.select_trials(N, master_seed);
+		traces[k]->sampling(policy);
+	}
+}
+
+bool Simulation::sample(int step){
+	const vector<TraceStream*>& traces = trace_streams();
+	bool any = false;
+	for(unsigned int k = 0; k < traces.size(); k++)
+		any = traces[k]->sample(trial, step, sample_events) || any;
+	return any;
+}
+
+void Simulation::end_trial_samples(){
+	const vector<TraceStream*>& traces = trace_streams();
+	for(unsigned int k = 0; k < traces.size(); k++)
+		traces[k]->end_trial();
+	/// state after the last step (e.g., homing success), if an event policy asks for it
+	if(sample(-1))
+		writeTrialData();
+	for(unsigned int k = 0; k < traces.size(); k++)
+		traces[k]->end_trial();
+}
+
+bool Simulation::load_state(const string& filename){
+	Checkpoint cp(filename, false);
+	checkpoint(cp);
+	if(!cp.good())
+		return false;
+	checkpoint_trial = trial - 1;
+	if(!SILENT)
+		printf("Loaded checkpoint %s (continue with trial %u)\n", filename.c_str(), trial);
+	return true;
+}
+
 void Simulation::reset(){
 	timestep = 0;
 	trial_t = 0.;
@@ -202,31 +522,60 @@ void Simulation::run(int in_numtrials, double in_duration, double in_interval){
 	N = in_numtrials;
 	T = in_duration;
 	dt = in_interval;
-	global_t = 0.0;
+	/// probes of this thread and of its worker threads count for this simulation only
+	Profiler::Scope profile_scope(&profiler, 0);
+	if(trial == 1)
+		global_t = 0.0;
+	if(expl_rate.size() < N){
+		/// a continued run may have more trials than the simulation was created with
+		expl_rate.resize(N);
+		home_rate.resize(N);
+		goal_rate.resize(N);
+	}
 	int total_steps = int(N*T/dt);
 	sample_time = int(total_steps/1000000.);
 	if(sample_time < 1)
 		sample_time = 1;
 	if(c()->get_inward() == 0)
 		c()->set_inward(T/dt);
+	if(sampling_policies.count("activity") > 0 && sampling_policies["activity"].every() > 0)
+		for(unsigned int i= 0; i< agents; i++)
+			c(i)->set_sample_int(sampling_policies["activity"].every());
+	for(unsigned int i= 0; i< agents; i++)
+		c(i)->reserve_samples(N+1-trial, int(T/dt)+1);
+	if(!agent_str.is_open())
+		open_traces();
+	apply_sampling();
+	if(Profiler::enabled)
+		profiler.clear();
 	if(!SILENT){
 		printf("Total timesteps is %u\nSet sampling interval to %u\n", total_steps, sample_time);
 		printf("Inward time is %u\n", c()->get_inward());
 	}
 
 	for(; trial < N+1; trial++){
-		if(SILENT && trial%(N/10)==0)
+		if(checkpoint_every > 0 && (trial-1)%checkpoint_every == 0 && trial-1 > checkpoint_trial)
+			save_state(checkpoint_file);
+		if(SILENT && trial%max(N/10, 1)==0)
 			printf("%u\n", trial);
 		start_time = global_t;
 		prev_expl = c()->expl(0);
+		if(Profiler::enabled)
+			profiler.begin_trial();
 
 		reset();
-		while(trial_t < T){
-			if(int(trial_t/dt)%sample_time == 0 && !SILENT)
+		sample_events = 0;
+		prev_hits = 0;
+		prev_lm_catch = a(0)->lm_catch;
+		prev_in_pipe = a(0)->in_pipe;
+		for(int step = 0; trial_t < T; step++){
+			if(!SILENT && sample(step))
 				writeTrialData();
 			update();
 			pi_error( (a(0)->HV()-a(0)->v()).len() );
 		}
+		if(!SILENT)
+			end_trial_samples();
 		if(trial_t <= T + 0.5){
 			curr_is_home = 0;
 			is_home(curr_is_home);
@@ -237,6 +586,8 @@ void Simulation::run(int in_numtrials, double in_duration, double in_interval){
 			curr_is_goal = 0;
 		is_goal(curr_is_goal);
 
+		if(Profiler::enabled)
+			profiler.end_trial(trial);
 		if(prev_expl >= 0.5 && c()->expl(0) < 0.5)
 			trial_converge = trial;
 		expl_rate.at(trial-1) = c()->expl(0);
@@ -287,6 +638,63 @@ void Simulation::run(int in_numtrials, double in_duration, double in_interval){
 			}
 		}
 	}
+	if(checkpoint_every > 0 && (trial-1)%checkpoint_every == 0 && trial-1 > checkpoint_trial)
+		save_state(checkpoint_file);
+	if(Profiler::enabled){
+		profiler.summary();
+		profiler.write(path + "data/profile.dat");
+	}
+	if(writer && writer->dropped() > 0)
+		printf("WARNING: %ld rows of data dropped (output slower than the simulation).\n", writer->dropped());
+}
+
+bool Simulation::save_state(const string& filename){
+	vector<TraceStream*> traces = data_streams();
+	for(unsigned int k = 0; k < traces.size(); k++)
+		traces[k]->flush();
+	sim_cfg.flush();
+
+	/// written to a temporary file first, so an interrupted write keeps the previous snapshot
+	string tmp = filename + ".tmp";
+	bool ok;
+	{
+		Checkpoint cp(tmp, true);
+		checkpoint(cp);
+		ok = cp.good();
+	}
+	if(!ok || rename(tmp.c_str(), filename.c_str()) != 0){
+		printf("WARNING: Checkpoint %s not written.\n", filename.c_str());
+		return false;
+	}
+	checkpoint_trial = trial - 1;
+	return true;
+}
+
+void Simulation::seed(uint64_t _seed){
+	master_seed = _seed;
+	environment->seed(master_seed);
+	for(unsigned int i = 0; i < controllers.size(); i++)
+		controllers.at(i)->seed(master_seed, i);
+}
+
+void Simulation::trace_format(int _mode){
+	trace_mode = _mode;
+}
+
+void Simulation::trace_async(int _policy){
+	trace_policy = _policy;
+}
+
+void Simulation::sampling(const string& stream, const SamplingPolicy& policy){
+	sampling_policies[stream] = policy;
+}
+
+void Simulation::threads(int _threads){
+	environment->set_threads(_threads);
+}
+
+const Profiler& Simulation::profile() const {
+	return profiler;
 }
 
 void Simulation::set_inward(int _time){
@@ -296,6 +704,7 @@ void Simulation::set_inward(int _time){
 void Simulation::update(){
 //	if(accu(c()->GV_module()->dW()) < 0.0 && (a(0)->pos - c()->HV()).len() > 0.3)
 //		printf("GV learn at (%g,%g) -> (%g, %g), R = %g\n", a(0)->pos.x, a(0)->pos.y, c()->HV().x, c()->HV().y, c()->GV_module()->R());
+	PROFILE(PROF_STEP);
 	if(timestep%1000==0 && N == 1 && pin_on && !SILENT)
 		printf("Time = %g\te = %g\te_max = %g\n", trial_t, pi_error.mean(), pi_error_max.mean());
 	timestep++;
@@ -305,7 +714,23 @@ void Simulation::update(){
 		//printf("%u\tTheta=%f\n", timestep, environment->a(0)->th().deg());
 	avg_reward(c()->R(0));
 	environment->update();
-	count_goal += environment->get_hits(0);
+	int hits = environment->get_hits(0);
+	count_goal += hits;
+	if(!SILENT){
+		/// events of agent 0 for event-triggered samples
+		sample_events = 0;
+		if(hits > prev_hits)
+			sample_events |= event_goal;
+		if(a(0)->lm_catch && !prev_lm_catch)
+			sample_events |= event_landmark;
+		if(a(0)->in_pipe && !prev_in_pipe)
+			sample_events |= event_pipe;
+		if(environment->stop_trial)
+			sample_events |= event_home;
+		prev_hits = hits;
+		prev_lm_catch = a(0)->lm_catch;
+		prev_in_pipe = a(0)->in_pipe;
+	}
 	if(environment->stop_trial){
 		if(N < 10 && !SILENT)
 			printf("Homing success at %g s\n", trial_t);
@@ -317,130 +742,147 @@ void Simulation::update(){
 }
 
 void Simulation::writeSimData(){
-	trialtimes << trial << "\t" << start_time << "\t" << global_t << "\t" << global_t-start_time << endl;
-	performance_gvl << fixed;
+	trialtimes << trial << start_time << global_t << global_t-start_time;
+	trialtimes.end_row();
 	if(gvlearn_on){
-		performance_gvl << setprecision(0) << trial << "\t" ;
-		performance_gvl	<< setprecision(6) << c()->expl(0) << "\t";
-		performance_gvl	<< setprecision(6) << is_home.mean() << "\t";
-		performance_gvl	<< setprecision(6) << is_goal.mean() << "\t";
-		performance_gvl	<< setprecision(0) << curr_is_home << "\t\t";
-		performance_gvl	<< setprecision(0) << curr_is_goal << "\t\t";
-		performance_gvl	<< setprecision(0) << is_home.count() << "\t\t";
-		performance_gvl	<< setprecision(0) << is_goal.count() << endl;
+		performance_gvl << trial << c()->expl(0) << is_home.mean() << is_goal.mean();
+		performance_gvl << curr_is_home << curr_is_goal << is_home.count() << is_goal.count();
+		performance_gvl.end_row();
 	}
 
 	endpts_str << trial;
 	for(unsigned int i= 0; i< agents; i++){
-		endpts_str << "\t" << a(i)->x()<< "\t" << a(i)->y() << "\t" << a(i)->d();
+		endpts_str << a(i)->x() << a(i)->y() << a(i)->d();
 	}
-	endpts_str << endl;
+	endpts_str.end_row();
 }
 
 void Simulation::writeTrialData(){
-	agent_str << trial << "\t" << trial_t;						//1,2
-	agent_str << "\t" << a(0)->x()<< "\t" << a(0)->y();			//3,4
-	agent_str << "\t" << a(0)->d() << "\t" << a(0)->phi();		//5,6
-	agent_str << "\t" << a(0)->v().ang() << "\t" << global_t;	//7,8
-	if(lvlearn_on){
-		for(int lm_i=0; lm_i < c()->K(); lm_i++)
-			agent_str  << "\t" << c()->el_lm(lm_i);	// TODO: different streams for different agents
-	}
-	agent_str << "\t" << a(0)->dphi();
-	agent_str << endl;
-
-	lmr_attract << fixed;
-	lmr_attract << setprecision(0) << trial                         << "\t";
-	lmr_attract << setprecision(1) << global_t                      << "\t";
-	lmr_attract << setprecision(6) << a(0)->x()                     << "\t";
-	lmr_attract << setprecision(6) << a(0)->y()                     << "\t";
-	lmr_attract << setprecision(6) << a(0)->lm_catch                << "\t";
-	lmr_attract << setprecision(6) << a(0)->get_lmcontrol()         << "\t";
-	lmr_attract << setprecision(6) << e()->lm_stats.catchment(0, 0) << "\t"; // 7
-	lmr_attract << setprecision(6) << e()->lm_stats.catchment(1, 0) << "\t"; // 8
-	lmr_attract << setprecision(6) << e()->lm_stats.catchment(2, 0) << "\t"; // 9
-	lmr_attract << setprecision(6) << e()->lm_stats.seen(0, 0)      << "\t"; // 10
-	lmr_attract << setprecision(6) << e()->lm_stats.seen(1, 0)      << "\t"; // 11
-	lmr_attract << setprecision(6) << e()->lm_stats.seen(2, 0)      << "\t"; // 12
-	lmr_attract << endl;
-
-	error_dist  << (a(0)->x() - a(0)->HV().x) << "\t" << (a(0)->y() - a(0)->HV().y) << endl;
-	if(pin_on){
-		homevector_str << trial_t << "\t" << global_t; 													//1,2
-		homevector_str << "\t" << a(0)->HV().x << "\t" << a(0)->HV().y;									//3,4
-		homevector_str << "\t" << a(0)->HVm().x << "\t" << a(0)->HVm().y; 								//5,6
-		homevector_str << "\t" << a(0)->HV().ang() << "\t" << a(0)->HVm().ang(); 						//7,8
-		homevector_str << "\t" <<  (a(0)->HV()-a(0)->v()).len() << "\t" <<  a(0)->HV().len();			//9,10
-		homevector_str << "\t" << a(0)->d() << endl;	//11
+	PROFILE(PROF_TRIALDATA);
+	/// only streams whose sampling policy needs this step (all, if called directly)
+	if(agent_str.wanted()){
+		agent_str << trial << trial_t;								//1,2
+		agent_str << a(0)->x() << a(0)->y();						//3,4
+		agent_str << a(0)->d() << a(0)->phi().rad();				//5,6
+		agent_str << a(0)->v().ang().rad() << global_t;			//7,8
+		if(lvlearn_on){
+			for(int lm_i=0; lm_i < c()->K(); lm_i++)
+				agent_str << c()->el_lm(lm_i);	// TODO: different streams for different agents
+		}
+		agent_str << a(0)->dphi().rad();
+		agent_str.end_row();
 	}
-	if(gvlearn_on){
-		globalvector_str << trial_t << "\t" << global_t;
-		globalvector_str << "\t" << a(0)->GV().x << "\t" << a(0)->GV().y;						//3,4
-		globalvector_str << "\t" << a(0)->GV().ang() << "\t" << a(0)->GV().len();				//5,6
-		globalvector_str << "\t" << c()->expl(0) << "\t" << 1.0*count_goal;						//7,8
-		globalvector_str << "\t" << c()->GV_vecavg() << endl;									//9
-	}
-	if(lvlearn_on){
-		refvector_str << trial_t << "\t" << global_t;
-		refvector_str << "\t" << c()->RV().x << "\t" << c()->RV().y << "\t" << c()->RV().ang() << "\t" << c()->RV().len() << endl;
-		localvector_str << trial_t << "\t" << global_t;
-		for(int lm_i=0; lm_i < c()->K(); lm_i++)
-			localvector_str << "\t" << c()->LV(lm_i).x << "\t" << c()->LV(lm_i).y << "\t" << c()->LV(lm_i).ang() << "\t" << c()->LV(lm_i).len() << "\t" << c()->LV_vecavg(lm_i);
-		localvector_str  << endl;
-
-		LV_elig_traces << fixed;
-		LV_elig_traces << setprecision(0) << trial << "\t";
-		LV_elig_traces << setprecision(1) << global_t << "\t\t";
-		LV_elig_traces << setprecision(3) << a(0)->x() << "\t";
-		LV_elig_traces << setprecision(3) << a(0)->y() << "\t";
-		LV_elig_traces << setprecision(6) << c(0)->LV_reward() << "\t";
+
+	if(lmr_attract.wanted()){
+		lmr_attract << trial << global_t;
+		lmr_attract << a(0)->x() << a(0)->y();
+		lmr_attract << a(0)->lm_catch << a(0)->get_lmcontrol();
+		lmr_attract << e()->lm_stats.catchment(0, 0); // 7
+		lmr_attract << e()->lm_stats.catchment(1, 0); // 8
+		lmr_attract << e()->lm_stats.catchment(2, 0); // 9
+		lmr_attract << e()->lm_stats.seen(0, 0);      // 10
+		lmr_attract << e()->lm_stats.seen(1, 0);      // 11
+		lmr_attract << e()->lm_stats.seen(2, 0);      // 12
+		lmr_attract.end_row();
+	}
+
+	error_dist  << (a(0)->x() - a(0)->HV().x) << "\t" << (a(0)->y() - a(0)->HV().y) << "\n";
+	if(pin_on && homevector_str.wanted()){
+		Vec hv = a(0)->HV();
+		Vec hvm = a(0)->HVm();
+		homevector_str << trial_t << global_t; 									//1,2
+		homevector_str << hv.x << hv.y;											//3,4
+		homevector_str << hvm.x << hvm.y; 										//5,6
+		homevector_str << hv.ang().rad() << hvm.ang().rad(); 					//7,8
+		homevector_str << (hv-a(0)->v()).len() << hv.len();						//9,10
+		homevector_str << a(0)->d();											//11
+		homevector_str.end_row();
+	}
+	if(gvlearn_on && globalvector_str.wanted()){
+		Vec gv = a(0)->GV();
+		globalvector_str << trial_t << global_t;
+		globalvector_str << gv.x << gv.y;										//3,4
+		globalvector_str << gv.ang().rad() << gv.len();							//5,6
+		globalvector_str << c()->expl(0) << 1.0*count_goal;						//7,8
+		globalvector_str << c()->GV_vecavg().rad();								//9
+		globalvector_str.end_row();
+	}
+	if(lvlearn_on && refvector_str.wanted()){
+		Vec rv = c()->RV();
+		refvector_str << trial_t << global_t;
+		refvector_str << rv.x << rv.y << rv.ang().rad() << rv.len();
+		refvector_str.end_row();
+	}
+	if(lvlearn_on && localvector_str.wanted()){
+		localvector_str << trial_t << global_t;
+		for(int lm_i=0; lm_i < c()->K(); lm_i++){
+			Vec lv = c()->LV(lm_i);
+			localvector_str << lv.x << lv.y << lv.ang().rad() << lv.len() << c()->LV_vecavg(lm_i).rad();
+		}
+		localvector_str.end_row();
+	}
+	if(lvlearn_on && LV_elig_traces.wanted()){
+		LV_elig_traces << trial << global_t;
+		LV_elig_traces << a(0)->x() << a(0)->y();
+		LV_elig_traces << c(0)->LV_reward();
 		for(unsigned int index = 0; index < num_LV_units; index++){
-			LV_elig_traces 	<< setprecision(6) << c()->el_lm(index) << "\t";
+			LV_elig_traces << c()->el_lm(index);
 		}
-		LV_elig_traces << endl;
-
-		LV_learning << fixed;
-		LV_learning << setprecision(0) << trial << "\t";
-		LV_learning << setprecision(1) << global_t << "\t\t";
-		LV_learning << setprecision(3) << a(0)->x() << "\t";
-		LV_learning << setprecision(3) << a(0)->y() << "\t";
-		LV_learning << setprecision(6) << c(0)->LV_reward() << "\t";
+		LV_elig_traces.end_row();
+	}
+	if(lvlearn_on && LV_learning.wanted()){
+		LV_learning << trial << global_t;
+		LV_learning << a(0)->x() << a(0)->y();
+		LV_learning << c(0)->LV_reward();
 		for(unsigned int index = 0; index < num_LV_units; index++){
-			LV_learning 	<< setprecision(6) << c()->LV_reward(index) << "\t";
+			LV_learning << c()->LV_reward(index);
 		}
-		LV_learning << endl;
-	}
-	reward_str << trial_t << "\t" << global_t;
-	reward_str << "\t" << c()->R(0) << "\t" << c()->v(0) << "\t" << e()->r(0) <<  endl;
-	length_scaling << a(0)->v().len() << "\t" << sum(a(0)->pi()->get_output()) << "\t" << a(0)->c()->N() << endl;
-	out_signals << trial_t << "\t" << global_t << "\t";
-	out_signals << c()->output_hv << "\t";
-	out_signals << c()->output_gv << "\t";
-	out_signals << c()->output_lv << "\t";
-	out_signals << c()->output_rand << endl;
-
-	if(lvlearn_on){
-		lmr_signals << trial_t << "\t" << global_t << "\t";
+		LV_learning.end_row();
+	}
+	if(reward_str.wanted()){
+		reward_str << trial_t << global_t;
+		reward_str << c()->R(0) << c()->v(0) << e()->r(0);
+		reward_str.end_row();
+	}
+	if(length_scaling.wanted()){
+		length_scaling << a(0)->v().len() << sum(a(0)->pi()->get_output()) << a(0)->c()->N();
+		length_scaling.end_row();
+	}
+	if(out_signals.wanted()){
+		out_signals << trial_t << global_t;
+		out_signals << c()->output_hv;
+		out_signals << c()->output_gv;
+		out_signals << c()->output_lv;
+		out_signals << c()->output_rand;
+		out_signals.end_row();
+	}
+
+	if(lvlearn_on && lmr_signals.wanted()){
+		lmr_signals << trial_t << global_t;
 		for(int lm_unit = 0; lm_unit < c()->K(); lm_unit++){
-			lmr_signals << c()->LV_module()->state_lm(lm_unit) << "\t"  // 3
-					<< c()->LV_module()->dstate_lm(lm_unit) << "\t"     // 4
-					<< c()->LV_module()->cl_state_lm(lm_unit) << "\t"   // 5
-					<< c()->el_lm(lm_unit) << "\t"                      // 6
-					<< c()->el_LV_value(lm_unit) << "\t"                // 7
-					<< c()->LV_value(lm_unit) << "\t";                  // 8
+			lmr_signals << c()->LV_module()->state_lm(lm_unit)  // 3
+					<< c()->LV_module()->dstate_lm(lm_unit)     // 4
+					<< c()->LV_module()->cl_state_lm(lm_unit)   // 5
+					<< c()->el_lm(lm_unit)                      // 6
+					<< c()->el_LV_value(lm_unit)                // 7
+					<< c()->LV_value(lm_unit);                  // 8
 		}
-		lmr_signals << endl;
-		lmr_angles << trial_t << "\t" << global_t << "\t";
-		lmr_angles << a(0)->x()<< "\t" << a(0)->y() << "\t" ;			//3,4
-		lmr_angles << e()->get_visible_LM_th(0) << "\t"<< a(0)->phi()<< "\t"  << sin(e()->get_visible_LM_th(0) - a(0)->phi().rad()) << "\t"; //5,6,7
-		lmr_angles << 0.1*cos(e()->get_visible_LM_th(0)) << "\t" << 0.1*sin(e()->get_visible_LM_th(0)) << endl; // 8,9
+		lmr_signals.end_row();
+	}
+	if(lvlearn_on && lmr_angles.wanted()){
+		double lm_th = e()->get_visible_LM_th(0);
+		lmr_angles << trial_t << global_t;
+		lmr_angles << a(0)->x() << a(0)->y();										//3,4
+		lmr_angles << lm_th << a(0)->phi().rad() << sin(lm_th - a(0)->phi().rad()); //5,6,7
+		lmr_angles << 0.1*cos(lm_th) << 0.1*sin(lm_th);							// 8,9
+		lmr_angles.end_row();
 	}
 
-	if(gvlearn_on){
-		adaptive_expl << trial_t << "\t" << global_t << "\t";								// 1,2
-		adaptive_expl << trial << "\t" << c()->e_beta() << "\t";							// 3,4
-		adaptive_expl << c()->v(0) << "\t" << avg_reward.mean()  << "\t";					// 5,6
-		adaptive_expl << c()->expl(0)  << "\t" << 2. * c()->v(0) * c()->expl(0)  << endl;	// 7,8							//7
+	if(gvlearn_on && adaptive_expl.wanted()){
+		adaptive_expl << trial_t << global_t;										// 1,2
+		adaptive_expl << trial << c()->e_beta();									// 3,4
+		adaptive_expl << c()->v(0) << avg_reward.mean();							// 5,6
+		adaptive_expl << c()->expl(0) << 2. * c()->v(0) * c()->expl(0);			// 7,8
+		adaptive_expl.end_row();
 	}
 }
-
@@ -34,9 +34,15 @@
 #include <sstream>
 #include <cstdio>
 #include <cmath>
+#include <cstdint>
+#include <map>
+#include <random>
 #include <vector>
 #include "environment.h"
 #include "controller.h"
+#include "checkpoint.h"
+#include "profiler.h"
+#include "trace.h"
 
 
 /**
@@ -51,12 +57,24 @@ class Simulation {
 public:
 
 	/**
-	 * Constructor
+	 * Constructor (master seed from random_device)
 	 *
 	 *	@param (string) in_param_type: string of parameter specification (for parameter scan)
 	 *	@param (int) in_num_trials: number of subsequent trials
+	 *	@param (string) out_dir: output directory containing data/ and save/ (default: "./")
 	 */
-	Simulation(int in_numtrials, int in_agents, bool random_env);
+	Simulation(int in_numtrials, int in_agents, bool random_env, const string& out_dir = "./");
+
+	/**
+	 * Constructor with a master seed (agents and random environment)
+	 *
+	 *	@param (int) in_num_trials: number of subsequent trials
+	 *	@param (int) in_agents: number of agents
+	 *	@param (bool) random_env: true, if goals and landmarks are placed randomly
+	 *	@param (string) out_dir: output directory containing data/ and save/
+	 *	@param (uint64_t) _seed: master seed (see seed())
+	 */
+	Simulation(int in_numtrials, int in_agents, bool random_env, const string& out_dir, uint64_t _seed);
 
 	/**
 	 * Destructor. Closes IO file streams.
@@ -109,6 +127,15 @@ public:
 	 */
 	void add_pipe(double x0, double y0, double x1, double y1);
 
+	/**
+	 * Adds the goals and landmarks of a layout shared with other simulations
+	 * (before any other goals or landmarks; see Environment::use_layout)
+	 *
+	 *	@param (shared_ptr<const WorldLayout>) world: shared layout
+	 * 	@return (bool) true, if the layout is used
+	 */
+	bool use_layout(const shared_ptr<const WorldLayout>& world);
+
 	/**
 	 * Set beta learning controller option to _opt
 	 *
@@ -117,8 +144,27 @@ public:
 	 */
 	void beta(bool _opt);
 
+	/**
+	 * Set agent batch option to _opt: the PI networks of all agents are
+	 * integrated together in each step (same trajectories as without)
+	 *
+	 * @param (bool) _opt: true, if agent batching on
+	 * @return (void)
+	 */
+	void batch_agents(bool _opt);
+
 	Controller* c(int i=0);
 
+	/**
+	 * Writes a snapshot of the simulation every K completed trials (at the
+	 * start of the next trial); each snapshot replaces the previous one
+	 *
+	 * @param (int) K: number of trials between snapshots, 0 = off
+	 * @param (string) filename: snapshot file
+	 * @return (void)
+	 */
+	void checkpoint(int K, const string& filename);
+
 	Environment* e();
 
 
@@ -130,6 +176,32 @@ public:
 	 */
 	void gvlearn(bool _opt);
 
+	/**
+	 * Returns a copy of this simulation (between two trials) that writes into
+	 * its own output directory: same goals, landmarks, options and controller
+	 * parameters, same state of all agents, controllers and noise engines.
+	 * run() of the copy continues with the next trial. Only this simulation is
+	 * read, so several copies can be made (e.g., by parallel jobs) while it is
+	 * not running.
+	 *
+	 * @param (string) out_dir: output directory of the copy, containing data/ and save/
+	 * @return (Simulation*) copy, nullptr if the state could not be copied
+	 */
+	Simulation* fork(const string& out_dir);
+
+	/**
+	 * Returns a copy of this simulation with other noise and leakage parameters
+	 * of the controllers (the learned state is the same as for fork(out_dir))
+	 *
+	 * @param (string) out_dir: output directory of the copy, containing data/ and save/
+	 * @param (double) sensory_noise: sensory noise level
+	 * @param (double) uncor_noise: uncorrelated noise level
+	 * @param (double) leakage: leakage term for systematic errors
+	 * @param (double) syn_noise: synaptic noise level
+	 * @return (Simulation*) copy, nullptr if the state could not be copied
+	 */
+	Simulation* fork(const string& out_dir, double sensory_noise, double uncor_noise, double leakage, double syn_noise);
+
 	/**
 	 * Set global vector navigation controller option to _opt (also changes gv_learn)
 	 *
@@ -138,6 +210,15 @@ public:
 	 */
 	void gvnav(bool _opt);
 
+	/**
+	 * Set fast-forward option to _opt: environment checks are skipped while the
+	 * agent cannot reach any goal or landmark (same trajectories as without)
+	 *
+	 * @param (bool) _opt: true, if fast-forward on
+	 * @return (void)
+	 */
+	void fast_forward(bool _opt);
+
 	/**
 	 * Set local vector learning controller option to _opt
 	 *
@@ -167,6 +248,17 @@ public:
 	 */
 	void init_controller(int num_neurons=18, int num_gv_units=1, int num_lv_units=1, double sensory_noise=0.0, double uncor_noise = 0.0, double leakage=0.0, double syn_noise=0.0);
 
+	/**
+	 * Restores a snapshot written by save_state(). The simulation has to be set
+	 * up as the saved one (agents, controller, options, goals and landmarks);
+	 * run() then continues with the next trial of the saved run. Output files
+	 * of the restored run start at this trial.
+	 *
+	 * @param (string) filename: snapshot file
+	 * @return (bool) true, if the snapshot matches the setup and was read completely
+	 */
+	bool load_state(const string& filename);
+
 	/**
 	 * Reset simulation
 	 *
@@ -184,6 +276,72 @@ public:
 	 */
 	void run(int in_numtrials, double in_duration, double in_interval);
 
+	/**
+	 * Writes a snapshot of the simulation between two trials (all agents,
+	 * controllers, noise engines and the environment); the output streams
+	 * are flushed, so the files hold all data up to the snapshot
+	 *
+	 * @param (string) filename: snapshot file (written via filename.tmp)
+	 * @return (bool) true, if the snapshot was written completely
+	 */
+	bool save_state(const string& filename);
+
+	/**
+	 * Set master seed of all random number generators (one stream per agent and one for
+	 * random object placement). A random environment is already placed with the seed of
+	 * the constructor.
+	 *
+	 * @param (uint64_t) _seed: master seed
+	 * @return (void)
+	 */
+	void seed(uint64_t _seed);
+
+	/**
+	 * Set output format of the per-sample data streams
+	 *
+	 * @param (int) _mode: trace_text (.dat, default) or trace_binary (.trc)
+	 * @return (void)
+	 */
+	void trace_format(int _mode);
+
+	/**
+	 * Set asynchronous output of the data streams: a writer thread formats and
+	 * writes them, the simulation only queues the values (before run())
+	 *
+	 * @param (int) _policy: async_off (default), async_block (wait, if the writer falls behind) or async_drop (drop rows)
+	 * @return (void)
+	 */
+	void trace_async(int _policy);
+
+	/**
+	 * Set the sampling policy of a data stream (before run()): interval, event-triggered
+	 * samples, first/last steps of a trial and the trials written
+	 *
+	 * @param (string) stream: file name without extension (e.g., "agent", "homevector"), "" = all
+	 * 			per-sample streams, "activity" = activity matrices of the controllers (interval only)
+	 * @param (const SamplingPolicy&) policy: sampling policy
+	 * @return (void)
+	 */
+	void sampling(const string& stream, const SamplingPolicy& policy);
+
+	/**
+	 * Set number of threads the agents are updated on in each step
+	 * (results are the same for any number of threads)
+	 *
+	 * @param (int) _threads: number of threads, 0 = all cores
+	 * @return (void)
+	 */
+	void threads(int _threads);
+
+	/**
+	 * Returns the step profile of the last run (per trial; empty unless
+	 * compiled with -DNAVISIM_PROFILE). run() prints its summary and writes
+	 * it to data/profile.dat
+	 *
+	 * @return (const Profiler&)
+	 */
+	const Profiler& profile() const;
+
 	/**
 	 * Set inward time step
 	 *
@@ -199,6 +357,49 @@ public:
 	 */
 	void update();
 
+	/**
+	 * Opens the per-sample data streams and defines their columns
+	 *
+	 * @return (void)
+	 */
+	void open_traces();
+
+	/**
+	 * Returns all data streams (trace and per-trial data)
+	 *
+	 * @return (vector<TraceStream*>)
+	 */
+	vector<TraceStream*> data_streams();
+
+	/**
+	 * Returns the per-sample data streams (written by writeTrialData)
+	 *
+	 * @return (const vector<TraceStream*>&)
+	 */
+	const vector<TraceStream*>& trace_streams();
+
+	/**
+	 * Sets the sampling policies of the per-sample streams for this run
+	 *
+	 * @return (void)
+	 */
+	void apply_sampling();
+
+	/**
+	 * Decides for each per-sample stream, if the row of this step is written
+	 *
+	 * @param (int) step: step of the trial, -1 = after the end of the trial
+	 * @return (bool) true, if any stream needs the row
+	 */
+	bool sample(int step);
+
+	/**
+	 * Writes the rows after the end of a trial (events) and the held back last steps
+	 *
+	 * @return (void)
+	 */
+	void end_trial_samples();
+
 	/**
 	 * Writes global data into files (all trials)
 	 *
@@ -238,25 +439,28 @@ private:
 
 	//************ Output file streams ************//
 
-	ofstream agent_str;
-	ofstream endpts_str;
+	TraceStream agent_str;
+	TraceStream endpts_str;
 	ofstream error_dist;
-	ofstream homevector_str;
-	ofstream globalvector_str;
-	ofstream localvector_str;
-	ofstream refvector_str;
-	ofstream reward_str;
-	ofstream length_scaling;
+	TraceStream homevector_str;
+	TraceStream globalvector_str;
+	TraceStream localvector_str;
+	TraceStream refvector_str;
+	TraceStream reward_str;
+	TraceStream length_scaling;
 	ofstream sim_cfg;
-	ofstream out_signals;
-	ofstream lmr_signals;
-	ofstream lmr_angles;
-	ofstream lmr_attract;
-	ofstream adaptive_expl;
-	ofstream trialtimes;
-	ofstream performance_gvl;
-	ofstream LV_elig_traces;
-	ofstream LV_learning;
+	TraceStream out_signals;
+	TraceStream lmr_signals;
+	TraceStream lmr_angles;
+	TraceStream lmr_attract;
+	TraceStream adaptive_expl;
+	TraceStream trialtimes;
+	TraceStream performance_gvl;
+	TraceStream LV_elig_traces;
+	TraceStream LV_learning;
+	int trace_mode;			// trace_text or trace_binary
+	int trace_policy;		// async_off, async_block or async_drop
+	TraceWriter* writer;	// writer thread of the data streams (asynchronous output)
 
 	//************ Controller options *************//
 	bool pin_on;			// true, if agent does PI
@@ -267,6 +471,11 @@ private:
 	bool beta_on;           // true, if agent learns beta
 	int num_GV_units;       // number of GV units (goal types)
 	int num_LV_units;       // number of LV units (detected landmarks)
+	int neurons;            // number of neurons per layer
+	double sens_noise;      // sensory noise level
+	double neur_noise;      // uncorrelated noise level
+	double leak;            // leakage term
+	double weight_noise;    // synaptic noise level
 
 	//************ Timing parameters ************//
 
@@ -275,9 +484,33 @@ private:
 	double trial_t;         // continuous time for each trial
 	double dt;              // integration time
 	int timestep;           // discrete time steps
-	int sample_time;		// how often data is written into file
+	int sample_time;		// how often data is written into file (default interval)
+	map<string, SamplingPolicy> sampling_policies;	// sampling per stream ("" = all)
+	vector<TraceStream*> sample_streams;	// per-sample streams (see trace_streams())
+	int sample_events;		// events of agent 0 in the last step (event_goal, ...)
+	int prev_hits;			// goal hits of agent 0 in the trial before the last step
+	bool prev_lm_catch;		// agent 0 was in a landmark catchment before the last step
+	bool prev_in_pipe;		// agent 0 was in a pipe before the last step
 	double start_time;		// trial start time
 	double foodward_time;	// time needed for foraging
+	uint64_t master_seed;	// master seed of the agents' random number generators
+	string path;			// output directory
+
+	//************ Checkpoints ************//
+
+	/**
+	 * Writes or reads the state of the simulation (symmetric, see Checkpoint)
+	 *
+	 * @param (Checkpoint&) cp: snapshot file
+	 * @return (void)
+	 */
+	void checkpoint(Checkpoint& cp);
+
+	int checkpoint_every;	// trials between snapshots (0 = off)
+	string checkpoint_file;	// snapshot file
+	int checkpoint_trial;	// completed trials of the last written or loaded snapshot
+
+	Profiler profiler;		// time per phase of the step and trial
 
 public:
 	//************ Evaluation parameters ************//
@@ -0,0 +1,210 @@
+/*****************************************************************************
+ *  spatialgrid.h                                                            *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef SPATIALGRID_H_
+#define SPATIALGRID_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+
+/**
+ * Spatial Grid Class
+ *
+ * 	This class is a uniform-grid spatial hash over static point objects.
+ * 	Objects are inserted once by index; queries return the indices of all
+ * 	objects in the grid cells overlapping a disc, so the cost of a query
+ * 	depends on the local object density rather than on the world size.
+ * 	Exact distance tests are left to the caller.
+ *
+ */
+
+class SpatialGrid {
+public:
+
+	/**
+	 * Constructor
+	 *
+	 *  @param (double) _cell_size: edge length of a grid cell, ideally the largest query radius (default: 1.)
+	 */
+	SpatialGrid(double _cell_size = 1.){
+		cell_size = _cell_size;
+		inv_cell = 1./_cell_size;
+		num_objects = 0;
+		cmin_x = cmin_y = 0;
+		cmax_x = cmax_y = -1;
+	};
+
+	/**
+	 * Removes all objects from the grid
+	 *
+	 *  @return (void)
+	 */
+	void clear(){
+		cells.clear();
+		num_objects = 0;
+		cmin_x = cmin_y = 0;
+		cmax_x = cmax_y = -1;
+	};
+
+	/**
+	 * Inserts object with given index at position (x,y)
+	 *
+	 *  @param (int) index: index of the object in its container
+	 *  @param (double) x: x position of the object
+	 *  @param (double) y: y position of the object
+	 *  @return (void)
+	 */
+	void insert(int index, double x, double y){
+		long cx = cell(x);
+		long cy = cell(y);
+		cells[key(cx,cy)].push_back(index);
+		if(num_objects == 0){
+			cmin_x = cmax_x = cx;
+			cmin_y = cmax_y = cy;
+		}
+		else{
+			cmin_x = std::min(cmin_x, cx);
+			cmax_x = std::max(cmax_x, cx);
+			cmin_y = std::min(cmin_y, cy);
+			cmax_y = std::max(cmax_y, cy);
+		}
+		num_objects++;
+	};
+
+	/**
+	 * Collects the indices of all objects in cells overlapping the disc of radius r around (x,y)
+	 *
+	 *  @param (double) x: x position of the query
+	 *  @param (double) y: y position of the query
+	 *  @param (double) r: query radius
+	 *  @param (vector<int>&) out: candidate indices in ascending order (cleared first)
+	 *  @return (void)
+	 */
+	void query(double x, double y, double r, vector<int>& out) const {
+		out.clear();
+		if(num_objects == 0)
+			return;
+		long x0 = std::max(cell(x-r), cmin_x);
+		long x1 = std::min(cell(x+r), cmax_x);
+		long y0 = std::max(cell(y-r), cmin_y);
+		long y1 = std::min(cell(y+r), cmax_y);
+		for(long cx = x0; cx <= x1; cx++)
+			for(long cy = y0; cy <= y1; cy++)
+				append(cx, cy, out);
+		std::sort(out.begin(), out.end());
+	};
+
+	/**
+	 * Collects candidate indices in ring k (Chebyshev cell distance k) around the cell of (x,y)
+	 *
+	 *  @param (double) x: x position of the query
+	 *  @param (double) y: y position of the query
+	 *  @param (int) k: ring index (0 = cell of the query)
+	 *  @param (vector<int>&) out: candidate indices are appended (unsorted)
+	 *  @return (void)
+	 */
+	void ring(double x, double y, int k, vector<int>& out) const {
+		long qx = cell(x);
+		long qy = cell(y);
+		if(k == 0){
+			append(qx, qy, out);
+			return;
+		}
+		for(long cx = qx-k; cx <= qx+k; cx++){
+			append(cx, qy-k, out);
+			append(cx, qy+k, out);
+		}
+		for(long cy = qy-k+1; cy <= qy+k-1; cy++){
+			append(qx-k, cy, out);
+			append(qx+k, cy, out);
+		}
+	};
+
+	/**
+	 * Returns the largest ring index that can still contain objects, seen from (x,y)
+	 *
+	 *  @param (double) x: x position of the query
+	 *  @param (double) y: y position of the query
+	 *  @return (int)
+	 */
+	int max_ring(double x, double y) const {
+		if(num_objects == 0)
+			return -1;
+		long qx = cell(x);
+		long qy = cell(y);
+		long dx = std::max(std::abs(qx - cmin_x), std::abs(qx - cmax_x));
+		long dy = std::max(std::abs(qy - cmin_y), std::abs(qy - cmax_y));
+		return int(std::max(dx, dy));
+	};
+
+	/**
+	 * Returns the edge length of a grid cell
+	 *
+	 *  @return (double)
+	 */
+	double size() const {
+		return cell_size;
+	};
+
+	/**
+	 * Returns the number of objects in the grid
+	 *
+	 *  @return (int)
+	 */
+	int num() const {
+		return num_objects;
+	};
+
+private:
+	long cell(double v) const {
+		return long(std::floor(v*inv_cell));
+	};
+
+	static int64_t key(long cx, long cy){
+		return int64_t((uint64_t(cx) << 32) ^ (uint64_t(cy) & 0xffffffff));
+	};
+
+	void append(long cx, long cy, vector<int>& out) const {
+		unordered_map<int64_t, vector<int> >::const_iterator it = cells.find(key(cx,cy));
+		if(it != cells.end())
+			out.insert(out.end(), it->second.begin(), it->second.end());
+	};
+
+	double cell_size;                               // Edge length of a cell
+	double inv_cell;                                // Inverse edge length
+	int num_objects;                                // Number of inserted objects
+	long cmin_x, cmax_x, cmin_y, cmax_y;            // Bounding box of occupied cells
+	unordered_map<int64_t, vector<int> > cells;     // Object indices per occupied cell
+};
+
+
+#endif /* SPATIALGRID_H_ */
@@ -0,0 +1,801 @@
+/*****************************************************************************
+ *  trace.h                                                                  *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sampling.h"
+using namespace std;
+
+/*** Trace output modes ***/
+enum{trace_text, trace_binary};
+
+/*** Asynchronous trace output: off, wait for the writer or drop rows if its buffer is full ***/
+enum{async_off, async_block, async_drop};
+
+/*** Text formats of trace columns ***/
+enum{col_general, col_fixed, col_int};
+
+/**
+ * Trace Column
+ *
+ * 	Schema entry of a trace stream: name, text format and the
+ * 	separator written after the value in the text layout
+ *
+ */
+
+struct TraceColumn {
+	string name;
+	int format;								// col_general, col_fixed or col_int
+	int precision;							// digits (as ostream::precision)
+	string sep;								// separator after the value
+
+	/**
+	 * Appends the value in the column's text format (same output as ostream << value) and its separator
+	 *
+	 * @param (string&) buf: text buffer
+	 * @param (double) v: value
+	 * @return (void)
+	 */
+	void format_to(string& buf, double v) const {
+		char str[400];
+		if(format == col_int)
+			snprintf(str, sizeof(str), "%lld", (long long) v);
+		else if(format == col_fixed)
+			snprintf(str, sizeof(str), "%.*f", precision, v);
+		else
+			snprintf(str, sizeof(str), "%.*g", precision, v);
+		buf += str;
+		buf += sep;
+	}
+};
+
+
+/**
+ * Trace Stream Class
+ *
+ * 	This class writes one data stream (e.g., agent.dat) row by row with a
+ * 	fixed column schema. In text mode rows are formatted into a buffer and
+ * 	written in large blocks without flushing per line. In binary mode
+ * 	values are collected column-wise in blocks of rows and written as raw
+ * 	doubles (.trc); TraceReader converts them back to the text layout.
+ *
+ * 	Binary layout (native byte order):
+ * 		"NAVITRC1", uint32 ncols, uint32 len + comment,
+ * 		per column: uint32 len + name, int32 format, int32 precision, uint32 len + sep,
+ * 		blocks: uint32 nrows, then ncols x nrows doubles (column by column)
+ *
+ * 	With a TraceWriter attached (async()), the simulation thread only
+ * 	collects the values of a row; formatting and writing are done by the
+ * 	writer thread.
+ *
+ * 	A SamplingPolicy decides which steps are written (sample()). To keep
+ * 	the last K steps of a trial, rows pass a delay line of K rows and are
+ * 	written when they leave it (if kept) or at the end of the trial.
+ *
+ */
+
+class TraceWriter;
+
+class TraceStream {
+public:
+
+	/**
+	 * Constructor
+	 *
+	 */
+	TraceStream(){
+		mode = trace_text;
+		col = 0;
+		row = 0;
+		header_done = false;
+		writer = nullptr;
+		wanted_row = true;
+		keep_row = true;
+		held_next = 0;
+		held_count = 0;
+		warned = false;
+	};
+
+	/**
+	 * Destructor. Writes remaining rows and closes the file.
+	 *
+	 */
+	~TraceStream(){
+		close();
+	};
+
+	/**
+	 * Opens the stream; text mode writes <path>.dat, binary mode <path>.trc
+	 *
+	 *  @param (string) path: file path without extension
+	 *  @param (int) _mode: trace_text or trace_binary (default: trace_text)
+	 *  @return (void)
+	 */
+	void open(const string& path, int _mode = trace_text){
+		close();
+		mode = _mode;
+		columns.clear();
+		comment_text.clear();
+		col = 0;
+		row = 0;
+		header_done = false;
+		warned = false;
+		stream_name = path.substr(path.find_last_of('/') + 1);
+		file.open((path + (mode == trace_binary ? ".trc" : ".dat")).c_str(), ios::out | ios::binary);
+	};
+
+	/**
+	 * Adds a comment line written before the data (e.g., column titles)
+	 *
+	 *  @param (string) line: comment line without newline
+	 *  @return (void)
+	 */
+	void comment(const string& line){
+		comment_text += line + "\n";
+	};
+
+	/**
+	 * Adds a column to the schema (before the first value is written)
+	 *
+	 *  @param (string) name: column name
+	 *  @param (int) format: col_general, col_fixed or col_int (default: col_general)
+	 *  @param (int) precision: digits (default: 6)
+	 *  @param (string) sep: separator after the value in text layout (default: tab)
+	 *  @return (void)
+	 */
+	void column(const string& name, int format = col_general, int precision = 6, const string& sep = "\t"){
+		TraceColumn c = {name, format, precision, sep};
+		columns.push_back(c);
+	};
+
+	/**
+	 * Writes the next value of the current row
+	 *
+	 *  @param (double) v: value
+	 *  @return (TraceStream&)
+	 */
+	TraceStream& operator<<(double v){
+		if(writer || !held.empty())
+			pending.push_back(v);
+		else
+			put(v);
+		return *this;
+	};
+
+	/**
+	 * Completes the current row
+	 *
+	 *  @return (void)
+	 */
+	void end_row();
+
+	/**
+	 * Hands the rows to a writer thread from now on (call after open; nullptr: write directly)
+	 *
+	 *  @param (TraceWriter*) _writer: writer thread
+	 *  @return (void)
+	 */
+	void async(TraceWriter* _writer){
+		writer = _writer;
+		pending.clear();
+	};
+
+	/**
+	 * Sets the sampling policy (after open)
+	 *
+	 *  @param (const SamplingPolicy&) _policy: policy with resolved interval and chosen trials
+	 *  @return (void)
+	 */
+	void sampling(const SamplingPolicy& _policy){
+		end_trial();
+		policy = _policy;
+		held.assign(max(0, policy.last()), vector<double>());
+		held_keep.assign(held.size(), 0);
+		pending.clear();
+	};
+
+	/**
+	 * Decides on the row of a step: returns true, if the row is needed (then
+	 * values and end_row follow)
+	 *
+	 *  @param (int) trial: trial number
+	 *  @param (int) step: step of the trial, -1 = after the end of the trial
+	 *  @param (int) events: events in the step before (bit mask)
+	 *  @return (bool)
+	 */
+	bool sample(int trial, int step, int events){
+		wanted_row = policy.wants(trial, step, events);
+		keep_row = wanted_row && policy.keeps(trial, step, events);
+		return wanted_row;
+	};
+
+	/**
+	 * Returns true, if the row of the current step is needed (see sample(); true without a decision)
+	 *
+	 *  @return (bool)
+	 */
+	bool wanted() const {
+		return wanted_row;
+	};
+
+	/**
+	 * Writes the rows held back for the last steps of the trial
+	 *
+	 *  @return (void)
+	 */
+	void end_trial(){
+		unsigned int K = held.size();
+		for(unsigned int i = 0; i < held_count; i++)
+			emit(held[(held_next + K - held_count + i)%K]);
+		held_count = 0;
+		wanted_row = true;
+		keep_row = true;
+	};
+
+	/**
+	 * Returns the name of the stream (file name without extension)
+	 *
+	 *  @return (const string&)
+	 */
+	const string& name() const {
+		return stream_name;
+	};
+
+	/**
+	 * Formats the next value of the current row into the buffer (writer side)
+	 *
+	 *  @param (double) v: value
+	 *  @return (void)
+	 */
+	void put(double v){
+		if(!header_done)
+			write_header();
+		assert(col < columns.size());
+		if(col >= columns.size()){
+			/// value beyond the schema: counted (see put_end), not written
+			col++;
+			return;
+		}
+		if(mode == trace_binary)
+			block[col*block_rows + row] = v;
+		else
+			columns[col].format_to(text, v);
+		col++;
+	};
+
+	/**
+	 * Completes the current row in the buffer and writes full blocks (writer side)
+	 *
+	 *  @return (void)
+	 */
+	void put_end(){
+		if(col != columns.size()){
+			malformed(col);
+			/// short row: missing values are written as 0
+			while(col < columns.size())
+				put(0.);
+		}
+		col = 0;
+		if(mode == trace_binary){
+			row++;
+			if(row == block_rows)
+				write_block();
+		}
+		else{
+			text += '\n';
+			if(text.size() > text_block)
+				write_text();
+		}
+	};
+
+	/**
+	 * Writes buffered rows to the file (after the writer thread has caught up)
+	 *
+	 *  @return (void)
+	 */
+	void flush();
+
+	/**
+	 * Writes buffered rows to the file without waiting for the writer thread
+	 *
+	 *  @return (void)
+	 */
+	void flush_buffer(){
+		if(!file.is_open())
+			return;
+		if(!header_done)
+			write_header();
+		if(mode == trace_binary)
+			write_block();
+		else
+			write_text();
+		file.flush();
+	};
+
+	/**
+	 * Writes buffered rows and closes the file
+	 *
+	 *  @return (void)
+	 */
+	void close(){
+		if(!file.is_open())
+			return;
+		end_trial();
+		flush();
+		file.close();
+		writer = nullptr;
+	};
+
+	/**
+	 * Returns true, if the stream is open
+	 *
+	 *  @return (bool)
+	 */
+	bool is_open(){
+		return file.is_open();
+	};
+
+	/**
+	 * Returns the number of columns of the schema
+	 *
+	 *  @return (int)
+	 */
+	int num_columns(){
+		return columns.size();
+	};
+
+private:
+
+	/// writes a complete row (directly or by the writer thread)
+	void emit(const vector<double>& values);
+
+	/// row of n values does not match the schema: fails in debug builds, warns once otherwise
+	void malformed(unsigned int n){
+		assert(n == columns.size());
+		if(!warned)
+			printf("WARNING: Row of %u values in trace %s with %u columns (padded with 0 or truncated).\n",
+					n, stream_name.c_str(), (unsigned int) columns.size());
+		warned = true;
+	};
+
+	void write_header(){
+		header_done = true;
+		if(mode == trace_text){
+			text += comment_text;
+			return;
+		}
+		block.assign(columns.size()*block_rows, 0.);
+		file.write("NAVITRC1", 8);
+		write_u32(columns.size());
+		write_str(comment_text);
+		for(unsigned int c = 0; c < columns.size(); c++){
+			write_str(columns[c].name);
+			write_i32(columns[c].format);
+			write_i32(columns[c].precision);
+			write_str(columns[c].sep);
+		}
+	};
+
+	void write_block(){
+		if(row == 0)
+			return;
+		write_u32(row);
+		for(unsigned int c = 0; c < columns.size(); c++)
+			file.write((const char*) &block[c*block_rows], row*sizeof(double));
+		row = 0;
+	};
+
+	void write_text(){
+		file.write(text.data(), text.size());
+		text.clear();
+	};
+
+	void write_u32(uint32_t v){
+		file.write((const char*) &v, sizeof(v));
+	};
+
+	void write_i32(int32_t v){
+		file.write((const char*) &v, sizeof(v));
+	};
+
+	void write_str(const string& s){
+		write_u32(s.size());
+		file.write(s.data(), s.size());
+	};
+
+	static const unsigned int block_rows = 4096;		// Rows per binary block
+	static const unsigned int text_block = 1 << 16;		// Bytes per text write
+
+	ofstream file;
+	int mode;                                       // trace_text or trace_binary
+	vector<TraceColumn> columns;                    // Schema
+	string comment_text;                            // Comment lines before the data
+	bool header_done;                               // Schema written
+	unsigned int col;                               // Column of the next value
+	unsigned int row;                               // Rows in the current binary block
+	vector<double> block;                           // Binary block (column by column)
+	string text;                                    // Text buffer
+	TraceWriter* writer;                            // Writer thread (nullptr: synchronous)
+	vector<double> pending;                         // Values of the current row (asynchronous or delayed)
+	string stream_name;                             // File name without extension
+	SamplingPolicy policy;                          // Steps written
+	bool wanted_row;                                // Current row is needed
+	bool keep_row;                                  // Current row is written (not only held back)
+	vector<vector<double> > held;                   // Delay line of the last steps (ring)
+	vector<char> held_keep;                         // Held row is written when it leaves the delay line
+	unsigned int held_next;                         // Next slot of the delay line
+	unsigned int held_count;                        // Rows in the delay line
+	bool warned;                                    // Malformed row reported
+};
+
+
+/**
+ * Trace Writer Class
+ *
+ * 	This class is a background thread that formats and writes the rows of
+ * 	any number of trace streams. The simulation thread is the only
+ * 	producer: it copies each row into fixed-size records of a lock-free
+ * 	single-producer/single-consumer ring buffer, and the writer thread
+ * 	hands them to their streams, which write in large blocks. Rows of one
+ * 	stream keep their order.
+ *
+ * 	If the ring buffer is full (disk slower than the simulation), the
+ * 	producer either waits for the writer (async_block, no data lost) or
+ * 	drops the whole row and counts it (async_drop, the integration loop
+ * 	never waits for the disk).
+ *
+ */
+
+class TraceWriter {
+public:
+
+	/**
+	 * Constructor. Starts the writer thread.
+	 *
+	 *  @param (int) _policy: async_block or async_drop (default: async_block)
+	 *  @param (int) capacity: records in the ring buffer, rounded up to a power of two (default: 16384)
+	 */
+	TraceWriter(int _policy = async_block, int capacity = 1 << 14){
+		policy = _policy;
+		size = 1;
+		while(size < (uint64_t) capacity)
+			size <<= 1;
+		ring.resize(size);
+		head = 0;
+		tail = 0;
+		cached_tail = 0;
+		drops = 0;
+		quit = false;
+		worker = thread(&TraceWriter::work, this);
+	};
+
+	/**
+	 * Destructor. Writes the remaining records and joins the writer thread.
+	 *
+	 */
+	~TraceWriter(){
+		drain();
+		quit = true;
+		worker.join();
+	};
+
+	/**
+	 * Allocates an instance with the 64-byte alignment of its counters (before
+	 * C++17, plain new only guarantees the alignment of fundamental types)
+	 *
+	 *  @param (size_t) bytes: size of the instance
+	 *  @return (void*)
+	 */
+	static void* operator new(size_t bytes){
+		void* mem = nullptr;
+		if(posix_memalign(&mem, alignof(TraceWriter), bytes) != 0)
+			throw bad_alloc();
+		return mem;
+	};
+
+	/**
+	 * Frees an instance allocated by operator new
+	 *
+	 *  @param (void*) mem: instance
+	 *  @return (void)
+	 */
+	static void operator delete(void* mem){
+		free(mem);
+	};
+
+	/**
+	 * Queues a complete row of a stream (simulation thread)
+	 *
+	 *  @param (TraceStream*) stream: stream of the row
+	 *  @param (const vector<double>&) values: values of the row
+	 *  @return (bool) false, if the row was dropped
+	 */
+	bool push(TraceStream* stream, const vector<double>& values){
+		uint64_t records = max<uint64_t>(1, (values.size() + record_values - 1)/record_values);
+		if(policy == async_drop && !reserve(records)){
+			drops++;
+			return false;
+		}
+		uint64_t h = head.load(memory_order_relaxed);
+		for(uint64_t k = 0; k < records; k++, h++){
+			while(policy == async_block && !reserve(1))
+				this_thread::yield();
+			Record& r = ring[h & (size-1)];
+			uint64_t first = k*record_values;
+			r.stream = stream;
+			r.count = min<uint64_t>(record_values, values.size() - first);
+			r.last = (k+1 == records);
+			for(uint32_t i = 0; i < r.count; i++)
+				r.values[i] = values[first + i];
+			head.store(h + 1, memory_order_release);
+		}
+		return true;
+	};
+
+	/**
+	 * Waits until the writer thread has handed all queued rows to their streams
+	 *
+	 *  @return (void)
+	 */
+	void drain(){
+		uint64_t h = head.load(memory_order_relaxed);
+		while(tail.load(memory_order_acquire) != h)
+			this_thread::yield();
+	};
+
+	/**
+	 * Returns the number of rows dropped because the buffer was full (async_drop)
+	 *
+	 *  @return (long)
+	 */
+	long dropped() const {
+		return drops;
+	};
+
+private:
+
+	static const unsigned int record_values = 14;		// values per record (128 bytes)
+
+	struct Record {
+		TraceStream* stream;
+		uint32_t count;                             // values in this record
+		uint32_t last;                              // 1, if the record completes the row
+		double values[record_values];
+	};
+
+	/// true, if n more records fit behind head (producer side)
+	bool reserve(uint64_t n){
+		uint64_t h = head.load(memory_order_relaxed);
+		if(h + n - cached_tail <= size)
+			return true;
+		cached_tail = tail.load(memory_order_acquire);
+		return h + n - cached_tail <= size;
+	};
+
+	void work(){
+		int idle = 0;
+		while(true){
+			uint64_t t = tail.load(memory_order_relaxed);
+			uint64_t h = head.load(memory_order_acquire);
+			if(t == h){
+				if(quit)
+					return;
+				/// spin shortly, then sleep (the buffer holds many rows)
+				if(++idle < 64)
+					this_thread::yield();
+				else
+					this_thread::sleep_for(chrono::microseconds(200));
+				continue;
+			}
+			idle = 0;
+			for(; t != h; t++){
+				const Record& r = ring[t & (size-1)];
+				for(uint32_t i = 0; i < r.count; i++)
+					r.stream->put(r.values[i]);
+				if(r.last)
+					r.stream->put_end();
+				if(((t+1) & 255) == 0)
+					tail.store(t + 1, memory_order_release);
+			}
+			tail.store(t, memory_order_release);
+		}
+	};
+
+	int policy;                                     // async_block or async_drop
+	uint64_t size;                                  // records in the ring (power of two)
+	vector<Record> ring;                            // ring buffer
+	alignas(64) atomic<uint64_t> head;              // next record written (producer)
+	alignas(64) atomic<uint64_t> tail;              // next record read (consumer)
+	alignas(64) uint64_t cached_tail;               // tail last seen by the producer
+	long drops;                                     // rows dropped
+	atomic<bool> quit;                              // stop the writer thread
+	thread worker;                                  // writer thread
+};
+
+
+inline void TraceStream::end_row(){
+	if((writer || !held.empty()) && pending.size() != columns.size()){
+		malformed(pending.size());
+		pending.resize(columns.size(), 0.);
+	}
+	if(!held.empty()){
+		unsigned int slot = held_next;
+		if(held_count == held.size()){
+			if(held_keep[slot])
+				emit(held[slot]);
+		}
+		else
+			held_count++;
+		held[slot].swap(pending);
+		held_keep[slot] = keep_row;
+		held_next = (held_next + 1)%held.size();
+		pending.clear();
+	}
+	else if(writer){
+		writer->push(this, pending);
+		pending.clear();
+	}
+	else
+		put_end();
+	wanted_row = true;
+	keep_row = true;
+}
+
+inline void TraceStream::emit(const vector<double>& values){
+	if(writer){
+		writer->push(this, values);
+		return;
+	}
+	for(unsigned int i = 0; i < values.size(); i++)
+		put(values[i]);
+	put_end();
+}
+
+inline void TraceStream::flush(){
+	if(writer)
+		writer->drain();
+	flush_buffer();
+}
+
+
+/**
+ * Trace Reader Class
+ *
+ * 	This class reads binary trace files (.trc) written by TraceStream
+ * 	and exports them to the whitespace-delimited text layout (.dat)
+ *
+ */
+
+class TraceReader {
+public:
+
+	/**
+	 * Opens a binary trace file and reads its schema
+	 *
+	 *  @param (string) filename: trace file (.trc)
+	 *  @return (bool) true, if the file is a valid trace
+	 */
+	bool open(const string& filename){
+		file.open(filename.c_str(), ios::in | ios::binary);
+		char magic[8];
+		if(!file.read(magic, 8) || memcmp(magic, "NAVITRC1", 8) != 0)
+			return false;
+		uint32_t ncols = read_u32();
+		comment_text = read_str();
+		columns.resize(ncols);
+		for(unsigned int c = 0; c < ncols; c++){
+			columns[c].name = read_str();
+			columns[c].format = read_i32();
+			columns[c].precision = read_i32();
+			columns[c].sep = read_str();
+		}
+		return bool(file);
+	};
+
+	/**
+	 * Reads the next block of rows (values column by column)
+	 *
+	 *  @param (vector<double>&) values: ncols x nrows values
+	 *  @return (int) number of rows (0 at end of file)
+	 */
+	int read_block(vector<double>& values){
+		uint32_t nrows = 0;
+		if(!file.read((char*) &nrows, sizeof(nrows)))
+			return 0;
+		values.resize(columns.size()*nrows);
+		file.read((char*) values.data(), values.size()*sizeof(double));
+		return file ? nrows : 0;
+	};
+
+	/**
+	 * Writes the trace in its text layout
+	 *
+	 *  @param (string) filename: output text file (.dat)
+	 *  @return (bool)
+	 */
+	bool export_text(const string& filename){
+		ofstream out(filename.c_str(), ios::out | ios::binary);
+		if(!out.is_open())
+			return false;
+		string text = comment_text;
+		vector<double> values;
+		int nrows;
+		while((nrows = read_block(values)) > 0){
+			for(int r = 0; r < nrows; r++){
+				for(unsigned int c = 0; c < columns.size(); c++)
+					columns[c].format_to(text, values[c*nrows + r]);
+				text += '\n';
+			}
+			out.write(text.data(), text.size());
+			text.clear();
+		}
+		out.write(text.data(), text.size());
+		return bool(out);
+	};
+
+	vector<TraceColumn> columns;                    // Schema
+	string comment_text;                            // Comment lines before the data
+
+private:
+	uint32_t read_u32(){
+		uint32_t v = 0;
+		file.read((char*) &v, sizeof(v));
+		return v;
+	};
+
+	int32_t read_i32(){
+		int32_t v = 0;
+		file.read((char*) &v, sizeof(v));
+		return v;
+	};
+
+	string read_str(){
+		uint32_t len = read_u32();
+		string s(len, '\0');
+		if(len > 0)
+			file.read(&s[0], len);
+		return s;
+	};
+
+	ifstream file;
+};
+
+
+#endif /* TRACE_H_ */
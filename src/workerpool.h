@@ -0,0 +1,184 @@
+/*****************************************************************************
+ *  workerpool.h                                                             *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "profiler.h"
+using namespace std;
+
+
+/**
+ * Worker Pool Class
+ *
+ * 	This class keeps a fixed set of worker threads for data-parallel loops
+ * 	inside one simulation step (e.g., over agents). run() splits the index
+ * 	range into one contiguous chunk per thread, the calling thread works on
+ * 	the first chunk, and returns when all chunks are done. The partition
+ * 	only depends on the range and the number of threads, so every index is
+ * 	always processed by the same chunk function; loops whose iterations
+ * 	write disjoint state give the same result for any number of threads.
+ * 	Probes in a chunk count for the caller's profiler (slot of the worker).
+ *
+ */
+
+class WorkerPool {
+public:
+
+	/**
+	 * Constructor
+	 *
+	 *  @param (int) _threads: number of threads including the calling thread, 0 = all cores (default: 0)
+	 */
+	WorkerPool(int _threads = 0){
+		threads = (_threads > 0) ? _threads : int(thread::hardware_concurrency());
+		if(threads < 1)
+			threads = 1;
+		task = nullptr;
+		owner = nullptr;
+		range = 0;
+		generation = 0;
+		pending = 0;
+		quit = false;
+		for(int w = 1; w < threads; w++)
+			pool.push_back(thread(&WorkerPool::work, this, w));
+	};
+
+	/**
+	 * Destructor. Stops and joins the worker threads.
+	 *
+	 */
+	~WorkerPool(){
+		{
+			lock_guard<mutex> lock(state_lock);
+			quit = true;
+		}
+		start.notify_all();
+		for(unsigned int w = 0; w < pool.size(); w++)
+			pool[w].join();
+	};
+
+	/**
+	 * Returns the number of threads (including the calling thread)
+	 *
+	 *  @return (int)
+	 */
+	int num_threads(){
+		return threads;
+	};
+
+	/**
+	 * Runs fn(begin, end, worker) on contiguous chunks of [0,n) and waits for all chunks.
+	 * An exception thrown by a chunk is rethrown after all chunks have finished.
+	 *
+	 *  @param (int) n: size of the index range
+	 *  @param (function) fn: chunk function, processes indices begin..end-1 on thread worker
+	 *  @return (void)
+	 */
+	void run(int n, const function<void(int, int, int)>& fn){
+		if(threads == 1 || n < 2){
+			fn(0, n, 0);
+			return;
+		}
+		{
+			lock_guard<mutex> lock(state_lock);
+			task = &fn;
+			owner = Profiler::enabled ? Profiler::current() : nullptr;
+			range = n;
+			pending = threads - 1;
+			error = nullptr;
+			generation++;
+		}
+		start.notify_all();
+		run_chunk(0);
+		unique_lock<mutex> lock(state_lock);
+		done.wait(lock, [this]{ return pending == 0; });
+		task = nullptr;
+		if(error)
+			rethrow_exception(error);
+	};
+
+private:
+
+	void work(int w){
+		unsigned long seen = 0;
+		while(true){
+			{
+				unique_lock<mutex> lock(state_lock);
+				start.wait(lock, [&]{ return quit || generation != seen; });
+				if(quit)
+					return;
+				seen = generation;
+			}
+			{
+				Profiler::Scope scope(owner, w);
+				run_chunk(w);
+			}
+			lock_guard<mutex> lock(state_lock);
+			if(--pending == 0)
+				done.notify_one();
+		}
+	};
+
+	void run_chunk(int w){
+		int begin = int((long(range) * w) / threads);
+		int end = int((long(range) * (w + 1)) / threads);
+		if(begin >= end)
+			return;
+		try{
+			(*task)(begin, end, w);
+		}
+		catch(...){
+			lock_guard<mutex> lock(error_lock);
+			if(!error)
+				error = current_exception();
+		}
+	};
+
+	int threads;                                    // Number of threads (including the caller)
+	vector<thread> pool;                            // Worker threads 1..threads-1
+	mutex state_lock;
+	mutex error_lock;
+	condition_variable start;                       // New task published
+	condition_variable done;                        // All workers finished the task
+	const function<void(int, int, int)>* task;      // Current chunk function
+	Profiler* owner;                                // Profiler of the caller (probes of the chunks)
+	int range;                                      // Size of the current index range
+	int pending;                                    // Workers still running the current task
+	unsigned long generation;                       // Task counter
+	bool quit;
+	exception_ptr error;
+};
+
+
+#endif /* WORKERPOOL_H_ */
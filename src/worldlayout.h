@@ -0,0 +1,217 @@
+/*****************************************************************************
+ *  worldlayout.h                                                            *
+ *                                                                           *
+ *  Created on:   Oct 17, 2026                                               *
+ *  Author:       Dennis Goldschmidt                                         *
+ *  Email:        goldschmidtd@ini.phys.ethz.ch                              *
+ *                                                                           *
+ *                                                                           *
+ *  Copyright (C) 2014 by Dennis Goldschmidt                                 *
+ *                                                                           *
+ *  This file is part of the program NaviSim                                 *
+ *                                                                           *
+ *  NaviSim is free software: you can redistribute it and/or modify          *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation, either version 3 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  This program is distributed in the hope that it will be useful,          *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+ *                                                                           *
+ ****************************************************************************/
+
+#ifndef WORLDLAYOUT_H_
+#define WORLDLAYOUT_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include "checkpoint.h"
+#include "goal.h"
+#include "landmark.h"
+#include "poissondisk.h"
+#include "rng.h"
+#include "spatialgrid.h"
+using namespace std;
+
+
+/**
+ * World Layout Class
+ *
+ * 	This class is the static part of a world: goal positions, colors and
+ * 	initial reward amounts, landmark positions, and the spatial index of
+ * 	both. It is filled once and then shared read-only (shared_ptr<const
+ * 	WorldLayout>) by any number of environments, also by simulations
+ * 	running concurrently. Each environment keeps the per-run state on top
+ * 	of it (reward amounts, contacts, statistics) and queries the shared
+ * 	index. A layout can be written to and read from a file.
+ *
+ */
+
+class WorldLayout {
+public:
+
+	/**
+	 * Constructor. Empty layout with the index cell sizes of the Environment
+	 *
+	 *  @param (double) goal_cell: cell size of the goal index (default: goal radius)
+	 *  @param (double) lm_cell: cell size of the landmark index (default: landmark catchment radius)
+	 */
+	WorldLayout(double goal_cell = 0.2, double lm_cell = 0.6) : goal_grid(goal_cell), lm_grid(lm_cell) {};
+
+	/**
+	 * Adds a goal at position (x,y)
+	 *
+	 * 	@param (double) x: x position of goal
+	 * 	@param (double) y: y position of goal
+	 * 	@param (int) color: color index of goal (default: 0)
+	 * 	@param (double) size: reward amount available at goal (default: 1.)
+	 * 	@param (bool) decay: true, if amount of reward decays (default: false)
+	 * 	@return (int) goal index
+	 */
+	int add_goal(double x, double y, int color = 0, double size = 1., bool decay = false){
+		int j = goal_arrays.add(x, y, size, decay ? 0.0001 : 0.0, color);
+		goal_grid.insert(j, x, y);
+		return j;
+	};
+
+	/**
+	 * Adds a landmark at position (x,y)
+	 *
+	 * 	@param (double) x: x position of landmark
+	 * 	@param (double) y: y position of landmark
+	 * 	@return (int) landmark index
+	 */
+	int add_landmark(double x, double y){
+		int j = landmark_arrays.add(x, y);
+		lm_grid.insert(j, x, y);
+		return j;
+	};
+
+	/**
+	 * Returns a random layout: goals in 1 <= r <= max_radius, more than 3
+	 * apart; landmarks in 0.5 <= r <= max_radius, more than 0.5 from goals and
+	 * 1 from landmarks (Poisson disk sampling). The same seed gives the same
+	 * world.
+	 *
+	 * 	@param (int) num_goals: number of goals
+	 * 	@param (int) num_landmarks: number of landmarks
+	 * 	@param (double) max_radius: maximum distance from the origin
+	 * 	@param (uint64_t) seed: seed of the placement
+	 * 	@return (shared_ptr<const WorldLayout>) layout, fewer objects if they do not fit
+	 */
+	static shared_ptr<const WorldLayout> random(int num_goals, int num_landmarks, double max_radius, uint64_t seed){
+		shared_ptr<WorldLayout> world(new WorldLayout());
+		RNG rng(seed);
+		vector<double> x, y;
+		PoissonDisk goal_disk(3., 1., max_radius);
+		int n = goal_disk.sample(rng, num_goals, x, y);
+		if(n < num_goals)
+			printf("WARNING: Only %d of %d goals fit into radius %g.\n", n, num_goals, max_radius);
+		for(int i = 0; i < n; i++)
+			world->add_goal(x[i], y[i]);
+		PoissonDisk lm_disk(1., 0.5, max_radius);
+		for(int j = 0; j < world->goal_arrays.size(); j++)
+			lm_disk.avoid(world->goal_arrays.x[j], world->goal_arrays.y[j], 0.5);
+		n = lm_disk.sample(rng, num_landmarks, x, y);
+		if(n < num_landmarks)
+			printf("WARNING: Only %d of %d landmarks fit into radius %g.\n", n, num_landmarks, max_radius);
+		for(int i = 0; i < n; i++)
+			world->add_landmark(x[i], y[i]);
+		return world;
+	};
+
+	/**
+	 * Writes the layout to a file
+	 *
+	 * 	@param (string) filename: layout file
+	 * 	@return (bool) true, if written
+	 */
+	bool save(const string& filename) const {
+		Checkpoint cp(filename, true);
+		const_cast<WorldLayout*>(this)->io(cp);		// saving only reads the arrays
+		return cp.good();
+	};
+
+	/**
+	 * Reads a layout from a file
+	 *
+	 * 	@param (string) filename: layout file
+	 * 	@return (shared_ptr<const WorldLayout>) layout, nullptr on errors
+	 */
+	static shared_ptr<const WorldLayout> load(const string& filename){
+		shared_ptr<WorldLayout> world(new WorldLayout());
+		Checkpoint cp(filename, false);
+		world->io(cp);
+		if(!cp.good())
+			return nullptr;
+		for(int j = 0; j < world->goal_arrays.size(); j++)
+			world->goal_grid.insert(j, world->goal_arrays.x[j], world->goal_arrays.y[j]);
+		for(int j = 0; j < world->landmark_arrays.size(); j++)
+			world->lm_grid.insert(j, world->landmark_arrays.x[j], world->landmark_arrays.y[j]);
+		return world;
+	};
+
+	/**
+	 * Returns goal positions, colors and initial amounts
+	 *
+	 * 	@return (const GoalArrays&)
+	 */
+	const GoalArrays& goals() const {
+		return goal_arrays;
+	};
+
+	/**
+	 * Returns landmark positions
+	 *
+	 * 	@return (const LandmarkArrays&)
+	 */
+	const LandmarkArrays& landmarks() const {
+		return landmark_arrays;
+	};
+
+	/**
+	 * Returns the spatial index of the goals
+	 *
+	 * 	@return (const SpatialGrid&)
+	 */
+	const SpatialGrid& goal_index() const {
+		return goal_grid;
+	};
+
+	/**
+	 * Returns the spatial index of the landmarks
+	 *
+	 * 	@return (const SpatialGrid&)
+	 */
+	const SpatialGrid& lm_index() const {
+		return lm_grid;
+	};
+
+private:
+
+	void io(Checkpoint& cp){
+		cp.io(goal_arrays.x);
+		cp.io(goal_arrays.y);
+		cp.io(goal_arrays.amount);
+		cp.io(goal_arrays.amount_rate);
+		cp.io(goal_arrays.color);
+		cp.io(landmark_arrays.x);
+		cp.io(landmark_arrays.y);
+	};
+
+	GoalArrays goal_arrays;                         // goals (initial amounts)
+	LandmarkArrays landmark_arrays;                 // landmarks
+	SpatialGrid goal_grid;                          // index of the goals
+	SpatialGrid lm_grid;                            // index of the landmarks
+};
+
+
+#endif /* WORLDLAYOUT_H_ */
@@ -0,0 +1,90 @@
+/*
+ * bench_agents.cpp
+ *
+ * Microbenchmark of the batched PI networks (PINBatch) against per-agent
+ * PIN::update for A = 1, 8, 64, 512 and 2048 agents with N = 18 neurons.
+ * Every agent has its own identically seeded noise engine in both paths,
+ * so all layers (head direction, gater, memory and decoding) are checked
+ * for bitwise equal rates.
+ *
+ */
+
+#include "../src/pin.h"
+#include "../src/timer.h"
+#include "bench_common.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+const int N = 18;
+const int numsteps = 2000;
+const double sens_noise = 0.05;
+const double neur_noise = 0.01;
+const double leakage = 0.0001;
+vector<int> num_agents = {1, 8, 64, 512, 2048};
+
+bool same_bits(const vec& a, const vec& b){
+	return a.n_elem == b.n_elem && memcmp(a.memptr(), b.memptr(), a.n_elem*sizeof(double)) == 0;
+}
+
+int main(){
+	Timer timer(true);
+	printf("%6s\t%14s\t%14s\t%8s\t%8s\n", "#A", "single[ns]", "batched[ns]", "speedup", "bitwise");
+	for(int n = 0; n < num_agents.size(); n++){
+		int A = num_agents[n];
+		vector<PIN*> single(A), batched(A);
+		vector<RNG> rng_single, rng_batched;
+		for(int a = 0; a < A; a++){
+			rng_single.push_back(RNG(1234, a));
+			rng_batched.push_back(RNG(1234, a));
+		}
+		for(int a = 0; a < A; a++){
+			single[a] = new PIN(N, leakage, sens_noise, neur_noise, true);
+			batched[a] = new PIN(N, leakage, sens_noise, neur_noise, true);
+			single[a]->set_rng(&rng_single[a]);
+			batched[a]->set_rng(&rng_batched[a]);
+		}
+		PINBatch* batch = new PINBatch(batched);
+
+		/// identical inputs for both paths
+		RNG heading(99);
+		vector<double> angles(numsteps*A);
+		for(int i = 0; i < numsteps*A; i++)
+			angles[i] = heading.uniform(-M_PI, M_PI);
+
+		auto start = chrono::steady_clock::now();
+		for(int t = 0; t < numsteps; t++)
+			for(int a = 0; a < A; a++)
+				single[a]->update(Angle(angles[t*A + a]), 0.1);
+		double t_single = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/(numsteps*A);
+
+		start = chrono::steady_clock::now();
+		for(int t = 0; t < numsteps; t++){
+			for(int a = 0; a < A; a++)
+				batched[a]->sense(Angle(angles[t*A + a]), 0.1);
+			batch->update();
+			for(int a = 0; a < A; a++)
+				batched[a]->decode();
+		}
+		double t_batched = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/(numsteps*A);
+
+		bool equal = true;
+		for(int a = 0; a < A; a++){
+			for(int layer = HD; layer <= PI; layer++)
+				equal = equal && same_bits(single[a]->array(layer)->rate(), batched[a]->array(layer)->rate());
+			equal = equal && single[a]->HV().x == batched[a]->HV().x && single[a]->HV().y == batched[a]->HV().y;
+		}
+
+		printf("%6u\t%14.1f\t%14.1f\t%8.2f\t%8s\n", A, t_single, t_batched, t_single/t_batched, check(equal));
+		delete batch;
+		for(int a = 0; a < A; a++){
+			delete single[a];
+			delete batched[a];
+		}
+	}
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
@@ -0,0 +1,27 @@
+### check if file exists
+file="bench_agents"
+if [ -f "../$file" ]
+then
+	echo "Remove $file."
+	rm ../$file
+else
+	echo "$file not found."
+fi
+
+cd ..
+### compile c++ code
+if [ "$1" == "all" ] || [ "$1" == "compile" ] || [ "$1" == "run" ] ; then
+echo "Compile."
+g++ test/bench_agents.cpp src/pin.cpp -std=c++11 -o $file -O2 -larmadillo
+fi
+
+### run program
+if [ "$1" == "all" ] || [ "$1" == "run" ] ; then
+echo "Run program."
+./$file
+fi
+
+if [ "$1" = "" ] ; then
+echo "Nothing"
+fi
+echo "Done."
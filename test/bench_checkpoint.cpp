@@ -0,0 +1,67 @@
+/*
+ * bench_checkpoint.cpp
+ *
+ * Checkpoint/restore test of a population with route learning on a grid
+ * of landmarks. A straight run writes a snapshot every K trials; a second,
+ * freshly set up simulation loads the last snapshot and runs the remaining
+ * trials. The final snapshots of both runs are compared byte by byte, and
+ * the time and size of writing and loading a snapshot are reported.
+ *
+ */
+
+#include "bench_common.h"
+#include "../src/timer.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sys/stat.h>
+using namespace std;
+
+const int numagents = 8;
+const int numtrials = 10;
+const int every = 4;
+const double T = 100.;
+const double dt = 0.1;
+
+Simulation* setup(const string& dir){
+	make_dirs(dir);
+	Simulation* sim = new Simulation(numtrials, numagents, false, dir);
+	sim->SILENT = true;
+	int L = standard_world(sim);
+	learning_agents(sim, numagents, L, T, dt);
+	return sim;
+}
+
+int main(){
+	Timer timer(true);
+	mkdir("data/bench_checkpoint/", 0755);
+	string snapshot = "data/bench_checkpoint/snapshot.ckpt";
+
+	/// straight run, snapshots after every K trials
+	Simulation* sim = setup("data/bench_checkpoint/straight/");
+	sim->checkpoint(every, snapshot);
+	sim->run(numtrials, T, dt);
+	auto start = chrono::steady_clock::now();
+	sim->save_state("data/bench_checkpoint/straight.ckpt");
+	double t_save = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	delete sim;
+
+	/// fresh simulation continued from the last snapshot
+	sim = setup("data/bench_checkpoint/restored/");
+	start = chrono::steady_clock::now();
+	bool loaded = sim->load_state(snapshot);
+	double t_load = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	sim->run(numtrials, T, dt);
+	sim->save_state("data/bench_checkpoint/restored.ckpt");
+	delete sim;
+
+	string straight = read_file("data/bench_checkpoint/straight.ckpt");
+	string restored = read_file("data/bench_checkpoint/restored.ckpt");
+	bool equal = loaded && straight.size() > 0 && straight == restored;
+	printf("%10s\t%10s\t%10s\t%8s\n", "size[kB]", "save[ms]", "load[ms]", "bitwise");
+	printf("%10.1f\t%10.3f\t%10.3f\t%8s\n", straight.size()/1024., t_save, t_load, check(equal));
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
@@ -0,0 +1,77 @@
+/*
+ * bench_common.h
+ *
+ * Setup shared by the benchmarks: output directories of a simulation, the
+ * standard learning world (three goals and a sheared lattice of landmarks)
+ * and agents with homing, global and route learning. Checks report their
+ * verdict through check(); a bench whose check fails returns a non-zero
+ * exit code from main (bench_status()).
+ *
+ */
+
+#ifndef BENCH_COMMON_H_
+#define BENCH_COMMON_H_
+
+#include "../src/simulation.h"
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/stat.h>
+
+/// simulation directory with data/, data/mat/ and save/
+inline void make_dirs(const string& dir){
+	mkdir(dir.c_str(), 0755);
+	mkdir((dir + "data/").c_str(), 0755);
+	mkdir((dir + "data/mat/").c_str(), 0755);
+	mkdir((dir + "save/").c_str(), 0755);
+}
+
+/// whole file as a string (empty, if it does not exist)
+inline string read_file(const string& filename){
+	ifstream in(filename.c_str(), ios::in | ios::binary);
+	return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+/// the first num_goals of the goals (0,5), (-3,-4) and (1,1), and 81 landmarks on a sheared lattice; returns the number of landmarks
+inline int standard_world(Simulation* sim, int num_goals = 3){
+	const double goals[3][2] = {{0., 5.}, {-3., -4.}, {1., 1.}};
+	for(int j = 0; j < num_goals; j++)
+		sim->add_goal(goals[j][0], goals[j][1], 0);
+	int L = 0;
+	for(double x = -6.; x <= 6.; x += 1.5)
+		for(double y = -6.; y <= 6.; y += 1.5, L++)
+			sim->add_landmark(x + 0.3*y, y - 0.2*x);
+	return L;
+}
+
+/// homing, global and route learning (18 neurons, noisy), agents turn inward after half of a trial of T s
+inline void learning_agents(Simulation* sim, int agents, int landmarks, double T, double dt, uint64_t seed = 1234){
+	sim->homing(true);
+	sim->gvlearn(true);
+	sim->lvlearn(true);
+	sim->beta(true);
+	sim->seed(seed);
+	sim->init_controller(18, 1, landmarks, 0.05, 0.01, 0.0, 0.01);
+	for(int i = 0; i < agents; i++)
+		sim->c(i)->set_inward(int(0.5*T/dt));
+}
+
+/// true, after a failed check
+inline bool& bench_failed(){
+	static bool failed = false;
+	return failed;
+}
+
+/// verdict of a check (default: "yes" or "NO"); a failed check sets the exit status
+inline const char* check(bool ok, const char* pass = "yes", const char* fail = "NO"){
+	if(!ok)
+		bench_failed() = true;
+	return ok ? pass : fail;
+}
+
+/// exit status of the bench: 1, if any check failed
+inline int bench_status(){
+	return bench_failed() ? 1 : 0;
+}
+
+#endif /* BENCH_COMMON_H_ */
@@ -0,0 +1,85 @@
+/*
+ * bench_decode.cpp
+ *
+ * Microbenchmark of the single-sweep population decoder (CircArray::decode)
+ * against the previous sequence of vector_avg, pva_angle, pva_len,
+ * update_piavg, update_pilen and update_max calls, each taking a copy of
+ * the profile, for N = 18, 36 and 360 neurons. Decoded angles, lengths
+ * and maxima are checked for bitwise equality.
+ *
+ */
+
+#include "../src/circulararray.h"
+#include "../src/timer.h"
+#include "bench_common.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+const int numprofiles = 1000;
+const int numrepeats = 20;
+vector<int> neurons = {18, 36, 360};
+
+/// previous PIN::update decoding (by-value calls)
+void legacy_decode(CircArray& ar, vec out, PopulationCode& code){
+	code.avg = ar.vector_avg(out);
+	code.pva = ar.pva_angle(out);
+	code.len = ar.pva_len(out);
+	ar.update_piavg(out);
+	ar.update_pilen(out);
+	ar.set_max(ar.update_max(out), 0);
+	code.bump = ar.avg();
+	code.max = ar.max();
+	code.max_rate = ar.maxr();
+}
+
+bool same(Angle a, Angle b){
+	double x = a.rad(), y = b.rad();
+	return memcmp(&x, &y, sizeof(double)) == 0;
+}
+
+int main(){
+	Timer timer(true);
+	printf("%6s\t%14s\t%14s\t%8s\t%8s\n", "#N", "legacy[ns]", "fused[ns]", "speedup", "bitwise");
+	for(int n = 0; n < neurons.size(); n++){
+		int N = neurons[n];
+		CircArray ar(N);
+		RNG rng(1234);
+
+		/// bump profiles (shifted cosines, rectified) with noise
+		vector<vec> profiles(numprofiles);
+		for(int p = 0; p < numprofiles; p++){
+			double center = rng.uniform(0., 2.*M_PI);
+			profiles[p].zeros(N);
+			for(int i = 0; i < N; i++)
+				profiles[p](i) = max(0.0, cos(2.*M_PI*i/N - center) + rng.normal(0.0, 0.05));
+		}
+
+		vector<PopulationCode> legacy(numprofiles), fused(numprofiles);
+		auto start = chrono::steady_clock::now();
+		for(int r = 0; r < numrepeats; r++)
+			for(int p = 0; p < numprofiles; p++)
+				legacy_decode(ar, profiles[p], legacy[p]);
+		double t_legacy = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/(numrepeats*numprofiles);
+
+		start = chrono::steady_clock::now();
+		for(int r = 0; r < numrepeats; r++)
+			for(int p = 0; p < numprofiles; p++)
+				ar.decode(profiles[p].memptr(), fused[p]);
+		double t_fused = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/(numrepeats*numprofiles);
+
+		bool equal = true;
+		for(int p = 0; p < numprofiles; p++){
+			equal = equal && same(legacy[p].avg, fused[p].avg) && same(legacy[p].pva, fused[p].pva);
+			equal = equal && same(legacy[p].bump, fused[p].bump) && same(legacy[p].max, fused[p].max);
+			equal = equal && memcmp(&legacy[p].len, &fused[p].len, sizeof(double)) == 0;
+			equal = equal && memcmp(&legacy[p].max_rate, &fused[p].max_rate, sizeof(double)) == 0;
+		}
+		printf("%6u\t%14.1f\t%14.1f\t%8.2f\t%8s\n", N, t_legacy, t_fused, t_legacy/t_fused, check(equal));
+	}
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
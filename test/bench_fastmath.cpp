@@ -0,0 +1,144 @@
+/*
+ * bench_fastmath.cpp
+ *
+ * Microbenchmark of the fast trigonometric policy (FastMath) against the
+ * standard library (PreciseMath): time per call and maximum absolute
+ * error of sin, cos, atan2 and the head-direction tuning curve.
+ *
+ * The homing error is measured with the policy the simulation is compiled
+ * with (Trig, see fastmath.h): noise-free PI networks integrate random
+ * outbound walks and the home vector direction is compared with the true
+ * direction home. bench_fastmath.sh builds and runs both variants.
+ *
+ */
+
+#include "../src/pin.h"
+#include "../src/fastmath.h"
+#include "../src/timer.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+const int numcalls = 1000000;
+const int numwalks = 200;
+const int numsteps = 3000;
+const double dt = 0.1;
+vector<int> neurons = {18, 360};
+
+volatile double sink;
+
+template<class M>
+double time_sin(const vector<double>& x){
+	double sum = 0.;
+	auto start = chrono::steady_clock::now();
+	for(unsigned int k = 0; k < x.size(); k++)
+		sum += M::sin(x[k]);
+	double t = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/x.size();
+	sink = sum;
+	return t;
+}
+
+template<class M>
+double time_cos(const vector<double>& x){
+	double sum = 0.;
+	auto start = chrono::steady_clock::now();
+	for(unsigned int k = 0; k < x.size(); k++)
+		sum += M::cos(x[k]);
+	double t = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/x.size();
+	sink = sum;
+	return t;
+}
+
+template<class M>
+double time_atan2(const vector<double>& y, const vector<double>& x){
+	double sum = 0.;
+	auto start = chrono::steady_clock::now();
+	for(unsigned int k = 0; k < x.size(); k++)
+		sum += M::atan2(y[k], x[k]);
+	double t = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/x.size();
+	sink = sum;
+	return t;
+}
+
+template<class M>
+double time_tuning(PIN& pin, const vector<double>& x, vector<double>& out){
+	double sum = 0.;
+	int calls = x.size()/100;
+	auto start = chrono::steady_clock::now();
+	for(int k = 0; k < calls; k++){
+		pin.cos_tuning<M>(x[k], out.data());
+		sum += out[0];
+	}
+	double t = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/calls;
+	sink = sum;
+	return t;
+}
+
+int main(){
+	Timer timer(true);
+	RNG rng(1234);
+	vector<double> x(numcalls), y(numcalls);
+	for(int k = 0; k < numcalls; k++){
+		x[k] = rng.uniform(-4.*M_PI, 4.*M_PI);
+		y[k] = rng.uniform(-1., 1.);
+	}
+
+	/// accuracy and speed of both policies
+	double err_sin = 0., err_cos = 0., err_atan2 = 0.;
+	for(int k = 0; k < numcalls; k++){
+		err_sin = max(err_sin, fabs(FastMath::sin(x[k]) - PreciseMath::sin(x[k])));
+		err_cos = max(err_cos, fabs(FastMath::cos(x[k]) - PreciseMath::cos(x[k])));
+		err_atan2 = max(err_atan2, fabs(FastMath::atan2(y[k], x[k]) - PreciseMath::atan2(y[k], x[k])));
+	}
+	printf("%12s\t%14s\t%14s\t%8s\t%12s\n", "#function", "precise[ns]", "fast[ns]", "speedup", "max|err|");
+	double tp = time_sin<PreciseMath>(x), tf = time_sin<FastMath>(x);
+	printf("%12s\t%14.2f\t%14.2f\t%8.2f\t%12.3e\n", "sin", tp, tf, tp/tf, err_sin);
+	tp = time_cos<PreciseMath>(x), tf = time_cos<FastMath>(x);
+	printf("%12s\t%14.2f\t%14.2f\t%8.2f\t%12.3e\n", "cos", tp, tf, tp/tf, err_cos);
+	tp = time_atan2<PreciseMath>(y, x), tf = time_atan2<FastMath>(y, x);
+	printf("%12s\t%14.2f\t%14.2f\t%8.2f\t%12.3e\n", "atan2", tp, tf, tp/tf, err_atan2);
+	for(int n = 0; n < neurons.size(); n++){
+		PIN pin(neurons[n], 0.0, 0.0, 0.0, true);
+		vector<double> precise(neurons[n]), fast(neurons[n]);
+		double err = 0.;
+		for(int k = 0; k < numcalls/100; k++){
+			pin.cos_tuning<PreciseMath>(x[k], precise.data());
+			pin.cos_tuning<FastMath>(x[k], fast.data());
+			for(int i = 0; i < neurons[n]; i++)
+				err = max(err, fabs(precise[i] - fast[i]));
+		}
+		tp = time_tuning<PreciseMath>(pin, x, precise), tf = time_tuning<FastMath>(pin, x, fast);
+		char name[32];
+		snprintf(name, sizeof(name), "tuning(N=%d)", neurons[n]);
+		printf("%12s\t%14.2f\t%14.2f\t%8.2f\t%12.3e\n", name, tp, tf, tp/tf, err);
+	}
+
+	/// homing error of noise-free PI with the compiled policy
+	RNG walk(99);
+	double sum_err = 0., max_err = 0.;
+	auto start = chrono::steady_clock::now();
+	for(int w = 0; w < numwalks; w++){
+		PIN pin(18, 0.0, 0.0, 0.0, true);
+		double heading = walk.uniform(-M_PI, M_PI);
+		double px = 0., py = 0., speed = 0.1;
+		for(int t = 0; t < numsteps; t++){
+			heading += dt * walk.normal(0.0, 1.0);
+			px += dt * speed * PreciseMath::cos(heading);
+			py += dt * speed * PreciseMath::sin(heading);
+			pin.update(Angle(heading), speed);
+		}
+		double home = PreciseMath::atan2(-py, -px);
+		/// the agent homes along the inverted home vector (Controller: HV().ang().i())
+		double err = fabs(Angle(pin.HV().ang().i().rad() - home).rad());
+		err = min(err, 2.*M_PI - err);
+		sum_err += err;
+		max_err = max(max_err, err);
+	}
+	double t_walks = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/(numwalks*numsteps);
+	printf("\nHoming (%s policy): mean error = %.9f deg, max error = %.9f deg, %.1f ns per PI update\n",
+			Trig::fast ? "fast" : "precise", sum_err/numwalks*180./M_PI, max_err*180./M_PI, t_walks);
+
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+}
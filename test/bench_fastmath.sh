@@ -0,0 +1,32 @@
+### check if file exists
+file="bench_fastmath"
+for f in $file ${file}_fast
+do
+if [ -f "../$f" ]
+then
+	echo "Remove $f."
+	rm ../$f
+else
+	echo "$f not found."
+fi
+done
+
+cd ..
+### compile c++ code (precise and fast policy)
+if [ "$1" == "all" ] || [ "$1" == "compile" ] || [ "$1" == "run" ] ; then
+echo "Compile."
+g++ test/bench_fastmath.cpp src/pin.cpp -std=c++11 -o $file -O2 -larmadillo
+g++ test/bench_fastmath.cpp src/pin.cpp -std=c++11 -o ${file}_fast -O2 -DNAVISIM_FAST_MATH -larmadillo
+fi
+
+### run program
+if [ "$1" == "all" ] || [ "$1" == "run" ] ; then
+echo "Run program."
+./$file
+./${file}_fast | tail -n 2
+fi
+
+if [ "$1" = "" ] ; then
+echo "Nothing"
+fi
+echo "Done."
@@ -0,0 +1,79 @@
+/*
+ * bench_fork.cpp
+ *
+ * Fork test of a population with route learning on a grid of landmarks.
+ * A trained prefix is copied into several branches with different leakage
+ * terms, which then continue in parallel. A branch with the parameters of
+ * the parent is compared byte by byte with the parent continuing itself;
+ * the time of a fork and of the branch runs are reported.
+ *
+ */
+
+#include "bench_common.h"
+#include "../src/timer.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+using namespace std;
+
+const int numagents = 8;
+const int prefix = 6;
+const int numtrials = 10;
+const int numbranches = 4;
+const double T = 100.;
+const double dt = 0.1;
+
+int main(){
+	Timer timer(true);
+	mkdir("data/bench_fork/", 0755);
+
+	/// trained prefix
+	make_dirs("data/bench_fork/parent/");
+	Simulation* sim = new Simulation(prefix, numagents, false, "data/bench_fork/parent/");
+	sim->SILENT = true;
+	int L = standard_world(sim);
+	learning_agents(sim, numagents, L, T, dt);
+	sim->run(prefix, T, dt);
+
+	/// branches: same parameters (0) and larger leakage terms
+	vector<Simulation*> branches(numbranches);
+	auto start = chrono::steady_clock::now();
+	for(int b = 0; b < numbranches; b++){
+		string dir = "data/bench_fork/branch" + to_string(b) + "/";
+		make_dirs(dir);
+		branches[b] = (b == 0) ? sim->fork(dir) : sim->fork(dir, 0.05, 0.01, 0.001*b, 0.01);
+	}
+	double t_fork = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count()/numbranches;
+
+	/// parent and branches continue in parallel
+	start = chrono::steady_clock::now();
+	vector<thread> runs;
+	runs.push_back(thread([sim]{ sim->run(numtrials, T, dt); }));
+	for(int b = 0; b < numbranches; b++){
+		Simulation* branch = branches[b];
+		runs.push_back(thread([branch]{ branch->run(numtrials, T, dt); }));
+	}
+	for(unsigned int i = 0; i < runs.size(); i++)
+		runs[i].join();
+	double t_run = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+	sim->save_state("data/bench_fork/parent.ckpt");
+	branches[0]->save_state("data/bench_fork/branch0.ckpt");
+	string parent = read_file("data/bench_fork/parent.ckpt");
+	string branch = read_file("data/bench_fork/branch0.ckpt");
+	bool equal = parent.size() > 0 && parent == branch;
+
+	printf("%10s\t%10s\t%10s\t%8s\n", "branches", "fork[ms]", "run[ms]", "bitwise");
+	printf("%10d\t%10.3f\t%10.1f\t%8s\n", numbranches, t_fork, t_run, check(equal));
+	printf("%10s\t%10s\t%10s\n", "leakage", "x", "y");
+	for(int b = 0; b < numbranches; b++)
+		printf("%10.3f\t%10.4f\t%10.4f\n", 0.001*b, branches[b]->a(0)->x(), branches[b]->a(0)->y());
+	for(int b = 0; b < numbranches; b++)
+		delete branches[b];
+	delete sim;
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
@@ -0,0 +1,71 @@
+/*
+ * bench_geom.cpp
+ *
+ * Microbenchmark of the Angle and Vec value types for the expressions
+ * used in the control loop (Agent::update, Controller::update). Reports
+ * ns per operation and heap allocations per operation, counted by
+ * replacing the global operator new. The previous Angle held three
+ * std::vector members and needed three allocations per temporary.
+ *
+ */
+
+#include "../src/geom.h"
+#include "../src/timer.h"
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <vector>
+using namespace std;
+
+static_assert(is_trivially_copyable<Angle>::value, "Angle must be trivially copyable");
+static_assert(is_trivially_copyable<Vec>::value, "Vec must be trivially copyable");
+
+static unsigned long num_allocs = 0;
+
+void* operator new(size_t size){
+	num_allocs++;
+	if(void* p = malloc(size))
+		return p;
+	throw bad_alloc();
+}
+void operator delete(void* p) noexcept{
+	free(p);
+}
+
+const int numops = 5000000;
+volatile double sink;
+
+template<typename F>
+void bench(const char* name, F op){
+	double acc = 0.;
+	unsigned long allocs = num_allocs;
+	auto start = chrono::steady_clock::now();
+	for(int t = 0; t < numops; t++)
+		acc += op(t);
+	double t_op = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/numops;
+	allocs = num_allocs - allocs;
+	sink = acc;
+	printf("%-28s\t%10.2f\t%10.3f\n", name, t_op, double(allocs)/numops);
+}
+
+int main(){
+	Timer timer(true);
+	vector<double> x(1024), y(1024);
+	for(int i = 0; i < 1024; i++){
+		x[i] = -M_PI + 2.*M_PI*((i*619)%1024)/1024.;
+		y[i] = -10. + 20.*((i*337)%1024)/1024.;
+	}
+	Vec hv(3., -4.);
+	Angle heading(0.3);
+
+	printf("%-28s\t%10s\t%10s\n", "#operation", "ns/op", "allocs/op");
+	bench("Angle(double)", [&](int t){ return Angle(x[t&1023]).rad(); });
+	bench("Angle + Angle", [&](int t){ return (Angle(x[t&1023]) + heading).rad(); });
+	bench("(HV.ang().i() - angle).S()", [&](int t){ hv.x = y[t&1023]; return (hv.ang().i() - heading).S(); });
+	bench("Vec::azimuth", [&](int t){ return Vec(y[t&1023], x[t&1023]).azimuth().rad(); });
+	bench("Vec + Vec * f", [&](int t){ return (hv + Vec(heading.C(), heading.S())*x[t&1023]).len(); });
+
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+}
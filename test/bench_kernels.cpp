@@ -0,0 +1,281 @@
+/*
+ * bench_kernels.cpp
+ *
+ * Benchmark suite of the core kernels: Angle/Vec arithmetic,
+ * GoalLearning::update, RouteLearning::update (K landmarks),
+ * Environment::update (agents, goals, landmarks) and
+ * Simulation::writeTrialData (PIN::update is measured by bench_pin).
+ * Every benchmark is repeated with doubling iteration counts until it
+ * has run for min_time; reported are ns per
+ * step, heap allocations per step and throughput (items per second, e.g.
+ * agent updates). Results are written as JSON (--out) and compared with a
+ * stored baseline (--baseline): a benchmark more than --tolerance slower
+ * or with more allocations per step is a regression (exit code 1).
+ *
+ *  usage: bench_kernels [--filter <substring>] [--out <file.json>]
+ *                       [--baseline <file.json>] [--tolerance <fraction>]
+ *
+ */
+
+#include "bench_common.h"
+#include "../src/timer.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <vector>
+#include <sys/stat.h>
+using namespace std;
+
+const double min_time = 0.2;		// minimum run time of a benchmark [s]
+const double T = 100.;
+const double dt = 0.1;
+
+/// heap allocation counter (operator new and aligned allocations of Armadillo)
+static long num_allocs = 0;
+void* operator new(size_t size){
+	num_allocs++;
+	void* p = malloc(size);
+	if(!p)
+		throw bad_alloc();
+	return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+extern "C" void* __libc_memalign(size_t alignment, size_t size);
+extern "C" int posix_memalign(void** p, size_t alignment, size_t size){
+	num_allocs++;
+	*p = __libc_memalign(alignment, size);
+	return *p ? 0 : ENOMEM;
+}
+
+/// results are consumed here, so the compiler keeps the benchmarked code
+volatile double sink = 0.;
+
+struct Result {
+	string name;
+	long iterations;
+	double ns;				// time per step [ns]
+	double allocs;			// heap allocations per step
+	double items_per_s;		// throughput
+};
+
+/// setup of a benchmark: returns the step function (called once untimed as warm-up)
+struct Benchmark {
+	string name;
+	double items;			// items per step (e.g., agents)
+	function<function<void()>()> setup;
+};
+
+Result measure(const Benchmark& b){
+	function<void()> step = b.setup();
+	step();
+	Result r;
+	r.name = b.name;
+	long n = 1;
+	while(true){
+		long allocs = num_allocs;
+		auto start = chrono::steady_clock::now();
+		for(long i = 0; i < n; i++)
+			step();
+		double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		if(secs >= min_time || n >= (1L << 30)){
+			r.iterations = n;
+			r.ns = 1e9*secs/n;
+			r.allocs = double(num_allocs - allocs)/n;
+			r.items_per_s = b.items*1e9/r.ns;
+			return r;
+		}
+		n = (secs < 0.01*min_time) ? 10*n : 2*n;
+	}
+}
+
+/// population with route learning, after one trial (traces open, networks warm)
+Simulation* population(int agents, int goals, int landmarks, const string& dir){
+	make_dirs(dir);
+	Simulation* sim = new Simulation(1, agents, false, dir);
+	sim->SILENT = true;
+	for(int j = 0; j < goals; j++)
+		sim->add_goal(5.*cos(2.*M_PI*j/goals), 5.*sin(2.*M_PI*j/goals), 0);
+	int side = int(sqrt(double(landmarks)) + 0.5);
+	for(int k = 0; k < landmarks; k++)
+		sim->add_landmark(-6. + 12.*(k%side)/side, -6. + 12.*(k/side)/side);
+	learning_agents(sim, agents, landmarks, T, dt);
+	sim->run(1, T, dt);
+	sim->SILENT = false;
+	return sim;
+}
+
+vector<Benchmark> benchmarks(){
+	vector<Benchmark> list;
+	mkdir("data/bench_kernels/", 0755);
+
+	/*** Angle/Vec arithmetic ***/
+	list.push_back({"angle/add_sub_S", 1., []{
+		return function<void()>([]{
+			static Angle a(0.3), b(-2.9);
+			a = (a + b).S() - Angle(0.1);
+			sink = a.rad();
+		});
+	}});
+	list.push_back({"vec/add_len_ang", 1., []{
+		return function<void()>([]{
+			static Vec u(0.3, -0.2), w(0.01, 0.02);
+			u = u + w;
+			sink = u.len() + u.ang().rad();
+		});
+	}});
+
+	/*** GoalLearning::update (reward in every 10th step) ***/
+	for(int N : {18, 36, 360}){
+		list.push_back({"goallearning/update/N=" + to_string(N), 1., [N]{
+			shared_ptr<double> forage(new double(0.));
+			shared_ptr<GoalLearning> gl(new GoalLearning(N, 0.01, forage.get(), false, true));
+			shared_ptr<vec> pi_input(new vec(ones<vec>(N)));
+			shared_ptr<int> t(new int(0));
+			return function<void()>([forage, gl, pi_input, t]{
+				(*t)++;
+				gl->update(*pi_input, (*t)%10 == 0 ? 1.0 : 0.0, 0.5);
+				sink = gl->w_ref()(0, 0);
+			});
+		}});
+	}
+
+	/*** RouteLearning::update (one landmark in view at a time) ***/
+	for(int K : {1, 10, 81}){
+		list.push_back({"routelearning/update/N=18/K=" + to_string(K), 1., [K]{
+			shared_ptr<double> forage(new double(0.));
+			shared_ptr<RouteLearning> rl(new RouteLearning(18, K, 0.0, forage.get(), false, true));
+			shared_ptr<vec> lmr(new vec(zeros<vec>(K)));
+			shared_ptr<int> t(new int(0));
+			return function<void()>([forage, rl, lmr, t, K]{
+				(*t)++;
+				lmr->zeros();
+				(*lmr)(((*t)/50)%K) = 1.;
+				rl->update(Angle(0.01*(*t)), 0.1, (*t)%100 == 0 ? 1.0 : 0.0, *lmr);
+				sink = rl->w_ref()(0, 0);
+			});
+		}});
+	}
+
+	/*** Environment::update ***/
+	for(int agents : {1, 16, 64})
+	for(int landmarks : {9, 81}){
+		string name = "environment/update/agents=" + to_string(agents) + "/goals=3/landmarks=" + to_string(landmarks);
+		string dir = "data/bench_kernels/env_" + to_string(agents) + "_" + to_string(landmarks) + "/";
+		list.push_back({name, double(agents), [agents, landmarks, dir]{
+			shared_ptr<Simulation> sim(population(agents, 3, landmarks, dir));
+			return function<void()>([sim]{
+				sim->e()->update();
+				sink = sim->a(0)->x();
+			});
+		}});
+	}
+
+	/*** Simulation::writeTrialData ***/
+	for(int landmarks : {9, 81}){
+		string dir = "data/bench_kernels/trialdata_" + to_string(landmarks) + "/";
+		list.push_back({"simulation/writeTrialData/landmarks=" + to_string(landmarks), 1., [landmarks, dir]{
+			shared_ptr<Simulation> sim(population(1, 3, landmarks, dir));
+			return function<void()>([sim]{
+				sim->writeTrialData();
+			});
+		}});
+	}
+	return list;
+}
+
+/// JSON output, one benchmark per line
+void write_json(const vector<Result>& results, const string& filename){
+	ofstream out(filename.c_str());
+	out << "{\n  \"benchmarks\": [\n";
+	for(unsigned int i = 0; i < results.size(); i++){
+		char line[512];
+		snprintf(line, sizeof(line), "    {\"name\": \"%s\", \"iterations\": %ld, \"ns_per_step\": %.3f, \"allocs_per_step\": %.3f, \"items_per_second\": %.1f}%s\n",
+				results[i].name.c_str(), results[i].iterations, results[i].ns, results[i].allocs, results[i].items_per_s, i+1 < results.size() ? "," : "");
+		out << line;
+	}
+	out << "  ]\n}\n";
+}
+
+double json_number(const string& line, const string& key){
+	size_t pos = line.find("\"" + key + "\":");
+	return (pos == string::npos) ? -1. : atof(line.c_str() + pos + key.size() + 3);
+}
+
+/// baseline written by write_json: name -> (ns per step, allocations per step)
+map<string, pair<double, double> > read_json(const string& filename){
+	map<string, pair<double, double> > baseline;
+	ifstream in(filename.c_str());
+	string line;
+	while(getline(in, line)){
+		size_t pos = line.find("\"name\": \"");
+		if(pos == string::npos)
+			continue;
+		pos += 9;
+		string name = line.substr(pos, line.find('"', pos) - pos);
+		baseline[name] = make_pair(json_number(line, "ns_per_step"), json_number(line, "allocs_per_step"));
+	}
+	return baseline;
+}
+
+int main(int argc, char** argv){
+	Timer timer(true);
+	string filter, out_file = "data/bench_kernels.json", baseline_file;
+	double tolerance = 0.10;
+	for(int i = 1; i + 1 < argc; i += 2){
+		string opt = argv[i];
+		if(opt == "--filter")
+			filter = argv[i+1];
+		else if(opt == "--out")
+			out_file = argv[i+1];
+		else if(opt == "--baseline")
+			baseline_file = argv[i+1];
+		else if(opt == "--tolerance")
+			tolerance = atof(argv[i+1]);
+		else{
+			printf("Unknown option %s.\n", opt.c_str());
+			return 2;
+		}
+	}
+	mkdir("data/", 0755);
+	map<string, pair<double, double> > baseline;
+	if(!baseline_file.empty())
+		baseline = read_json(baseline_file);
+
+	vector<Benchmark> list = benchmarks();
+	vector<Result> results;
+	int regressions = 0;
+	printf("%-52s\t%12s\t%10s\t%14s\t%8s\n", "#benchmark", "ns/step", "new/step", "items/s", "vs.base");
+	for(unsigned int b = 0; b < list.size(); b++){
+		if(list[b].name.find(filter) == string::npos)
+			continue;
+		Result r = measure(list[b]);
+		results.push_back(r);
+		string verdict = "-";
+		if(baseline.count(r.name) > 0){
+			double ratio = r.ns/baseline[r.name].first;
+			char text[32];
+			snprintf(text, sizeof(text), "%.2fx", ratio);
+			verdict = text;
+			if(ratio > 1. + tolerance || r.allocs > baseline[r.name].second + 1e-9){
+				verdict += " SLOWER";
+				if(r.allocs > baseline[r.name].second + 1e-9)
+					verdict = verdict + " (+new)";
+				regressions++;
+			}
+		}
+		printf("%-52s\t%12.1f\t%10.2f\t%14.4g\t%8s\n", r.name.c_str(), r.ns, r.allocs, r.items_per_s, verdict.c_str());
+	}
+	write_json(results, out_file);
+	printf("Results written to %s.\n", out_file.c_str());
+	if(!baseline_file.empty())
+		printf("%d regression(s) against %s (tolerance %g%%).\n", regressions, baseline_file.c_str(), 100.*tolerance);
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,39 @@
+### check if file exists
+file="bench_kernels"
+baseline="data/bench_kernels_baseline.json"
+if [ -f "../$file" ]
+then
+	echo "Remove $file."
+	rm ../$file
+else
+	echo "$file not found."
+fi
+
+cd ..
+### compile c++ code
+if [ "$1" == "all" ] || [ "$1" == "compile" ] || [ "$1" == "run" ] || [ "$1" == "baseline" ] ; then
+echo "Compile."
+g++ test/bench_kernels.cpp src/agent.cpp src/environment.cpp src/simulation.cpp src/controller.cpp src/goal.cpp src/landmark.cpp src/pipe.cpp src/object.cpp src/pin.cpp src/goallearning.cpp src/routelearning.cpp -std=c++11 -o $file -O2 -pthread -larmadillo
+fi
+
+### run program (compared with the stored baseline, if any)
+if [ "$1" == "all" ] || [ "$1" == "run" ] ; then
+echo "Run program."
+if [ -f "$baseline" ]
+then
+	./$file --baseline $baseline ${@:2}
+else
+	./$file ${@:2}
+fi
+fi
+
+### store the results as new baseline
+if [ "$1" == "baseline" ] ; then
+echo "Write baseline."
+./$file --out $baseline ${@:2}
+fi
+
+if [ "$1" = "" ] ; then
+echo "Nothing"
+fi
+echo "Done."
@@ -0,0 +1,113 @@
+/*
+ * bench_landmarks.cpp
+ *
+ * Microbenchmark of RouteLearning::update for K = 10, 50, 250 and 1000
+ * landmark units with one landmark in view at a time and occasional
+ * rewards. The eligibility traces, values and reward signal are compared
+ * every step with the previous dense update of all K units (reproduced
+ * below) for bitwise equality.
+ *
+ */
+
+#include "../src/routelearning.h"
+#include "../src/timer.h"
+#include "bench_common.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+const int numsteps = 20000;
+const int N = 18;
+vector<int> landmarks = {10, 50, 250, 1000};
+
+/// previous dense landmark state of RouteLearning::update
+struct DenseLandmarks {
+	vec raw_lmr, d_raw_lmr, clip_lmr, eligibility_lmr, eligibility_long, value;
+	DenseLandmarks(int K){
+		raw_lmr = zeros<vec>(K);
+		d_raw_lmr = zeros<vec>(K);
+		clip_lmr = zeros<vec>(K);
+		eligibility_lmr = zeros<vec>(K);
+		eligibility_long = zeros<vec>(K);
+		value = zeros<vec>(K);
+	}
+	double update(double in_reward, const vec& input_lmr){
+		d_raw_lmr = -raw_lmr;
+		raw_lmr = input_lmr;
+		d_raw_lmr += raw_lmr;
+		d_raw_lmr *= -1;
+		clip_lmr = d_raw_lmr;
+		clip_lmr.elem( find(clip_lmr < 0.0) ).zeros();
+		clip_lmr.elem( find(clip_lmr > 0.0) ).ones();
+		eligibility_long = 1.0*clip_lmr + 0.995*eligibility_long;
+		eligibility_long.elem( find(raw_lmr > 0.0) ).zeros();
+		eligibility_long.elem( find(eligibility_lmr > 1.0) ).ones();
+		eligibility_lmr = eligibility_long;
+		double emax = arma::max(eligibility_lmr);
+		for(int i = 0; i < eligibility_lmr.n_elem; i++)
+			if(eligibility_lmr(i) < emax)
+				eligibility_lmr(i) = 0.0;
+		value += (in_reward - 0.00001)*eligibility_long - 0.000001*value;
+		value.elem( find(value < 0.0) ).zeros();
+		vec value_new = 1. - exp(-value);
+		return in_reward + as_scalar(value_new.t()*raw_lmr);
+	}
+};
+
+bool same(double a, double b){
+	return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/// landmark in view and reward of step t (one landmark for 20 steps, then 30 steps without)
+void landmark_input(int t, RNG& rng, int K, vec& lmr, int& current, double& reward){
+	if(t % 50 == 0)
+		current = int(rng.uniform(0., K));
+	lmr.zeros();
+	if(t % 50 < 20)
+		lmr(current) = 1.;
+	reward = (t % 700 == 350) ? 1.0 : 0.0;
+}
+
+int main(){
+	Timer timer(true);
+	printf("%6s\t%14s\t%8s\n", "#K", "update[ns]", "bitwise");
+	for(int n = 0; n < landmarks.size(); n++){
+		int K = landmarks[n];
+		double forage = 0.0;
+		vec lmr = zeros<vec>(K);
+		int current = 0;
+		double reward = 0.0;
+
+		/// timed run
+		RouteLearning timed(N, K, 0.0, &forage, false, true);
+		RNG rng_timed(42);
+		auto start = chrono::steady_clock::now();
+		for(int t = 0; t < numsteps; t++){
+			landmark_input(t, rng_timed, K, lmr, current, reward);
+			timed.update(Angle(0.001*t), 1.0, reward, lmr);
+		}
+		double t_update = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/numsteps;
+
+		/// checked run
+		RouteLearning checked(N, K, 0.0, &forage, false, true);
+		DenseLandmarks dense(K);
+		RNG rng_checked(42);
+		bool equal = true;
+		for(int t = 0; t < numsteps; t++){
+			landmark_input(t, rng_checked, K, lmr, current, reward);
+			checked.update(Angle(0.001*t), 1.0, reward, lmr);
+			equal = equal && same(checked.R(), dense.update(reward, lmr));
+			for(int i = 0; i < K; i++){
+				equal = equal && same(checked.el_lm(i), dense.eligibility_lmr(i));
+				equal = equal && same(checked.lv_value(i), dense.value(i));
+				equal = equal && same(checked.cl_state_lm(i), dense.clip_lmr(i));
+			}
+		}
+		printf("%6u\t%14.1f\t%8s\n", K, t_update, check(equal));
+	}
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
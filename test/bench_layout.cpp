@@ -0,0 +1,107 @@
+/*
+ * bench_layout.cpp
+ *
+ * Shared world layouts: one random layout is built once, written and read
+ * back, and shared by a batch of simulations running concurrently. Reported
+ * are the setup time of a simulation with its own random world and with the
+ * shared layout, and whether a simulation on the shared layout moves bitwise
+ * like one whose goals and landmarks are added one by one at the same
+ * positions (own index).
+ *
+ */
+
+#include "bench_common.h"
+#include "../src/batch.h"
+#include "../src/timer.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sys/stat.h>
+using namespace std;
+
+const int numagents = 4;
+const int numgoals = 20;
+const int numlandmarks = 200;
+const double radius = 40.;
+const int numtrials = 3;
+const int numsims = 16;
+const double T = 100.;
+const double dt = 0.1;
+
+void configure(Simulation* sim, uint64_t seed){
+	sim->SILENT = true;
+	learning_agents(sim, numagents, numlandmarks, T, dt, seed);
+}
+
+/// final positions of all agents
+vector<double> final_state(Simulation* sim){
+	sim->run(numtrials, T, dt);
+	vector<double> state;
+	for(int i = 0; i < numagents; i++){
+		state.push_back(sim->a(i)->x());
+		state.push_back(sim->a(i)->y());
+	}
+	return state;
+}
+
+int main(){
+	Timer timer(true);
+	mkdir("data/bench_layout/", 0755);
+
+	/// layout built once, written and read back
+	auto start = chrono::steady_clock::now();
+	shared_ptr<const WorldLayout> built = WorldLayout::random(numgoals, numlandmarks, radius, 1234);
+	double t_build = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	built->save("data/bench_layout/world.layout");
+	shared_ptr<const WorldLayout> world = WorldLayout::load("data/bench_layout/world.layout");
+	bool same_file = world && world->goals().x == built->goals().x && world->goals().y == built->goals().y
+			&& world->landmarks().x == built->landmarks().x && world->landmarks().y == built->landmarks().y;
+
+	/// setup: own random world vs. shared layout
+	make_dirs("data/bench_layout/setup/");
+	start = chrono::steady_clock::now();
+	for(int s = 0; s < numsims; s++)
+		delete new Simulation(numtrials, numagents, true, "data/bench_layout/setup/");
+	double t_random = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count()/numsims;
+	start = chrono::steady_clock::now();
+	for(int s = 0; s < numsims; s++){
+		Simulation* sim = new Simulation(numtrials, numagents, false, "data/bench_layout/setup/");
+		sim->use_layout(world);
+		delete sim;
+	}
+	double t_shared = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count()/numsims;
+
+	/// same positions, own index
+	make_dirs("data/bench_layout/own/");
+	Simulation* sim = new Simulation(numtrials, numagents, false, "data/bench_layout/own/");
+	for(int j = 0; j < world->goals().size(); j++)
+		sim->add_goal(world->goals().x[j], world->goals().y[j]);
+	for(int j = 0; j < world->landmarks().size(); j++)
+		sim->add_landmark(world->landmarks().x[j], world->landmarks().y[j]);
+	configure(sim, 99);
+	vector<double> own = final_state(sim);
+	delete sim;
+
+	/// batch of simulations on the shared layout, the first one with the same seed
+	BatchRunner batch("data/bench_layout/batch/", 5489u);
+	start = chrono::steady_clock::now();
+	vector<vector<double> > shared = batch.run(numsims, [&world](const BatchInstance& inst){
+		Simulation* sim = new Simulation(numtrials, numagents, false, inst.dir);
+		sim->use_layout(world);
+		configure(sim, inst.index == 0 ? 99 : inst.seed);
+		vector<double> state = final_state(sim);
+		delete sim;
+		return state;
+	});
+	double t_batch = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	bool equal = own == shared[0];
+
+	printf("%8s\t%10s\t%10s\t%10s\n", "goals", "landmarks", "build[ms]", "file");
+	printf("%8d\t%10d\t%10.3f\t%10s\n", world->goals().size(), world->landmarks().size(), t_build, check(same_file, "same", "DIFFERENT"));
+	printf("%14s\t%14s\t%12s\t%8s\n", "own setup[ms]", "shared[ms]", "batch[ms]", "bitwise");
+	printf("%14.3f\t%14.3f\t%12.1f\t%8s\n", t_random, t_shared, t_batch, check(equal));
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
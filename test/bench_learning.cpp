@@ -0,0 +1,138 @@
+/*
+ * bench_learning.cpp
+ *
+ * Microbenchmark of the learning kernel (weight update, clipping at zero
+ * and synaptic noise) against the previous implementation with Armadillo
+ * temporaries and find() (reproduced below) for N = 18, 36 and 360 neurons
+ * and K = 1 and 10 weight columns. Heap allocations are counted per step
+ * (operator new and Armadillo's posix_memalign), also for the
+ * update_weights of GoalLearning and RouteLearning in steady state.
+ * Both kernels are driven with identically seeded noise and checked for
+ * bitwise equal weights.
+ *
+ */
+
+#include "../src/goallearning.h"
+#include "../src/routelearning.h"
+#include "../src/timer.h"
+#include "bench_common.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <vector>
+using namespace std;
+
+const int numsteps = 20000;
+const double learn_rate = 0.01;
+vector<int> neurons = {18, 36, 360};
+vector<int> columns = {1, 10};
+vector<double> noise = {0.0, 0.01};
+
+/// heap allocation counter (operator new and aligned allocations of Armadillo)
+static long num_allocs = 0;
+void* operator new(size_t size){
+	num_allocs++;
+	void* p = malloc(size);
+	if(!p)
+		throw bad_alloc();
+	return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+extern "C" void* __libc_memalign(size_t alignment, size_t size);
+extern "C" int posix_memalign(void** p, size_t alignment, size_t size){
+	num_allocs++;
+	*p = __libc_memalign(alignment, size);
+	return *p ? 0 : ENOMEM;
+}
+
+/// previous update_weights (temporaries, find() clipping, noise matrix drawn in any case)
+void legacy_update(mat& white_weights, mat& input_conns, mat& weight_change, const vec& target, double neural_noise, RNG& rng){
+	for(int i = 0; i < input_conns.n_cols; i++){
+		vec diff_act = target - input_conns.col(i);
+		weight_change.col(i) = learn_rate * diff_act;
+	}
+	white_weights += weight_change;
+	white_weights.elem( find(white_weights < 0.0) ).zeros();
+	input_conns = white_weights+rng.randu(input_conns.n_rows, input_conns.n_cols)*neural_noise;
+}
+
+/// fused kernel
+void fused_update(CircArray& ar, mat& white_weights, mat& weight_change, const vec& target, double neural_noise){
+	const mat& w = ar.w_ref();
+	for(int i = 0; i < w.n_cols; i++){
+		const double* wc = w.colptr(i);
+		double* dw = weight_change.colptr(i);
+		for(int j = 0; j < w.n_rows; j++)
+			dw[j] = learn_rate * (target(j) - wc[j]);
+	}
+	ar.apply_weight_change(white_weights, weight_change, neural_noise);
+}
+
+int main(){
+	Timer timer(true);
+	printf("%6s\t%4s\t%6s\t%12s\t%12s\t%8s\t%12s\t%12s\t%8s\n", "#N", "K", "noise", "legacy[ns]", "fused[ns]", "speedup", "legacy[new]", "fused[new]", "bitwise");
+	for(int n = 0; n < neurons.size(); n++)
+	for(int k = 0; k < columns.size(); k++)
+	for(int s = 0; s < noise.size(); s++){
+		int N = neurons[n], K = columns[k];
+		RNG rng_target(99), rng_legacy(1234), rng_fused(1234);
+		vec target(N);
+		for(int i = 0; i < N; i++)
+			target(i) = cos(2.*M_PI*i/N) + rng_target.normal(0.0, 0.1);	// partly negative (clipped)
+
+		mat white_legacy = zeros<mat>(N,K), conns_legacy = zeros<mat>(N,K), dw_legacy = zeros<mat>(N,K);
+		long allocs = num_allocs;
+		auto start = chrono::steady_clock::now();
+		for(int t = 0; t < numsteps; t++)
+			legacy_update(white_legacy, conns_legacy, dw_legacy, target, noise[s], rng_legacy);
+		double t_legacy = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/numsteps;
+		double new_legacy = double(num_allocs - allocs)/numsteps;
+
+		CircArray ar(N,K);
+		ar.set_rng(&rng_fused);
+		mat white_fused = zeros<mat>(N,K), dw_fused = zeros<mat>(N,K);
+		allocs = num_allocs;
+		start = chrono::steady_clock::now();
+		for(int t = 0; t < numsteps; t++)
+			fused_update(ar, white_fused, dw_fused, target, noise[s]);
+		double t_fused = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/numsteps;
+		double new_fused = double(num_allocs - allocs)/numsteps;
+
+		bool equal = memcmp(conns_legacy.memptr(), ar.w_ref().memptr(), N*K*sizeof(double)) == 0;
+		equal = equal && memcmp(white_legacy.memptr(), white_fused.memptr(), N*K*sizeof(double)) == 0;
+		equal = equal && rng_legacy() == rng_fused();
+		printf("%6u\t%4u\t%6g\t%12.1f\t%12.1f\t%8.2f\t%12.2f\t%12.2f\t%8s\n", N, K, noise[s], t_legacy, t_fused, t_legacy/t_fused, new_legacy, new_fused, check(equal));
+	}
+
+	/// allocations of the module kernels in steady state
+	printf("\n%6s\t%16s\t%16s\n", "#N", "GoalLearning[new]", "RouteLearning[new]");
+	for(int n = 0; n < neurons.size(); n++){
+		int N = neurons[n];
+		double forage = 0.0;
+		GoalLearning gl(N, 0.01, &forage, false, true);
+		RouteLearning rl(N, 10, 0.0, &forage, false, true);
+		vec pi_input = ones<vec>(N);
+		vec lmr = zeros<vec>(10);
+		lmr(0) = 1.;
+		gl.update(pi_input, 1.0, 0.0);
+		rl.update(Angle(0.), 1.0, 0.0, lmr);
+		lmr(0) = 0.;
+		rl.update(Angle(0.), 1.0, 1.0, lmr);
+
+		long allocs = num_allocs;
+		for(int t = 0; t < numsteps; t++)
+			gl.update_weights(pi_input);
+		double new_gl = double(num_allocs - allocs)/numsteps;
+		allocs = num_allocs;
+		for(int t = 0; t < numsteps; t++)
+			rl.update_weights();
+		double new_rl = double(num_allocs - allocs)/numsteps;
+		printf("%6u\t%16.2f\t%16.2f\n", N, new_gl, new_rl);
+	}
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
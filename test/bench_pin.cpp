@@ -0,0 +1,92 @@
+/*
+ * bench_pin.cpp
+ *
+ * Microbenchmark of PIN::update against the previous dense-identity
+ * implementation (reproduced below) for N = 18, 36 and 360 neurons.
+ * Both paths are driven with identically seeded noise. The head-direction,
+ * gater and memory layers are checked for bitwise equal rates; the decoding
+ * layer (dense, low-rank or FFT kernel) is compared up to round-off.
+ *
+ */
+
+#include "../src/pin.h"
+#include "../src/timer.h"
+#include "bench_common.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+const int numsteps = 20000;
+const double sens_noise = 0.05;
+const double neur_noise = 0.01;
+const double leakage = 0.0001;
+vector<int> neurons = {18, 36, 360};
+
+/// previous PIN::update (dense identity products), driven through the public API
+void legacy_update(PIN* pin, const mat& w_cos, const vec& pref, Angle angle, double speed){
+	Angle noisy_angle = angle + Angle(2.*M_PI*sens_noise*pin->boost_noise(1.));
+	double noisy_speed = speed + 0.1*sens_noise*pin->boost_noise(1.);
+	if(noisy_speed < 0.0)
+		noisy_speed = 0.0;
+	int N = pref.n_elem;
+	vec input = cos(noisy_angle.rad()*ones<vec>(N) - pref)*(-0.5) + 0.5*ones<vec>(N) + pin->vnoise(N,neur_noise);
+	pin->array(HD)->update_rate(input);
+	pin->array(G)->update_rate(pin->lin_rect(-eye<mat>(N,N)*pin->array(HD)->rate()+(noisy_speed)*ones<vec>(N)));
+	pin->array(M)->update_rate(pin->lin_rect(eye<mat>(N,N)*pin->array(G)->rate() + (1.0-leakage)*eye<mat>(N,N)*pin->array(M)->rate()));
+	pin->array(PI)->update_rate(pin->lin_rect(w_cos * pin->array(M)->rate()));
+	vec out = pin->array(PI)->rate();
+	pin->update_piavg(out);
+	pin->update_pilen(out);
+	pin->set_max(pin->update_max(out), 0);
+}
+
+bool same_bits(const vec& a, const vec& b){
+	return a.n_elem == b.n_elem && memcmp(a.memptr(), b.memptr(), a.n_elem*sizeof(double)) == 0;
+}
+
+int main(){
+	Timer timer(true);
+	printf("%6s\t%14s\t%14s\t%8s\t%8s\t%12s\t%s\n", "#N", "legacy[ns]", "fused[ns]", "speedup", "bitwise", "max|dPI|", "kernel");
+	for(int n = 0; n < neurons.size(); n++){
+		int N = neurons[n];
+		PIN* legacy = new PIN(N, leakage, sens_noise, neur_noise, true);
+		PIN* fused = new PIN(N, leakage, sens_noise, neur_noise, true);
+		RNG rng_legacy(1234), rng_fused(1234), heading(99);
+		legacy->set_rng(&rng_legacy);
+		fused->set_rng(&rng_fused);
+		mat w_cos = legacy->array(PI)->cos_kernel();
+		vec pref(N);
+		for(int i = 0; i < N; i++)
+			pref(i) = 2. * M_PI * i / N;
+
+		/// identical inputs for both paths
+		vector<double> angles(numsteps);
+		for(int t = 0; t < numsteps; t++)
+			angles[t] = heading.uniform(-M_PI, M_PI);
+
+		auto start = chrono::steady_clock::now();
+		for(int t = 0; t < numsteps; t++)
+			legacy_update(legacy, w_cos, pref, Angle(angles[t]), 0.1);
+		double t_legacy = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/numsteps;
+
+		start = chrono::steady_clock::now();
+		for(int t = 0; t < numsteps; t++)
+			fused->update(Angle(angles[t]), 0.1);
+		double t_fused = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/numsteps;
+
+		bool equal = true;
+		for(int layer = HD; layer <= M; layer++)
+			equal = equal && same_bits(legacy->array(layer)->rate(), fused->array(layer)->rate());
+		double dpi = max(abs(legacy->array(PI)->rate() - fused->array(PI)->rate()));
+		const char* kernel_name[] = {"dense", "lowrank", "fft"};
+
+		printf("%6u\t%14.1f\t%14.1f\t%8.2f\t%8s\t%12.3e\t%s\n", N, t_legacy, t_fused, t_legacy/t_fused, check(equal), dpi, kernel_name[fused->kernel_type()]);
+		delete legacy;
+		delete fused;
+	}
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
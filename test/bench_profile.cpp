@@ -0,0 +1,39 @@
+/*
+ * bench_profile.cpp
+ *
+ * Step profile of a population with route learning on a grid of landmarks
+ * (recording and trial data on). Compiled with -DNAVISIM_PROFILE, run()
+ * prints the time spent in each phase of the step and writes one row per
+ * trial to data/bench_profile/data/profile.dat. Compiled without it, the
+ * same run shows the overhead of the probes (ms per step of both builds).
+ *
+ */
+
+#include "bench_common.h"
+#include "../src/timer.h"
+#include <chrono>
+#include <iostream>
+using namespace std;
+
+const int numagents = 64;
+const int numtrials = 5;
+const double T = 100.;
+const double dt = 0.1;
+
+int main(){
+	Timer timer(true);
+	string dir = "data/bench_profile/";
+	make_dirs(dir);
+	Simulation* sim = new Simulation(numtrials, numagents, false, dir);
+	int L = standard_world(sim);
+	learning_agents(sim, numagents, L, T, dt);
+
+	auto start = chrono::steady_clock::now();
+	sim->run(numtrials, T, dt);
+	double ms_per_step = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count()/(numtrials*T/dt);
+	delete sim;
+	printf("%8s\t%10s\n", "probes", "step[ms]");
+	printf("%8s\t%10.4f\n", Profiler::enabled ? "on" : "off", ms_per_step);
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+}
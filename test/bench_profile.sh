@@ -0,0 +1,32 @@
+### check if file exists
+file="bench_profile"
+for f in $file ${file}_off
+do
+if [ -f "../$f" ]
+then
+	echo "Remove $f."
+	rm ../$f
+else
+	echo "$f not found."
+fi
+done
+
+cd ..
+### compile c++ code (with and without probes)
+if [ "$1" == "all" ] || [ "$1" == "compile" ] || [ "$1" == "run" ] ; then
+echo "Compile."
+g++ test/bench_profile.cpp src/agent.cpp src/environment.cpp src/simulation.cpp src/controller.cpp src/goal.cpp src/landmark.cpp src/pipe.cpp src/object.cpp src/pin.cpp src/goallearning.cpp src/routelearning.cpp -std=c++11 -o $file -O2 -pthread -DNAVISIM_PROFILE -larmadillo
+g++ test/bench_profile.cpp src/agent.cpp src/environment.cpp src/simulation.cpp src/controller.cpp src/goal.cpp src/landmark.cpp src/pipe.cpp src/object.cpp src/pin.cpp src/goallearning.cpp src/routelearning.cpp -std=c++11 -o ${file}_off -O2 -pthread -larmadillo
+fi
+
+### run program
+if [ "$1" == "all" ] || [ "$1" == "run" ] ; then
+echo "Run program."
+./$file
+./${file}_off | tail -n 3
+fi
+
+if [ "$1" = "" ] ; then
+echo "Nothing"
+fi
+echo "Done."
@@ -0,0 +1,160 @@
+/*
+ * bench_sampling.cpp
+ *
+ * Sampling policies of the trace output. The same simulation (route
+ * learning on 81 landmarks) is run with the default interval and with
+ * per-stream policies: a coarser interval, event-triggered samples only,
+ * the first and last K steps of each trial, and K trials chosen by
+ * reservoir sampling. Reported are the rows of agent.dat, the bytes of all
+ * per-sample streams, and a check of each policy: first/last rows match
+ * the trial length (trialtimes.dat), only K distinct trials are written,
+ * and the writer thread gives the same files.
+ *
+ */
+
+#include "bench_common.h"
+#include "../src/timer.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <vector>
+#include <sys/stat.h>
+using namespace std;
+
+const int numtrials = 10;
+const double T = 300.;
+const double dt = 0.1;
+const int K = 10;
+const char* files[] = {"agent", "lmattract", "homevector", "globalvector", "refvector", "localvector", "lv_eligtraces",
+		"lv_learning", "reward", "l_scale", "signals", "lmr_signals", "lmr_angles", "adaptive_expl"};
+
+void run(const string& dir, const map<string, SamplingPolicy>& policies, int async){
+	make_dirs(dir);
+	Simulation* sim = new Simulation(numtrials, 1, false, dir);
+	int L = standard_world(sim, 2);
+	sim->trace_async(async);
+	for(auto& p : policies)
+		sim->sampling(p.first, p.second);
+	learning_agents(sim, 1, L, T, dt);
+	sim->run(numtrials, T, dt);
+	delete sim;
+}
+
+/// rows of a text trace (trial, trial_t of the first two columns)
+vector<pair<int, double> > read_rows(const string& filename){
+	vector<pair<int, double> > rows;
+	istringstream in(read_file(filename));
+	string line;
+	while(getline(in, line)){
+		if(line.empty() || line[0] == '#')
+			continue;
+		int trial;
+		double t;
+		istringstream(line) >> trial >> t;
+		rows.push_back(make_pair(trial, t));
+	}
+	return rows;
+}
+
+/// trial number -> duration
+map<int, double> read_durations(const string& dir){
+	map<int, double> d;
+	istringstream in(read_file(dir + "data/trialtimes.dat"));
+	int trial;
+	double start, end, duration;
+	while(in >> trial >> start >> end >> duration)
+		d[trial] = duration;
+	return d;
+}
+
+long trace_bytes(const string& dir){
+	long bytes = 0;
+	for(const char* f : files)
+		bytes += read_file(dir + "data/" + f + ".dat").size();
+	return bytes;
+}
+
+/// first K rows of each trial are steps 0..K-1, last K rows end at the last step of the trial
+bool check_first_last(const string& dir){
+	vector<pair<int, double> > rows = read_rows(dir + "data/agent.dat");
+	map<int, double> durations = read_durations(dir);
+	map<int, vector<double> > per_trial;
+	for(auto& r : rows)
+		per_trial[r.first].push_back(r.second);
+	if((int) per_trial.size() != numtrials)
+		return false;
+	for(auto& p : per_trial){
+		int steps = int(durations[p.first]/dt + 0.5);
+		const vector<double>& t = p.second;
+		if((int) t.size() != min(2*K, steps))
+			return false;
+		for(int k = 0; k < K && k < steps; k++)
+			if(fabs(t[k] - k*dt) > 1e-6)
+				return false;
+		if(fabs(t.back() - (steps-1)*dt) > 1e-6)
+			return false;
+	}
+	return true;
+}
+
+set<int> trials_written(const string& dir){
+	set<int> trials;
+	for(auto& r : read_rows(dir + "data/agent.dat"))
+		trials.insert(r.first);
+	return trials;
+}
+
+int main(){
+	Timer timer(true);
+	mkdir("data/bench_sampling/", 0755);
+	string base = "data/bench_sampling/";
+	map<string, SamplingPolicy> none;
+
+	SamplingPolicy coarse(50);
+	SamplingPolicy events(0);
+	events.on(event_goal | event_landmark | event_home | event_pipe);
+	SamplingPolicy window(0);
+	window.first(K);
+	window.last(K);
+	SamplingPolicy reservoir;
+	reservoir.trials(3);
+	SamplingPolicy mixed(100);
+	mixed.on(event_goal | event_home);
+	mixed.last(K);
+
+	run(base + "default/", none, async_off);
+	run(base + "coarse/", {{"", coarse}}, async_off);
+	run(base + "events/", {{"", events}}, async_off);
+	run(base + "window/", {{"", window}}, async_off);
+	run(base + "reservoir/", {{"", reservoir}}, async_off);
+	run(base + "reservoir2/", {{"", reservoir}}, async_off);
+	run(base + "mixed/", {{"", mixed}, {"lmr_signals", SamplingPolicy(0)}}, async_off);
+	run(base + "mixed_async/", {{"", mixed}, {"lmr_signals", SamplingPolicy(0)}}, async_block);
+
+	bool same_async = true;
+	for(const char* f : files)
+		same_async = same_async && read_file(base + "mixed/data/" + f + ".dat") == read_file(base + "mixed_async/data/" + f + ".dat");
+	set<int> chosen = trials_written(base + "reservoir/");
+	string chosen_str;
+	for(int t : chosen)
+		chosen_str += to_string(t) + " ";
+
+	const char* names[] = {"default", "coarse", "events", "window", "reservoir", "mixed"};
+	string checks[] = {"-", "-", "-", check(check_first_last(base + "window/"), "first/last ok", "FIRST/LAST WRONG"),
+			string(check(chosen.size() == 3 && chosen == trials_written(base + "reservoir2/"), "trials ", "TRIALS WRONG")) + chosen_str,
+			check(same_async, "async same", "ASYNC DIFFERENT")};
+	long bytes0 = trace_bytes(base + "default/");
+	printf("%10s\t%10s\t%12s\t%10s\t%s\n", "#policy", "agent rows", "bytes", "ratio", "check");
+	for(int p = 0; p < 6; p++){
+		long bytes = trace_bytes(base + names[p] + "/");
+		printf("%10s\t%10lu\t%12ld\t%10.4f\t%s\n", names[p], read_rows(base + names[p] + "/data/agent.dat").size(),
+				bytes, double(bytes)/bytes0, checks[p].c_str());
+	}
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
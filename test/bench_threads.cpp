@@ -0,0 +1,96 @@
+/*
+ * bench_threads.cpp
+ *
+ * Scaling benchmark of the multi-threaded agent update for 1 to 64
+ * threads. The same population (numagents agents, fixed goals and
+ * landmarks, same master seed) is simulated with every thread count;
+ * final positions and headings of all agents and the remaining goal
+ * amounts are checked for bitwise equality with the 1-thread run.
+ * Goals decay with every visit and lie around home, where many agents
+ * collect from the same goal in one step, so the result depends on the
+ * order of depletion. Returns 1 if any thread count differs.
+ *
+ */
+
+#include "bench_common.h"
+#include "../src/timer.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sys/stat.h>
+using namespace std;
+
+const int numagents = 512;
+const int numtrials = 10;
+const double T = 20.;
+const double dt = 0.1;
+const int numgoals = 12;
+vector<int> num_threads = {1, 2, 4, 8, 16, 32, 64};
+
+/// final state of all agents and goals
+vector<double> run_population(int threads, double& ms_per_step, int& depleted){
+	char dir[64];
+	mkdir("data/bench_threads/", 0755);
+	snprintf(dir, sizeof(dir), "data/bench_threads/%02d/", threads);
+	make_dirs(dir);
+	Simulation* sim = new Simulation(numtrials, numagents, false, dir);
+	sim->SILENT = true;
+	/// decaying goals on two rings around home
+	for(int j = 0; j < numgoals; j++){
+		double r = (j%2 == 0) ? 0.4 : 0.8;
+		double a = 2.*M_PI*j/numgoals;
+		sim->add_goal(r*cos(a), r*sin(a), 0, 1., true);
+	}
+	sim->add_landmark(2., 2.);
+	sim->add_landmark(-2., 3.);
+	sim->homing(true);
+	sim->gvlearn(true);
+	sim->lvlearn(false);
+	sim->beta(true);
+	sim->seed(1234);
+	sim->init_controller(18, 1, 1, 0.05, 0.01, 0.0, 0.0);
+	for(int i = 0; i < numagents; i++)
+		sim->c(i)->set_inward(int(0.5*T/dt));
+	sim->threads(threads);
+
+	auto start = chrono::steady_clock::now();
+	sim->run(numtrials, T, dt);
+	ms_per_step = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count()/(numtrials*T/dt);
+
+	vector<double> state;
+	for(int i = 0; i < numagents; i++){
+		state.push_back(sim->a(i)->x());
+		state.push_back(sim->a(i)->y());
+		state.push_back(sim->a(i)->phi().rad());
+	}
+	depleted = 0;
+	for(int j = 0; j < numgoals; j++){
+		state.push_back(sim->e()->g(j)->a());
+		if(sim->e()->g(j)->a() < 1.)
+			depleted++;
+	}
+	delete sim;
+	return state;
+}
+
+int main(){
+	Timer timer(true);
+	printf("%8s\t%14s\t%8s\t%8s\t%8s\n", "#threads", "step[ms]", "speedup", "depleted", "bitwise");
+	double t_ref = 0.;
+	vector<double> ref;
+	for(int n = 0; n < num_threads.size(); n++){
+		double t_step;
+		int depleted;
+		vector<double> state = run_population(num_threads[n], t_step, depleted);
+		if(n == 0){
+			ref = state;
+			t_ref = t_step;
+		}
+		bool equal = state.size() == ref.size() && memcmp(state.data(), ref.data(), state.size()*sizeof(double)) == 0;
+		printf("%8u\t%14.3f\t%8.2f\t%8d\t%8s\n", num_threads[n], t_step, t_ref/t_step, depleted, check(equal));
+	}
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
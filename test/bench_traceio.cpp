@@ -0,0 +1,106 @@
+/*
+ * bench_traceio.cpp
+ *
+ * Asynchronous trace output. A simulation with route learning on 81
+ * landmarks writes every sample, once with synchronous output and once
+ * with the writer thread (async_block); reported are the run times and
+ * whether both wrote the same files. A single stream of 20 columns then
+ * writes 10^6 rows: time of the producer (simulation thread) for direct
+ * writing, with the writer thread, and with a small buffer that drops rows
+ * (async_drop).
+ *
+ */
+
+#include "bench_common.h"
+#include "../src/timer.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include <sys/stat.h>
+using namespace std;
+
+const int numagents = 1;
+const int numtrials = 4;
+const double T = 300.;
+const double dt = 0.1;
+const int numrows = 1000000;
+const int numcols = 20;
+
+double run(const string& dir, int policy){
+	make_dirs(dir);
+	Simulation* sim = new Simulation(numtrials, numagents, false, dir);
+	int L = standard_world(sim, 2);
+	sim->trace_async(policy);
+	learning_agents(sim, numagents, L, T, dt);
+	auto start = chrono::steady_clock::now();
+	sim->run(numtrials, T, dt);
+	delete sim;
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/// producer time of numrows rows [ms]; rows dropped in dropped
+double stream(const string& filename, TraceWriter* writer, long& dropped){
+	TraceStream out;
+	out.open(filename);
+	for(int c = 0; c < numcols; c++)
+		out.column("c" + to_string(c));
+	if(writer)
+		out.async(writer);
+	auto start = chrono::steady_clock::now();
+	for(int r = 0; r < numrows; r++){
+		for(int c = 0; c < numcols; c++)
+			out << 0.001*r + c;
+		out.end_row();
+	}
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	out.close();
+	dropped = writer ? writer->dropped() : 0;
+	return ms;
+}
+
+long count_lines(const string& filename){
+	string text = read_file(filename);
+	long n = 0;
+	for(unsigned int i = 0; i < text.size(); i++)
+		n += (text[i] == '\n');
+	return n;
+}
+
+int main(){
+	Timer timer(true);
+	mkdir("data/bench_traceio/", 0755);
+
+	/// simulation: synchronous vs. writer thread
+	double t_sync = run("data/bench_traceio/sync/", async_off);
+	double t_async = run("data/bench_traceio/async/", async_block);
+	const char* files[] = {"agent.dat", "endpoints.dat", "homevector.dat", "globalvector.dat", "localvector.dat",
+			"lmr_signals.dat", "lv_eligtraces.dat", "reward.dat", "trialtimes.dat", "performgvl.dat"};
+	bool equal = true;
+	for(const char* f : files){
+		string a = read_file(string("data/bench_traceio/sync/data/") + f);
+		string b = read_file(string("data/bench_traceio/async/data/") + f);
+		equal = equal && a.size() > 0 && a == b;
+	}
+
+	/// single stream: direct, writer thread, small buffer dropping rows
+	long dropped;
+	double s_sync = stream("data/bench_traceio/stream_sync", nullptr, dropped);
+	TraceWriter* writer = new TraceWriter(async_block);
+	double s_async = stream("data/bench_traceio/stream_async", writer, dropped);
+	delete writer;
+	writer = new TraceWriter(async_drop, 256);
+	double s_drop = stream("data/bench_traceio/stream_drop", writer, dropped);
+	delete writer;
+	long written = count_lines("data/bench_traceio/stream_drop.dat");
+
+	printf("%12s\t%12s\t%8s\n", "sync[ms]", "async[ms]", "files");
+	printf("%12.1f\t%12.1f\t%8s\n", t_sync, t_async, check(equal, "same", "DIFFERENT"));
+	printf("%12s\t%12s\t%12s\t%10s\t%10s\n", "stream[ms]", "async[ms]", "drop[ms]", "dropped", "written");
+	printf("%12.1f\t%12.1f\t%12.1f\t%10ld\t%10ld\n", s_sync, s_async, s_drop, dropped, written);
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
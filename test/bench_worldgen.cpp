@@ -0,0 +1,132 @@
+/*
+ * bench_worldgen.cpp
+ *
+ * Random world generation: the former rejection sampling (one heap-allocated
+ * Goal/Landmark per candidate, each tested against all objects placed so
+ * far) against the Poisson disk sampling of WorldLayout::random and the
+ * placement of one object at a time (Environment::add_goal/add_landmark
+ * with a radius), for increasing densities up to a world that cannot hold
+ * all landmarks.
+ * Reported are the objects placed, the time, and the smallest distances
+ * between goals, goals and landmarks, and landmarks (minimum 3, 0.5, 1).
+ *
+ */
+
+#include "bench_common.h"
+#include "../src/worldlayout.h"
+#include "../src/timer.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+const int max_tries = 10000;		// candidates per object of the rejection sampling
+
+struct World {
+	vector<double> gx, gy, lx, ly;
+};
+
+/// former Environment::add_goal/add_landmark(max_radius), stopped after max_tries candidates per object
+World rejection(int num_goals, int num_landmarks, double radius){
+	World w;
+	for(int i = 0; i < num_goals; i++){
+		int tries = 0;
+		while(tries++ < max_tries){
+			Goal* goal = new Goal(radius);
+			bool fits = true;
+			for(unsigned int j = 0; j < w.gx.size() && fits; j++)
+				fits = hypot(goal->x() - w.gx[j], goal->y() - w.gy[j]) > 3.;
+			if(fits){
+				w.gx.push_back(goal->x());
+				w.gy.push_back(goal->y());
+			}
+			delete goal;
+			if(fits)
+				break;
+		}
+	}
+	for(int i = 0; i < num_landmarks; i++){
+		int tries = 0;
+		while(tries++ < max_tries){
+			Landmark* lm = new Landmark(radius);
+			bool fits = true;
+			for(unsigned int j = 0; j < w.gx.size() && fits; j++)
+				fits = hypot(lm->x() - w.gx[j], lm->y() - w.gy[j]) > .5;
+			for(unsigned int j = 0; j < w.lx.size() && fits; j++)
+				fits = hypot(lm->x() - w.lx[j], lm->y() - w.ly[j]) > 1.;
+			if(fits){
+				w.lx.push_back(lm->x());
+				w.ly.push_back(lm->y());
+			}
+			delete lm;
+			if(fits)
+				break;
+		}
+	}
+	return w;
+}
+
+World poisson(int num_goals, int num_landmarks, double radius){
+	shared_ptr<const WorldLayout> layout = WorldLayout::random(num_goals, num_landmarks, radius, 1234);
+	World w;
+	w.gx = layout->goals().x;
+	w.gy = layout->goals().y;
+	w.lx = layout->landmarks().x;
+	w.ly = layout->landmarks().y;
+	return w;
+}
+
+World incremental(int num_goals, int num_landmarks, double radius){
+	Environment env(1, "./", 1234);
+	for(int i = 0; i < num_goals; i++)
+		env.add_goal(radius);
+	for(int i = 0; i < num_landmarks; i++)
+		env.add_landmark(radius);
+	World w;
+	for(int i = 0; i < env.n_goals(); i++){
+		w.gx.push_back(env.g(i)->x());
+		w.gy.push_back(env.g(i)->y());
+	}
+	for(int i = 0; i < env.n_landmarks(); i++){
+		w.lx.push_back(env.l(i)->x());
+		w.ly.push_back(env.l(i)->y());
+	}
+	return w;
+}
+
+double min_dist(const vector<double>& ax, const vector<double>& ay, const vector<double>& bx, const vector<double>& by, bool same){
+	double m = 1e9;
+	for(unsigned int i = 0; i < ax.size(); i++)
+		for(unsigned int j = same ? i+1 : 0; j < bx.size(); j++)
+			m = min(m, hypot(ax[i] - bx[j], ay[i] - by[j]));
+	return m;
+}
+
+void report(const char* method, int goals, int landmarks, double radius, World (*generate)(int, int, double)){
+	auto start = chrono::steady_clock::now();
+	World w = generate(goals, landmarks, radius);
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	double gg = min_dist(w.gx, w.gy, w.gx, w.gy, true);
+	double gl = min_dist(w.gx, w.gy, w.lx, w.ly, false);
+	double ll = min_dist(w.lx, w.ly, w.lx, w.ly, true);
+	bool valid = gg > 3. && gl > .5 && ll > 1.;
+	printf("%6d\t%6d\t%6g\t%10s\t%6lu\t%6lu\t%10.2f\t%6.3f\t%6.3f\t%6.3f\t%6s\n", goals, landmarks, radius, method,
+			w.gx.size(), w.lx.size(), ms, gg, gl, ll, check(valid));
+}
+
+int main(){
+	Timer timer(true);
+	int cases[][3] = {{10, 10, 25}, {20, 200, 40}, {40, 1000, 40}, {60, 2500, 40}, {60, 6000, 40}};
+	printf("%6s\t%6s\t%6s\t%10s\t%6s\t%6s\t%10s\t%6s\t%6s\t%6s\t%6s\n", "#goals", "#lms", "radius", "method",
+			"goals", "lms", "time[ms]", "g-g", "g-lm", "lm-lm", "valid");
+	for(auto& c : cases){
+		if(c[1] <= 2500)
+			report("rejection", c[0], c[1], c[2], rejection);
+		report("poisson", c[0], c[1], c[2], poisson);
+		if(c[1] <= 2500)
+			report("one-by-one", c[0], c[1], c[2], incremental);
+	}
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+	return bench_status();
+}
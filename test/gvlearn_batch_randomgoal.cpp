@@ -0,0 +1,121 @@
+/*
+ * gvlearn_batch_randomgoal.cpp
+ *
+ * Same experiment as gvlearn_multimulti_randomgoal.cpp with numcycles
+ * independent cycles run in parallel by the BatchRunner. Every cycle
+ * writes into data/batch/<cycle>/ and is seeded from the batch seed;
+ * statistics are merged in cycle order after all cycles have finished.
+ *
+ */
+
+#include "../src/simulation.h"
+#include "../src/batch.h"
+#include "../src/timer.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+using namespace std;
+
+const int numagents= 1;
+const int numtrials= 1000;
+const double T= 300.;
+const double Thome= 200.;
+const double dt= 0.1;
+const int numcycles = 100;
+const uint64_t batch_seed = 5489u;
+
+struct CycleResult {
+	vector<double> expl_rate;
+	vector<double> home_rate;
+	vector<double> goal_rate;
+	double R_ratio;
+	int trial_converge;
+};
+
+CycleResult run_cycle(const BatchInstance& inst){
+	CycleResult result;
+	Simulation* sim = new Simulation(numtrials, numagents, true, inst.dir);
+	sim->SILENT = true;
+	sim->homing(true);
+	sim->gvlearn(true);
+	sim->beta(true);
+	sim->lvlearn(false);
+	sim->seed(inst.seed);
+	sim->init_controller(18, 1, 1, 0.05, 0.0, 0.00, 0.0);
+	sim->set_inward(int(Thome/dt));
+	sim->run(numtrials, T, dt);
+	result.expl_rate = sim->expl_rate;
+	result.home_rate = sim->home_rate;
+	result.goal_rate = sim->goal_rate;
+	result.R_ratio = sim->e()->nearest()->d()/sim->c(0)->GV(0).len();
+	if(result.R_ratio > 1)
+		result.R_ratio = 1;
+	result.trial_converge = sim->trial_converge;
+	delete sim;
+	return result;
+}
+
+int main(){
+	Timer timer(true);
+	vector< running_stat<double> > expl_rate(numtrials);
+	vector< running_stat<double> > home_rate(numtrials);
+	vector< running_stat<double> > goal_rate(numtrials);
+	running_stat<double> stat_ratio;
+	running_stat<double> trial_converge;
+
+	BatchRunner batch("data/batch/", batch_seed);
+	printf("Run %u cycles on %u threads.\n", numcycles, batch.num_threads());
+	vector<CycleResult> results = batch.run(numcycles, run_cycle);
+
+	ofstream stat_cycles("data/stat_cycles.dat");
+	stat_cycles.width(12);
+	stat_cycles << "#Cycle\t#RatioMean\t#RatioSTD\t#TimeMean\t#TimeSTD\t#ConvergRate\n";
+	stat_cycles << fixed;
+	for(unsigned int cycle = 1; cycle < numcycles+1; cycle++){
+		const CycleResult& result = results.at(cycle-1);
+		for(unsigned int trial = 0; trial < numtrials; trial++){
+			expl_rate.at(trial)(result.expl_rate.at(trial));
+			home_rate.at(trial)(result.home_rate.at(trial));
+			goal_rate.at(trial)(result.goal_rate.at(trial));
+		}
+		if(result.trial_converge != 0){
+			trial_converge(result.trial_converge);
+			stat_ratio(result.R_ratio);
+		}
+		stat_cycles << setprecision(0) << cycle               << "\t";
+		stat_cycles << setprecision(6) << stat_ratio.mean()   << "\t";
+		stat_cycles << setprecision(6) << stat_ratio.stddev() << "\t";
+		stat_cycles << setprecision(6) << trial_converge.mean() << "\t";
+		stat_cycles << setprecision(6) << trial_converge.stddev() << "\t";
+		stat_cycles << setprecision(6) << 1.0*trial_converge.count()/(1.*cycle) << "\n";
+	}
+	stat_cycles.close();
+
+	ofstream multi_cycletrials("data/m_cycles_trials.dat");
+	multi_cycletrials.width(10);
+	multi_cycletrials << "#Trial\t#ExplMean\t#ExplSTD\t#HomeMean\t#HomeSTD\t#GoalMean\t#GoalSTD\n";
+	multi_cycletrials << fixed;
+	for(unsigned int trial = 0; trial < numtrials; trial++){
+		multi_cycletrials << setprecision(0) << trial+1 << "\t";
+		multi_cycletrials << setprecision(6) << expl_rate.at(trial).mean()   << "\t";
+		multi_cycletrials << setprecision(6) << expl_rate.at(trial).stddev() << "\t";
+		multi_cycletrials << setprecision(6) << home_rate.at(trial).mean()   << "\t";
+		multi_cycletrials << setprecision(6) << home_rate.at(trial).stddev() << "\t";
+		multi_cycletrials << setprecision(6) << goal_rate.at(trial).mean()   << "\t";
+		multi_cycletrials << setprecision(6) << goal_rate.at(trial).stddev() << "\n";
+	}
+	multi_cycletrials.close();
+
+	printf("==========================================================================================================\n");
+	printf("Mean ratio = %1.4f +- %1.4f, mean trials for convergence = %2.4f +- %2.4f, convergence rate = %1.4f\n",
+			stat_ratio.mean(),
+			stat_ratio.stddev(),
+			trial_converge.mean(),
+			trial_converge.stddev(),
+			1.0*trial_converge.count()/(1.*numcycles)
+			);
+	printf("==========================================================================================================\n\n");
+
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+}
@@ -0,0 +1,63 @@
+/*
+ * run_experiment.cpp
+ *
+ * Runs an experiment specification (see src/experiment.h): all grid points
+ * and cycles are simulated concurrently, every instance writes into
+ * <out>/<index>/, and the summary is written to <out>/sweep.dat. Further
+ * arguments "key=value" override single keys of the file.
+ *
+ *  usage: run_experiment <spec.cfg> [key=value ...]
+ *
+ */
+
+#include "../src/experiment.h"
+#include "../src/timer.h"
+#include <iostream>
+#include <vector>
+using namespace std;
+
+int main(int argc, char** argv){
+	Timer timer(true);
+	if(argc < 2){
+		printf("usage: %s <spec.cfg> [key=value ...]\n", argv[0]);
+		return 2;
+	}
+	ExperimentSpec spec;
+	if(!spec.load(argv[1]))
+		return 1;
+	for(int i = 2; i < argc; i++){
+		string arg = argv[i];
+		size_t eq = arg.find('=');
+		if(eq == string::npos || !spec.set(arg.substr(0, eq), arg.substr(eq + 1))){
+			printf("WARNING: invalid argument %s.\n", argv[i]);
+			return 1;
+		}
+	}
+	mkdir(spec.out.c_str(), 0755);
+
+	Sweep sweep(spec);
+	vector<SweepResult> results = sweep.run();
+
+	/// mean over cycles of each grid point
+	printf("%6s", "#point");
+	for(unsigned int a = 0; a < spec.axis_keys.size(); a++)
+		printf("\t%14s", spec.axis_keys[a].c_str());
+	printf("\t%8s\t%10s\t%10s\t%10s\n", "expl", "home_rate", "goal_rate", "pi_error");
+	for(int p = 0; p < spec.num_points(); p++){
+		running_stat<double> expl, home, goal, error;
+		for(unsigned int i = 0; i < results.size(); i++)
+			if(results[i].point == p){
+				expl(results[i].expl);
+				home(results[i].home_rate);
+				goal(results[i].goal_rate);
+				error(results[i].pi_error);
+			}
+		printf("%6d", p);
+		for(unsigned int a = 0; a < spec.axis_keys.size(); a++)
+			printf("\t%14s", spec.value(p, a).c_str());
+		printf("\t%8.4f\t%10.4f\t%10.4f\t%10.4f\n", expl.mean(), home.mean(), goal.mean(), error.mean());
+	}
+	printf("Results written to %ssweep.dat.\n", spec.out.c_str());
+	auto elapsed_secs_cl = timer.Elapsed();
+	printf("%4.3f s. Done.\n", elapsed_secs_cl.count()/1000.);
+}
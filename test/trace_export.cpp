@@ -0,0 +1,107 @@
+/*
+ * trace_export.cpp
+ *
+ * Converts binary trace files (.trc) written in trace_binary mode to the
+ * text layout of the .dat files (e.g. ./trace_export data/agent.trc). Without
+ * arguments it writes a test stream in both modes, checks that the
+ * exported text is identical to the text mode (and to the former ostream
+ * output) and reports the write time per row.
+ *
+ */
+
+#include "../src/trace.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+using namespace std;
+
+const int numrows = 200000;
+
+string read_file(const string& filename){
+	ifstream in(filename.c_str(), ios::in | ios::binary);
+	stringstream buf;
+	buf << in.rdbuf();
+	return buf.str();
+}
+
+void schema(TraceStream& out){
+	out.comment("#Trial\t#Global_t\t#X\t#Y");
+	out.column("trial", col_int);
+	out.column("trial_t");
+	out.column("x");
+	out.column("y");
+	out.column("global_t", col_fixed, 1);
+	out.column("phi", col_general, 6, "");
+}
+
+double write_trace(const string& path, int mode){
+	mt19937 gen(1);
+	normal_distribution<double> dist(0., 10.);
+	TraceStream out;
+	out.open(path, mode);
+	schema(out);
+	auto start = chrono::steady_clock::now();
+	for(int r = 0; r < numrows; r++){
+		double x = dist(gen), y = dist(gen);
+		out << r/100 << 0.1*(r%100) << x << y << 0.1*r << dist(gen)*1e-4;
+		out.end_row();
+	}
+	out.close();
+	return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/numrows;
+}
+
+double write_ostream(const string& filename){
+	mt19937 gen(1);
+	normal_distribution<double> dist(0., 10.);
+	ofstream out(filename.c_str());
+	out << "#Trial\t#Global_t\t#X\t#Y\n";
+	auto start = chrono::steady_clock::now();
+	for(int r = 0; r < numrows; r++){
+		double x = dist(gen), y = dist(gen), phi;
+		out << r/100 << "\t" << 0.1*(r%100) << "\t" << x << "\t" << y << "\t";
+		out << fixed << setprecision(1) << 0.1*r << "\t";
+		out.unsetf(ios::floatfield);
+		out << setprecision(6);
+		phi = dist(gen)*1e-4;
+		out << phi << endl;
+	}
+	out.close();
+	return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()/numrows;
+}
+
+int main(int argc, char* argv[]){
+	if(argc > 1){
+		for(int i = 1; i < argc; i++){
+			string in = argv[i];
+			string out = in.substr(0, in.rfind(".trc")) + ".dat";
+			TraceReader reader;
+			if(!reader.open(in) || !reader.export_text(out)){
+				printf("%s: not a valid trace file\n", in.c_str());
+				return 1;
+			}
+			printf("%s -> %s (%u columns)\n", in.c_str(), out.c_str(), (unsigned int) reader.columns.size());
+		}
+		return 0;
+	}
+
+	double t_ostream = write_ostream("trace_test_ostream.dat");
+	double t_text = write_trace("trace_test_text", trace_text);
+	double t_binary = write_trace("trace_test", trace_binary);
+	TraceReader reader;
+	bool ok = reader.open("trace_test.trc") && reader.export_text("trace_test.dat");
+	string ref = read_file("trace_test_ostream.dat");
+	bool same_text = ok && read_file("trace_test_text.dat") == ref;
+	bool same_export = ok && read_file("trace_test.dat") == ref;
+	printf("ostream+endl:  %7.1f ns/row\n", t_ostream);
+	printf("trace text:    %7.1f ns/row\t%s\n", t_text, same_text ? "identical" : "DIFFERENT");
+	printf("trace binary:  %7.1f ns/row\t%s (after export)\n", t_binary, same_export ? "identical" : "DIFFERENT");
+	remove("trace_test_ostream.dat");
+	remove("trace_test_text.dat");
+	remove("trace_test.dat");
+	remove("trace_test.trc");
+	return (same_text && same_export) ? 0 : 1;
+}